@@ -0,0 +1,55 @@
+#ifndef _CONFIG_MENU_H
+#define _CONFIG_MENU_H
+
+#include <Arduino.h>
+#include "OperationState.h"
+
+// Indicator colors are packed 0xRRGGBB, as Adafruit_NeoPixel::Color()
+// returns them, but usable in a PROGMEM initializer
+#define MENU_COLOR(r, g, b) (((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+#define MENU_INDICATOR_NONE 0   // leave the indicator LED as the action left it
+
+// What the operation state machine reacts to
+typedef enum e_menu_event {
+    MENU_EVENT_CLICK,
+    MENU_EVENT_LONG_CLICK,
+    MENU_EVENT_TIMEOUT,     // a config menu item ran its time without a click
+    MENU_EVENT_COUNT
+} eMenuEvent;
+
+// One row of the transition table (kept in flash).  On event in state the
+// dispatcher moves to next_state, runs action and then shows indicator on
+// the first port nav LED, unless the action returns false because it shows
+// the indicator itself (e.g. blinking in that color).
+typedef struct s_menu_transition {
+    uint8_t state;          // eOperationState
+    uint8_t event;          // eMenuEvent
+    uint8_t next_state;     // eOperationState (the same for a self transition)
+    uint8_t arg;            // for the action, e.g. an eSegmentRole
+    uint32_t indicator;     // MENU_COLOR() or MENU_INDICATOR_NONE
+    bool (*action)(const struct s_menu_transition *transition);   // NULL = none
+} sMenuTransition;
+
+// The transition for event in state, copied out of the PROGMEM table, or
+// false if there is none
+inline bool menu_transition_find(const sMenuTransition *table, uint8_t count,
+        uint8_t state, uint8_t event, sMenuTransition *transition)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        memcpy_P(transition, &table[i], sizeof(*transition));
+
+        if (transition->state == state && transition->event == event)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// The firmware's transition table (main.cpp)
+extern const sMenuTransition menu_transitions[];
+extern const uint8_t menu_transition_count;
+
+#endif /* _CONFIG_MENU_H */
@@ -0,0 +1,30 @@
+#ifndef _CRC16_H
+#define _CRC16_H
+
+#include <Arduino.h>
+
+// CRC-16/CCITT (reflected, polynomial 0x8408), one byte at a time without a
+// table; the same formula as avr-libc's _crc_ccitt_update()
+inline uint16_t crc16_update(uint16_t crc, uint8_t data)
+{
+    data ^= (uint8_t)crc;
+    data ^= data << 4;
+
+    return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+// CRC of a block, starting from the usual 0xFFFF
+inline uint16_t crc16(const void *buffer, uint16_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)buffer;
+    uint16_t crc = 0xFFFF;
+
+    while (length--)
+    {
+        crc = crc16_update(crc, *bytes++);
+    }
+
+    return crc;
+}
+
+#endif /* _CRC16_H */
@@ -0,0 +1,175 @@
+#ifndef _EEPROM_RECORD_STORE_H
+#define _EEPROM_RECORD_STORE_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "Crc16.h"
+
+// Header of every stored record
+typedef struct s_eeprom_record_header {
+    uint16_t sequence;   // increments on every save; the highest valid one wins
+    uint8_t version;     // layout version of the payload (0xFF = erased slot)
+    uint8_t length;      // payload bytes in use
+} sEepromRecordHeader;
+
+// EepromRecordStore Class - keeps one small record (a packed settings
+// struct) in EEPROM.  Saves rotate through SlotCount slots of SlotSize
+// bytes starting at BaseAddress, which spreads the wear, and each slot
+// carries a sequence number and a CRC.  A save only ever overwrites the
+// oldest slot, so a brown-out part way through leaves a slot with a bad CRC
+// and Load() falls back to the previous record: either all of the new
+// settings are kept or none are.
+//
+// The version and length are stored so that a newer firmware can read an
+// older record: Load() copies the stored bytes over the caller's defaults
+// and reports the version, and the caller migrates from there.  Fields
+// must therefore only ever be appended to the payload struct.
+template <uint16_t BaseAddress, uint8_t SlotCount, uint8_t SlotSize>
+class EepromRecordStore
+{
+    public:
+
+    // A slot as stored: header, payload area, CRC over both
+    typedef struct s_slot {
+        sEepromRecordHeader header;
+        uint8_t payload[SlotSize - sizeof(sEepromRecordHeader) - sizeof(uint16_t)];
+        uint16_t crc;
+    } sSlot;
+
+    // Member Variables:
+    uint16_t Sequence;   // sequence number of the current record
+    uint8_t Slot;        // slot holding the current record
+    bool Loaded;         // a valid record was found (or has been saved)
+
+    // Constructor
+    EepromRecordStore()
+    {
+        Sequence = 0;
+        Slot = SlotCount - 1;   // so the first save goes to slot 0
+        Loaded = false;
+    }
+
+    // Largest payload a slot can hold
+    static uint8_t Capacity()
+    {
+        return sizeof(((sSlot *)0)->payload);
+    }
+
+    // Find the newest slot with a good CRC and copy its payload (at most
+    // length bytes) over data.  Returns the stored payload length, or 0 if
+    // there is no valid record (data is then untouched).
+    uint8_t Load(void *data, uint8_t length, uint8_t *version)
+    {
+        uint16_t tried = 0;   // bit mask of slots already rejected (SlotCount <= 16)
+
+        for (uint8_t attempt = 0; attempt < SlotCount; attempt++)
+        {
+            int8_t newest = -1;
+            uint16_t newest_sequence = 0;
+
+            // Only the headers are read while searching
+            for (uint8_t i = 0; i < SlotCount; i++)
+            {
+                sEepromRecordHeader header;
+
+                if (tried & (1U << i))
+                {
+                    continue;
+                }
+
+                EEPROM.get(SlotAddress(i), header);
+                if (header.version == 0xFF)
+                {
+                    continue;   // erased
+                }
+
+                if (newest < 0 || (int16_t)(header.sequence - newest_sequence) > 0)
+                {
+                    newest = i;
+                    newest_sequence = header.sequence;
+                }
+            }
+
+            if (newest < 0)
+            {
+                return 0;
+            }
+
+            sSlot slot;
+
+            EEPROM.get(SlotAddress(newest), slot);
+
+            if (slot.crc == SlotCrc(&slot) && slot.header.length <= Capacity())
+            {
+                memcpy(data, slot.payload, (length < slot.header.length) ? length : slot.header.length);
+                *version = slot.header.version;
+
+                Sequence = slot.header.sequence;
+                Slot = newest;
+                Loaded = true;
+
+                return slot.header.length;
+            }
+
+            tried |= (1U << newest);
+        }
+
+        return 0;
+    }
+
+    // Write data as the new current record, into the slot after the current
+    // one.  Returns false if data does not fit.
+    bool Save(const void *data, uint8_t length, uint8_t version)
+    {
+        if (length > Capacity())
+        {
+            return false;
+        }
+
+        sSlot slot;
+
+        memset(&slot, 0, sizeof(slot));
+        slot.header.sequence = Sequence + 1;
+        slot.header.version = version;
+        slot.header.length = length;
+        memcpy(slot.payload, data, length);
+        slot.crc = SlotCrc(&slot);
+
+        uint8_t next = (Slot + 1) % SlotCount;
+
+        EEPROM.put(SlotAddress(next), slot);
+
+        Sequence = slot.header.sequence;
+        Slot = next;
+        Loaded = true;
+
+        return true;
+    }
+
+    // Erase every slot (a factory fresh EEPROM)
+    void Erase()
+    {
+        for (uint16_t i = 0; i < (uint16_t)SlotCount * SlotSize; i++)
+        {
+            EEPROM.update(BaseAddress + i, 0xFF);
+        }
+
+        Sequence = 0;
+        Slot = SlotCount - 1;
+        Loaded = false;
+    }
+
+    private:
+
+    static uint16_t SlotAddress(uint8_t slot)
+    {
+        return BaseAddress + (uint16_t)slot * SlotSize;
+    }
+
+    static uint16_t SlotCrc(const sSlot *slot)
+    {
+        return crc16(slot, sizeof(sSlot) - sizeof(uint16_t));
+    }
+};
+
+#endif /* _EEPROM_RECORD_STORE_H */
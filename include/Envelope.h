@@ -0,0 +1,102 @@
+#ifndef _ENVELOPE_H
+#define _ENVELOPE_H
+
+#include <Arduino.h>
+
+// Entries per envelope table (a power of two)
+#define ENVELOPE_TABLE_SIZE 64
+#define ENVELOPE_TABLE_BITS 6
+
+typedef enum e_envelope_shape {
+    ENVELOPE_SINE,          // sin^2 swell and fade over the whole period
+    ENVELOPE_EXPONENTIAL    // fast exponential rise, slow exponential decay
+} eEnvelopeShape;
+
+// One period of each shape, 0..255
+const uint8_t EnvelopeSine[ENVELOPE_TABLE_SIZE] PROGMEM = {
+      0,   1,   2,   5,  10,  15,  21,  29,  37,  47,  57,  67,  79,  90, 103, 115,
+    127, 140, 152, 165, 176, 188, 198, 208, 218, 226, 234, 240, 245, 250, 253, 254,
+    255, 254, 253, 250, 245, 240, 234, 226, 218, 208, 198, 188, 176, 165, 152, 140,
+    128, 115, 103,  90,  79,  67,  57,  47,  37,  29,  21,  15,  10,   5,   2,   1
+};
+
+const uint8_t EnvelopeExponential[ENVELOPE_TABLE_SIZE] PROGMEM = {
+      0, 107, 171, 209, 232, 245, 253, 236, 207, 182, 160, 140, 123, 108,  95,  83,
+     73,  64,  56,  49,  43,  38,  33,  29,  26,  23,  20,  17,  15,  13,  12,  10,
+      9,   8,   7,   6,   5,   5,   4,   4,   3,   3,   2,   2,   2,   2,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   0,   0,   0,   0,   0,   0,   0,   0,   0
+};
+
+// Envelope Class - periodic brightness envelope sampled from a PROGMEM
+// table.  The phase is 32-bit fixed point: milliseconds into the period
+// times 2^32 / period, so taking a sample is one multiply and a table
+// interpolation, with no floating point.  StartTime is advanced a whole
+// period at a time, so the rounding of the step never accumulates.
+class Envelope
+{
+    public:
+
+    // Member Variables:
+    const uint8_t *Table;     // one period of levels, in PROGMEM
+    uint16_t Period;          // milliseconds per period
+    uint32_t PhaseStep;       // phase advance per millisecond
+    unsigned long StartTime;  // millis() at phase 0 of the current period
+
+    // Constructor
+    Envelope(eEnvelopeShape shape, uint16_t period_in_msecs)
+    {
+        SetShape(shape);
+        SetPeriod(period_in_msecs);
+        StartTime = 0;
+    }
+
+    void SetShape(eEnvelopeShape shape)
+    {
+        Table = (shape == ENVELOPE_EXPONENTIAL) ? EnvelopeExponential : EnvelopeSine;
+    }
+
+    // The only division; done when the period changes, not per sample
+    void SetPeriod(uint16_t period_in_msecs)
+    {
+        Period = (period_in_msecs > 0) ? period_in_msecs : 1;
+        PhaseStep = 0xFFFFFFFFUL / Period + 1;
+    }
+
+    // Put phase 0 at start_time (which may lie in the future)
+    void Start(unsigned long start_time)
+    {
+        StartTime = start_time;
+    }
+
+    // Level at now, 0..255, linearly interpolated between table entries
+    uint8_t Level(unsigned long now)
+    {
+        // Signed test: before the first period starts the phase counts back
+        while ((long)(now - StartTime) >= (long)Period)
+        {
+            StartTime += Period;
+        }
+
+        uint32_t phase = (uint32_t)(now - StartTime) * PhaseStep;
+        uint8_t index = phase >> (32 - ENVELOPE_TABLE_BITS);
+        uint8_t fraction = phase >> (24 - ENVELOPE_TABLE_BITS);
+        uint8_t a = pgm_read_byte(&Table[index]);
+        uint8_t b = pgm_read_byte(&Table[(index + 1) & (ENVELOPE_TABLE_SIZE - 1)]);
+
+        // Weights sum to 256, so the sum stays within 16 bits
+        return ((uint16_t)a * (256 - fraction) + (uint16_t)b * fraction) >> 8;
+    }
+
+    // Scale each channel of a packed RGB color by level
+    static uint32_t Scale(uint32_t color, uint8_t level)
+    {
+        uint16_t scale = level + 1;
+        uint8_t r = ((uint8_t)(color >> 16) * scale) >> 8;
+        uint8_t g = ((uint8_t)(color >> 8) * scale) >> 8;
+        uint8_t b = ((uint8_t)color * scale) >> 8;
+
+        return ((uint32_t)r << 16) | ((uint16_t)g << 8) | b;
+    }
+};
+
+#endif /* _ENVELOPE_H */
@@ -0,0 +1,146 @@
+#ifndef _EVENT_LOG_H
+#define _EVENT_LOG_H
+
+#include <Arduino.h>
+
+// Log levels.  Define LOG_LEVEL before including this header; LOG_* calls
+// above it compile to nothing (their arguments are never evaluated).
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Record id written by the log itself when records were lost to overflow
+// (arg0 = records lost).  Application ids start at 1.
+#define LOG_EVENT_ID_OVERFLOW 0
+
+// A compiled out LOG_* call (the arguments still count as used)
+#define LOG_DISCARD(arg0, arg1) do { if (0) { (void)(arg0); (void)(arg1); } } while (0)
+
+// The LOG_* macros write to an EventLog named event_log
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(id, arg0, arg1) event_log.Add(LOG_LEVEL_ERROR, id, arg0, arg1)
+#else
+#define LOG_ERROR(id, arg0, arg1) LOG_DISCARD(arg0, arg1)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(id, arg0, arg1) event_log.Add(LOG_LEVEL_WARN, id, arg0, arg1)
+#else
+#define LOG_WARN(id, arg0, arg1) LOG_DISCARD(arg0, arg1)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(id, arg0, arg1) event_log.Add(LOG_LEVEL_INFO, id, arg0, arg1)
+#else
+#define LOG_INFO(id, arg0, arg1) LOG_DISCARD(arg0, arg1)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(id, arg0, arg1) event_log.Add(LOG_LEVEL_DEBUG, id, arg0, arg1)
+#else
+#define LOG_DEBUG(id, arg0, arg1) LOG_DISCARD(arg0, arg1)
+#endif
+
+// Saturate a 32-bit counter to a record argument
+inline uint16_t log_clamp(uint32_t value)
+{
+    return (value > 0xFFFF) ? 0xFFFF : (uint16_t)value;
+}
+
+// One log entry: an event id and two arguments, formatted on the host
+typedef struct s_log_record {
+    uint16_t time_in_milliseconds;  // low 16 bits of millis()
+    uint8_t id;
+    uint8_t level;
+    uint16_t arg0;
+    uint16_t arg1;
+} sLogRecord;
+
+// EventLog Class - fixed size ring of log records.  Add() only copies 8
+// bytes, so logging costs the same whether or not anything is listening;
+// the records are taken out later (Take()) and sent when loop() has time
+// to spare.  When the ring is full new records are counted and dropped, and
+// the count is reported as a LOG_EVENT_ID_OVERFLOW record once there is room.
+// Add() and Take() are for loop() context only; ISRs post to an EventQueue.
+// Size must be a power of two no larger than 128.
+template <uint8_t Size>
+class EventLog
+{
+    public:
+
+    // Member Variables:
+    sLogRecord Records[Size];
+    uint8_t Head;       // next slot Add() writes
+    uint8_t Tail;       // next slot Take() reads
+    uint16_t Dropped;   // records lost since the last overflow record
+
+    // Constructor
+    EventLog()
+    {
+        Head = 0;
+        Tail = 0;
+        Dropped = 0;
+    }
+
+    void Add(uint8_t level, uint8_t id, uint16_t arg0, uint16_t arg1)
+    {
+        uint8_t next = (Head + 1) & (Size - 1);
+
+        if (next == Tail)
+        {
+            if (Dropped < 0xFFFF)
+            {
+                Dropped++;
+            }
+            return;
+        }
+
+        sLogRecord *record = &Records[Head];
+
+        record->time_in_milliseconds = millis();
+        record->id = id;
+        record->level = level;
+        record->arg0 = arg0;
+        record->arg1 = arg1;
+        Head = next;
+    }
+
+    // Move up to max_records of the oldest records to records, preceded by
+    // an overflow record if any were lost.  Returns the number moved.
+    uint8_t Take(sLogRecord *records, uint8_t max_records)
+    {
+        uint8_t count = 0;
+
+        if (Dropped > 0 && max_records > 0)
+        {
+            records[count].time_in_milliseconds = millis();
+            records[count].id = LOG_EVENT_ID_OVERFLOW;
+            records[count].level = LOG_LEVEL_WARN;
+            records[count].arg0 = Dropped;
+            records[count].arg1 = 0;
+            count++;
+            Dropped = 0;
+        }
+
+        while (count < max_records && Tail != Head)
+        {
+            records[count++] = Records[Tail];
+            Tail = (Tail + 1) & (Size - 1);
+        }
+
+        return count;
+    }
+
+    bool IsEmpty()
+    {
+        return Tail == Head && Dropped == 0;
+    }
+};
+
+#endif /* _EVENT_LOG_H */
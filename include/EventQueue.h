@@ -0,0 +1,85 @@
+#ifndef _EVENT_QUEUE_H
+#define _EVENT_QUEUE_H
+
+#include <Arduino.h>
+
+// Compiler barrier: keeps the slot access on the right side of the index update
+#define EVENT_QUEUE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// An event posted from interrupt context to loop()
+typedef struct s_event {
+    uint8_t type;
+    uint32_t timestamp_in_micro_seconds;
+} sEvent;
+
+// EventQueue Class - lock-free single-producer/single-consumer ring buffer.
+// The producer is interrupt context (AVR ISRs do not nest, so all ISRs
+// together count as one producer) and the consumer is loop().  Head is only
+// written by the producer and Tail only by the consumer; both are single
+// bytes, so reads and writes are atomic without masking interrupts.
+// Size must be a power of two no larger than 128.
+template <uint8_t Size>
+class EventQueue
+{
+    public:
+
+    // Member Variables:
+    sEvent Events[Size];
+    volatile uint8_t Head;      // next slot the producer writes
+    volatile uint8_t Tail;      // next slot the consumer reads
+    volatile uint16_t Dropped;  // events lost because the queue was full
+
+    // Constructor
+    EventQueue()
+    {
+        Head = 0;
+        Tail = 0;
+        Dropped = 0;
+    }
+
+    // Add an event (producer side only).  Returns false if the queue is full.
+    bool Push(uint8_t type, uint32_t timestamp_in_micro_seconds)
+    {
+        uint8_t head = Head;
+        uint8_t next = (head + 1) & (Size - 1);
+
+        if (next == Tail)
+        {
+            Dropped++;
+            return false;
+        }
+
+        Events[head].type = type;
+        Events[head].timestamp_in_micro_seconds = timestamp_in_micro_seconds;
+        EVENT_QUEUE_BARRIER();
+        Head = next;
+
+        return true;
+    }
+
+    // Remove the oldest event (consumer side only).  Returns false if empty.
+    bool Pop(sEvent *event)
+    {
+        uint8_t tail = Tail;
+
+        if (tail == Head)
+        {
+            return false;
+        }
+
+        EVENT_QUEUE_BARRIER();
+        *event = Events[tail];
+        EVENT_QUEUE_BARRIER();
+        Tail = (tail + 1) & (Size - 1);
+
+        return true;
+    }
+
+    // Returns true if there are no events waiting
+    bool IsEmpty()
+    {
+        return Tail == Head;
+    }
+};
+
+#endif /* _EVENT_QUEUE_H */
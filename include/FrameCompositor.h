@@ -0,0 +1,168 @@
+#ifndef _FRAME_COMPOSITOR_H
+#define _FRAME_COMPOSITOR_H
+
+#include <Arduino.h>
+#include "NeoPatterns.h"
+#include "LoopProfiler.h"
+
+// Render and flush timing, in microseconds.  Renders are timed with
+// LOOP_PROFILER_CLOCK() (host time in the native build, where only flushes
+// move the simulated clock), flushes with micros().
+typedef struct s_frame_timing {
+    uint32_t frames;              // frames rendered
+    uint32_t frames_dropped;      // frame ticks skipped because loop() was late
+    uint32_t render_total_micro_seconds;
+    uint32_t render_max_micro_seconds;
+    uint32_t flush_total_micro_seconds;
+    uint32_t flush_max_micro_seconds;
+} sFrameTiming;
+
+// FrameCompositor Class - drives every strip from one frame clock.  Once
+// started, the strips' show() only marks the frame; on each frame tick the
+// render callback paints all strips and the dirty ones are then pushed out
+// back-to-back, so interrupts are masked in one window per frame instead of
+// one per strip at unrelated times.  Frame ticks are kept on a fixed grid
+// (NextFrame advances by FrameInterval); when loop() falls more than a frame
+// behind the missed ticks are dropped rather than rendered in a burst.
+// An optional CanFlush callback can hold a rendered frame back (e.g. until
+// the gap between RC pulses); it is asked again on every Update() call.
+class FrameCompositor
+{
+    public:
+
+    // Member Variables:
+    NeoPatterns **Strips;
+    uint8_t StripCount;
+
+    unsigned long FrameInterval;  // microseconds per frame
+    unsigned long NextFrame;      // micros() of the next frame tick
+    bool FlushPending;            // a rendered frame is waiting for CanFlush
+
+    sFrameTiming Timing;
+
+    void (*OnRender)();  // paints the strips for the current frame
+
+    // May interrupts be masked for duration microseconds starting at now?
+    bool (*CanFlush)(unsigned long now, uint16_t duration);
+
+    // Constructor
+    FrameCompositor(NeoPatterns **strips, uint8_t strip_count, uint8_t target_fps, void (*callback)())
+    {
+        Strips = strips;
+        StripCount = strip_count;
+        OnRender = callback;
+        CanFlush = NULL;
+        NextFrame = 0;
+        FlushPending = false;
+        SetTargetFps(target_fps);
+        ResetTiming();
+    }
+
+    // Take over the strips' show() and start the frame clock at now
+    void Begin(unsigned long now)
+    {
+        for (uint8_t i = 0; i < StripCount; i++)
+        {
+            Strips[i]->DeferShow = true;
+        }
+        NextFrame = now;
+    }
+
+    void SetTargetFps(uint8_t target_fps)
+    {
+        FrameInterval = 1000000UL / (target_fps > 0 ? target_fps : 1);
+    }
+
+    // Render a frame if one is due and flush it once CanFlush allows.
+    // Returns true if a frame was flushed.
+    bool Update(unsigned long now)
+    {
+        if (!FlushPending)
+        {
+            if ((long)(now - NextFrame) < 0)
+            {
+                return false;
+            }
+
+            NextFrame += FrameInterval;
+            if ((long)(now - NextFrame) >= 0)
+            {
+                // More than a frame behind: drop the missed ticks and realign
+                unsigned long behind = now - NextFrame;
+                Timing.frames_dropped += behind / FrameInterval + 1;
+                NextFrame += (behind / FrameInterval + 1) * FrameInterval;
+            }
+
+            unsigned long render_start = LOOP_PROFILER_CLOCK();
+
+            if (OnRender != NULL)
+            {
+                OnRender();
+            }
+
+            RecordRender(LOOP_PROFILER_CLOCK() - render_start);
+            FlushPending = true;
+        }
+
+        unsigned long flush_start = micros();
+        uint16_t flush_duration = FlushMicros();
+
+        if (flush_duration > 0 && CanFlush != NULL && !CanFlush(flush_start, flush_duration))
+        {
+            return false;
+        }
+
+        for (uint8_t i = 0; i < StripCount; i++)
+        {
+            Strips[i]->Flush();
+        }
+
+        RecordFlush(micros() - flush_start);
+        FlushPending = false;
+
+        return true;
+    }
+
+    // Time interrupts will be masked flushing every strip (0 if none changed)
+    uint16_t FlushMicros()
+    {
+        uint16_t total = 0;
+
+        for (uint8_t i = 0; i < StripCount; i++)
+        {
+            total += Strips[i]->FlushMicros();
+        }
+
+        return total;
+    }
+
+    void ResetTiming()
+    {
+        memset(&Timing, 0, sizeof(Timing));
+    }
+
+    private:
+
+    void RecordRender(unsigned long render_micro_seconds)
+    {
+        Timing.frames++;
+        Timing.render_total_micro_seconds += render_micro_seconds;
+
+        if (render_micro_seconds > Timing.render_max_micro_seconds)
+        {
+            Timing.render_max_micro_seconds = render_micro_seconds;
+        }
+    }
+
+    void RecordFlush(unsigned long flush_micro_seconds)
+    {
+        Timing.flush_total_micro_seconds += flush_micro_seconds;
+
+        if (flush_micro_seconds > Timing.flush_max_micro_seconds)
+        {
+            Timing.flush_max_micro_seconds = flush_micro_seconds;
+        }
+    }
+};
+
+#endif /* _FRAME_COMPOSITOR_H */
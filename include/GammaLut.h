@@ -0,0 +1,98 @@
+#ifndef _GAMMA_LUT_H
+#define _GAMMA_LUT_H
+
+#include <Arduino.h>
+
+// Perceptual gamma curve (gamma 2.6) in 8.8 fixed point: entry n is
+// 255 * (n / 255) ^ 2.6, times 256.  Full scale (255 << 8) is exact.
+// F(level, arg) is applied to every entry, so tables derived from the curve
+// are built by the compiler (see GAMMA_LUT_TABLE()).
+#define GAMMA_LUT_CURVE(F, arg) \
+    F(    0, arg), F(    0, arg), F(    0, arg), F(    1, arg), F(    1, arg), F(    2, arg), F(    4, arg), F(    6, arg), \
+    F(    8, arg), F(   11, arg), F(   14, arg), F(   18, arg), F(   23, arg), F(   28, arg), F(   34, arg), F(   41, arg), \
+    F(   49, arg), F(   57, arg), F(   66, arg), F(   76, arg), F(   87, arg), F(   99, arg), F(  112, arg), F(  125, arg), \
+    F(  140, arg), F(  156, arg), F(  172, arg), F(  190, arg), F(  209, arg), F(  229, arg), F(  250, arg), F(  272, arg), \
+    F(  296, arg), F(  321, arg), F(  346, arg), F(  374, arg), F(  402, arg), F(  432, arg), F(  463, arg), F(  495, arg), \
+    F(  529, arg), F(  564, arg), F(  600, arg), F(  638, arg), F(  677, arg), F(  718, arg), F(  760, arg), F(  804, arg), \
+    F(  849, arg), F(  896, arg), F(  944, arg), F(  994, arg), F( 1046, arg), F( 1099, arg), F( 1153, arg), F( 1210, arg), \
+    F( 1268, arg), F( 1328, arg), F( 1389, arg), F( 1452, arg), F( 1517, arg), F( 1584, arg), F( 1652, arg), F( 1722, arg), \
+    F( 1794, arg), F( 1868, arg), F( 1944, arg), F( 2021, arg), F( 2100, arg), F( 2182, arg), F( 2265, arg), F( 2350, arg), \
+    F( 2437, arg), F( 2526, arg), F( 2617, arg), F( 2710, arg), F( 2805, arg), F( 2902, arg), F( 3001, arg), F( 3102, arg), \
+    F( 3205, arg), F( 3310, arg), F( 3417, arg), F( 3527, arg), F( 3638, arg), F( 3752, arg), F( 3868, arg), F( 3986, arg), \
+    F( 4106, arg), F( 4229, arg), F( 4353, arg), F( 4480, arg), F( 4609, arg), F( 4741, arg), F( 4874, arg), F( 5010, arg), \
+    F( 5149, arg), F( 5289, arg), F( 5432, arg), F( 5577, arg), F( 5725, arg), F( 5875, arg), F( 6027, arg), F( 6182, arg), \
+    F( 6340, arg), F( 6499, arg), F( 6661, arg), F( 6826, arg), F( 6993, arg), F( 7163, arg), F( 7335, arg), F( 7510, arg), \
+    F( 7687, arg), F( 7866, arg), F( 8049, arg), F( 8234, arg), F( 8421, arg), F( 8611, arg), F( 8804, arg), F( 8999, arg), \
+    F( 9197, arg), F( 9398, arg), F( 9601, arg), F( 9807, arg), F(10015, arg), F(10227, arg), F(10441, arg), F(10658, arg), \
+    F(10877, arg), F(11100, arg), F(11325, arg), F(11553, arg), F(11783, arg), F(12017, arg), F(12253, arg), F(12492, arg), \
+    F(12734, arg), F(12979, arg), F(13227, arg), F(13478, arg), F(13731, arg), F(13988, arg), F(14247, arg), F(14509, arg), \
+    F(14775, arg), F(15043, arg), F(15314, arg), F(15588, arg), F(15866, arg), F(16146, arg), F(16429, arg), F(16715, arg), \
+    F(17005, arg), F(17297, arg), F(17593, arg), F(17891, arg), F(18193, arg), F(18498, arg), F(18805, arg), F(19116, arg), \
+    F(19431, arg), F(19748, arg), F(20068, arg), F(20392, arg), F(20719, arg), F(21049, arg), F(21382, arg), F(21719, arg), \
+    F(22059, arg), F(22402, arg), F(22748, arg), F(23098, arg), F(23450, arg), F(23806, arg), F(24166, arg), F(24529, arg), \
+    F(24895, arg), F(25264, arg), F(25637, arg), F(26013, arg), F(26393, arg), F(26776, arg), F(27162, arg), F(27552, arg), \
+    F(27945, arg), F(28341, arg), F(28741, arg), F(29145, arg), F(29552, arg), F(29962, arg), F(30376, arg), F(30794, arg), \
+    F(31215, arg), F(31639, arg), F(32067, arg), F(32499, arg), F(32934, arg), F(33372, arg), F(33815, arg), F(34260, arg), \
+    F(34710, arg), F(35163, arg), F(35620, arg), F(36080, arg), F(36544, arg), F(37011, arg), F(37483, arg), F(37958, arg), \
+    F(38436, arg), F(38918, arg), F(39405, arg), F(39894, arg), F(40388, arg), F(40885, arg), F(41386, arg), F(41891, arg), \
+    F(42399, arg), F(42911, arg), F(43427, arg), F(43947, arg), F(44471, arg), F(44998, arg), F(45530, arg), F(46065, arg), \
+    F(46604, arg), F(47147, arg), F(47693, arg), F(48244, arg), F(48798, arg), F(49357, arg), F(49919, arg), F(50486, arg), \
+    F(51056, arg), F(51630, arg), F(52208, arg), F(52790, arg), F(53376, arg), F(53966, arg), F(54560, arg), F(55158, arg), \
+    F(55760, arg), F(56366, arg), F(56976, arg), F(57591, arg), F(58209, arg), F(58831, arg), F(59458, arg), F(60088, arg), \
+    F(60723, arg), F(61361, arg), F(62004, arg), F(62651, arg), F(63302, arg), F(63957, arg), F(64616, arg), F(65280, arg)
+
+// Curve entry scaled to brightness
+#define GAMMA_LUT_SCALE(level, brightness) ((uint16_t)(((uint32_t)(level) * (brightness)) / 255))
+
+// Initializer for a 256 entry output table at a compile-time brightness:
+//   const uint16_t table[256] PROGMEM = GAMMA_LUT_TABLE(12);
+#define GAMMA_LUT_TABLE(brightness) { GAMMA_LUT_CURVE(GAMMA_LUT_SCALE, brightness) }
+
+// Temporal dither of the fraction below one output step, so fades, tails
+// and envelopes keep the in-between levels a low brightness leaves them.
+// Thresholds (1/256ths), cycled per frame and offset per byte so
+// neighbouring pixels do not switch on the same frame.
+#define GAMMA_LUT_DITHER_STEPS 4
+
+const uint8_t GammaLutDither[GAMMA_LUT_DITHER_STEPS] = { 0, 128, 64, 192 };
+
+// Dithered frames after the pixels last changed (one dither cycle); then
+// the levels are rounded to the nearest step once and a static frame is
+// not sent again.  0 rounds every frame.
+#ifndef GAMMA_LUT_DITHER_FRAMES
+#define GAMMA_LUT_DITHER_FRAMES GAMMA_LUT_DITHER_STEPS
+#endif
+
+// GammaLut Class - combined gamma and brightness table.  Entry n is the
+// output level of color byte n in 8.8 fixed point, so the fraction below
+// one output step is kept for the dither and rounding.  The table lives in
+// PROGMEM, built at compile time with GAMMA_LUT_TABLE(), and one table can
+// be shared by every strip that uses the same brightness.
+class GammaLut
+{
+    public:
+
+    // Member Variables:
+    const uint16_t *Table;      // 256 entries, in PROGMEM
+
+    // Constructor
+    GammaLut(const uint16_t *table)
+    {
+        Table = table;
+    }
+
+    // Output level of a color byte, 8.8 fixed point.  Full scale maps
+    // exactly to the brightness, so pure colors have no fraction.
+    uint16_t Level(uint8_t value) const
+    {
+        return pgm_read_word(&Table[value]);
+    }
+
+    // Output byte for a color byte, rounded to the nearest step
+    uint8_t Apply(uint8_t value) const
+    {
+        return (Level(value) + 128) >> 8;
+    }
+};
+
+#endif /* _GAMMA_LUT_H */
@@ -0,0 +1,105 @@
+#ifndef _LIGHT_SEQUENCER_H
+#define _LIGHT_SEQUENCER_H
+
+#include <Arduino.h>
+
+// Pack an RGB color at compile time (usable in PROGMEM tables)
+#define SEQUENCE_COLOR(r, g, b) (((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+
+// One step of a flash profile: at offset_in_msecs into the period, set
+// the segment to color
+typedef struct s_sequence_step {
+    uint16_t offset_in_msecs;
+    uint8_t segment;
+    uint32_t color;
+} sSequenceStep;
+
+// A flash profile: a PROGMEM table of steps sorted by offset, repeated
+// every period_in_msecs
+typedef struct s_sequence_profile {
+    const sSequenceStep *steps;
+    uint8_t step_count;
+    uint16_t period_in_msecs;
+} sSequenceProfile;
+
+// LightSequencer Class - plays a flash profile against one shared period.
+// Step times are derived from the start of the current period rather than
+// from the previous step, so the phases between steps never drift.  It has
+// no timer of its own: the caller runs Update() from a one-shot timer task
+// scheduled for the delay it returns.  A task that schedules its successor
+// from its own callback holds two timer slots until the callback returns,
+// so budget two.
+class LightSequencer
+{
+    public:
+
+    // Member Variables:
+    const sSequenceProfile *Profile;  // profile being played (NULL = stopped)
+    unsigned long PeriodStart;        // start time of the current period
+    uint8_t NextStep;                 // index of the next step to apply
+
+    void (*OnStep)(uint8_t segment, uint32_t color);  // applies one step
+
+    // Constructor
+    LightSequencer(void (*callback)(uint8_t segment, uint32_t color))
+    {
+        OnStep = callback;
+        Profile = NULL;
+        PeriodStart = 0;
+        NextStep = 0;
+    }
+
+    // Start playing a profile with its period beginning at now
+    void Start(const sSequenceProfile *profile, unsigned long now)
+    {
+        Profile = profile;
+        PeriodStart = now;
+        NextStep = 0;
+    }
+
+    // Stop playing (segments keep their last color)
+    void Stop()
+    {
+        Profile = NULL;
+    }
+
+    // Apply every step that is due at now.  Returns the milliseconds until
+    // the next step is due, or 0 when stopped.
+    unsigned long Update(unsigned long now)
+    {
+        if (Profile == NULL || Profile->step_count == 0)
+        {
+            return 0;
+        }
+
+        // Signed comparison: once a period completes PeriodStart lies ahead of
+        // now until the next period begins
+        while (Profile != NULL && (long)(now - PeriodStart) >= (long)StepOffset(NextStep))
+        {
+            OnStep(pgm_read_byte(&Profile->steps[NextStep].segment),
+                   pgm_read_dword(&Profile->steps[NextStep].color));
+
+            NextStep++;
+            if (NextStep >= Profile->step_count)
+            {
+                NextStep = 0;
+                PeriodStart += Profile->period_in_msecs;
+            }
+        }
+
+        if (Profile == NULL)
+        {
+            return 0;
+        }
+
+        return (PeriodStart + StepOffset(NextStep)) - now;
+    }
+
+    // Returns the offset of a step within the period
+    unsigned long StepOffset(uint8_t step)
+    {
+        return pgm_read_word(&Profile->steps[step].offset_in_msecs);
+    }
+};
+
+#endif /* _LIGHT_SEQUENCER_H */
@@ -0,0 +1,139 @@
+#ifndef _LOOP_PROFILER_H
+#define _LOOP_PROFILER_H
+
+#include <Arduino.h>
+#ifndef __AVR__
+#include <chrono>
+#endif
+
+// Histogram buckets: bucket 0 counts passes under 8us, every next bucket
+// doubles the limit and the last one counts everything from 512us up
+#define LOOP_PROFILER_BUCKETS 8
+#define LOOP_PROFILER_FIRST_BUCKET_SHIFT 3
+
+// Clock the stages are timed with, in microseconds: micros() on AVR.  On
+// the host micros() is the simulated clock, which only the modelled
+// blocking (show(), serial TX) moves, so there the host's steady clock
+// times the stages and shows what their code really costs.
+#ifndef LOOP_PROFILER_CLOCK
+#ifdef __AVR__
+#define LOOP_PROFILER_CLOCK() micros()
+#else
+#define LOOP_PROFILER_CLOCK() loop_profiler_host_micros()
+
+static inline unsigned long loop_profiler_host_micros()
+{
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+#endif
+
+// The LOOP_PROFILE* macros use a LoopProfiler named loop_profiler and
+// compile to nothing unless LOOP_PROFILER is defined
+#ifdef LOOP_PROFILER
+#define LOOP_PROFILE_BEGIN() loop_profiler.Begin(LOOP_PROFILER_CLOCK())
+#define LOOP_PROFILE(stage) loop_profiler.Mark(stage, LOOP_PROFILER_CLOCK())
+#define LOOP_PROFILE_END(stage) loop_profiler.End(stage, LOOP_PROFILER_CLOCK())
+#else
+#define LOOP_PROFILE_BEGIN() do {} while (0)
+#define LOOP_PROFILE(stage) do {} while (0)
+#define LOOP_PROFILE_END(stage) do {} while (0)
+#endif
+
+// Timing of one stage, in microseconds
+typedef struct s_loop_stage_stats {
+    uint32_t count;
+    uint32_t total_micro_seconds;
+    uint16_t min_micro_seconds;
+    uint16_t max_micro_seconds;
+    uint16_t histogram[LOOP_PROFILER_BUCKETS];  // halved together when one fills up
+} sLoopStageStats;
+
+// LoopProfiler Class - splits each loop() pass into stages.  Begin() starts
+// the pass, every Mark() charges the time since the previous mark to a
+// stage, and End() records the whole pass.  One LOOP_PROFILER_CLOCK() read
+// per stage; micros() on AVR has a 4us resolution (the host clock 1us), so
+// short stages show up in the lowest bucket and their averages only settle
+// over many passes.
+template <uint8_t Stages>
+class LoopProfiler
+{
+    public:
+
+    // Member Variables:
+    sLoopStageStats Stage[Stages];
+    unsigned long PassStart;
+    unsigned long LastMark;
+
+    // Constructor
+    LoopProfiler()
+    {
+        Reset();
+        PassStart = 0;
+        LastMark = 0;
+    }
+
+    void Reset()
+    {
+        memset(Stage, 0, sizeof(Stage));
+
+        for (uint8_t i = 0; i < Stages; i++)
+        {
+            Stage[i].min_micro_seconds = 0xFFFF;
+        }
+    }
+
+    void Begin(unsigned long now)
+    {
+        PassStart = now;
+        LastMark = now;
+    }
+
+    void Mark(uint8_t stage, unsigned long now)
+    {
+        Record(stage, now - LastMark);
+        LastMark = now;
+    }
+
+    void End(uint8_t stage, unsigned long now)
+    {
+        Record(stage, now - PassStart);
+    }
+
+    void Record(uint8_t stage, unsigned long duration)
+    {
+        sLoopStageStats *stats = &Stage[stage];
+        uint16_t clamped = (duration > 0xFFFF) ? 0xFFFF : duration;
+        uint8_t bucket = 0;
+
+        while (bucket < LOOP_PROFILER_BUCKETS - 1
+                && (clamped >> (LOOP_PROFILER_FIRST_BUCKET_SHIFT + bucket)) != 0)
+        {
+            bucket++;
+        }
+
+        stats->count++;
+        stats->total_micro_seconds += duration;
+
+        if (clamped < stats->min_micro_seconds)
+        {
+            stats->min_micro_seconds = clamped;
+        }
+        if (clamped > stats->max_micro_seconds)
+        {
+            stats->max_micro_seconds = clamped;
+        }
+        if (stats->histogram[bucket] == 0xFFFF)
+        {
+            // Keep the shape: the histogram then weighs recent passes more
+            for (uint8_t i = 0; i < LOOP_PROFILER_BUCKETS; i++)
+            {
+                stats->histogram[i] >>= 1;
+            }
+        }
+        stats->histogram[bucket]++;
+    }
+};
+
+#endif /* _LOOP_PROFILER_H */
@@ -0,0 +1,103 @@
+#ifndef _MEMORY_WATERMARK_H
+#define _MEMORY_WATERMARK_H
+
+#include <Arduino.h>
+#ifdef __AVR__
+extern char __heap_start;   // avr-libc: start of the heap, and its top
+extern char *__brkval;      // (NULL until the first malloc())
+#else
+#include <NativeSim.h>
+#endif
+
+// Byte Paint() fills the free SRAM with, and the bytes below the stack
+// pointer it leaves alone (its own frame and an interrupt arriving meanwhile)
+#define MEMORY_WATERMARK_PAINT 0xA5
+#define MEMORY_WATERMARK_PAINT_MARGIN 32
+
+// SRAM use so far, in bytes
+typedef struct s_memory_status {
+    uint16_t stack_peak_bytes;      // deepest the stack has been
+    uint16_t free_min_bytes;        // least SRAM never touched between heap and stack
+    uint16_t heap_bytes;            // heap in use at the last Scan()
+    uint16_t heap_peak_bytes;       // most heap in use at any Scan()
+} sMemoryStatus;
+
+// MemoryWatermark Class - stack and heap high-water marks.  Paint() fills
+// the gap between heap and stack with MEMORY_WATERMARK_PAINT once at boot;
+// Scan() then walks up from the heap to the first byte that no longer
+// holds it, which is the deepest the stack (or a heap freed since) has
+// reached.  A scan costs a few cycles per untouched byte, so call it every
+// few seconds rather than every loop() pass.
+// On the host there is no SRAM to paint: the stack fields stay 0 and the
+// heap figures are what the Adafruit_NeoPixel stand-in has allocated.
+class MemoryWatermark
+{
+    public:
+
+    // Member Variables:
+    sMemoryStatus Status;
+    uint8_t *HeapPeakEnd;           // top of the heap at its largest
+
+    // Constructor
+    MemoryWatermark()
+    {
+        memset(&Status, 0, sizeof(Status));
+        HeapPeakEnd = NULL;
+    }
+
+#ifdef __AVR__
+    void Paint()
+    {
+        uint8_t *p = HeapEnd();
+        uint8_t *end = (uint8_t *)SP - MEMORY_WATERMARK_PAINT_MARGIN;
+
+        HeapPeakEnd = p;
+        while (p < end)
+        {
+            *p++ = MEMORY_WATERMARK_PAINT;
+        }
+        Scan();
+    }
+
+    void Scan()
+    {
+        uint8_t *heap_end = HeapEnd();
+        uint8_t *p;
+
+        if (heap_end > HeapPeakEnd)
+        {
+            HeapPeakEnd = heap_end;
+        }
+
+        p = HeapPeakEnd;
+        while (p < (uint8_t *)SP && *p == MEMORY_WATERMARK_PAINT)
+        {
+            p++;
+        }
+
+        Status.free_min_bytes = p - HeapPeakEnd;
+        Status.stack_peak_bytes = (uint8_t *)RAMEND - p + 1;
+        Status.heap_bytes = heap_end - (uint8_t *)&__heap_start;
+        Status.heap_peak_bytes = HeapPeakEnd - (uint8_t *)&__heap_start;
+    }
+
+    // First byte above the heap (avr-libc's malloc moves __brkval)
+    static uint8_t *HeapEnd()
+    {
+        return (uint8_t *)(__brkval != NULL ? __brkval : &__heap_start);
+    }
+#else
+    void Paint()
+    {
+        Scan();
+    }
+
+    void Scan()
+    {
+        Status.heap_bytes = sim_heap_bytes();
+        Status.heap_peak_bytes = sim_heap_peak_bytes();
+    }
+#endif
+};
+
+#endif /* _MEMORY_WATERMARK_H */
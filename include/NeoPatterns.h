@@ -2,11 +2,107 @@
 #define _NEO_PATTERNS_H
 
 #include <Adafruit_NeoPixel.h>
+#include "GammaLut.h"
 
-// Pattern types supported:
-enum  pattern { NONE, RAINBOW_CYCLE, THEATER_CHASE, COLOR_WIPE, SCANNER, FADE };
+// Colour wheel: entry n is the r - g - b - back to r transition at position n
+// (precomputed so Wheel() is a flash read instead of branches and multiplies)
+const uint8_t NeoPatternsWheel[256][3] PROGMEM = {
+    { 255,   0,   0 }, { 252,   3,   0 }, { 249,   6,   0 }, { 246,   9,   0 },
+    { 243,  12,   0 }, { 240,  15,   0 }, { 237,  18,   0 }, { 234,  21,   0 },
+    { 231,  24,   0 }, { 228,  27,   0 }, { 225,  30,   0 }, { 222,  33,   0 },
+    { 219,  36,   0 }, { 216,  39,   0 }, { 213,  42,   0 }, { 210,  45,   0 },
+    { 207,  48,   0 }, { 204,  51,   0 }, { 201,  54,   0 }, { 198,  57,   0 },
+    { 195,  60,   0 }, { 192,  63,   0 }, { 189,  66,   0 }, { 186,  69,   0 },
+    { 183,  72,   0 }, { 180,  75,   0 }, { 177,  78,   0 }, { 174,  81,   0 },
+    { 171,  84,   0 }, { 168,  87,   0 }, { 165,  90,   0 }, { 162,  93,   0 },
+    { 159,  96,   0 }, { 156,  99,   0 }, { 153, 102,   0 }, { 150, 105,   0 },
+    { 147, 108,   0 }, { 144, 111,   0 }, { 141, 114,   0 }, { 138, 117,   0 },
+    { 135, 120,   0 }, { 132, 123,   0 }, { 129, 126,   0 }, { 126, 129,   0 },
+    { 123, 132,   0 }, { 120, 135,   0 }, { 117, 138,   0 }, { 114, 141,   0 },
+    { 111, 144,   0 }, { 108, 147,   0 }, { 105, 150,   0 }, { 102, 153,   0 },
+    {  99, 156,   0 }, {  96, 159,   0 }, {  93, 162,   0 }, {  90, 165,   0 },
+    {  87, 168,   0 }, {  84, 171,   0 }, {  81, 174,   0 }, {  78, 177,   0 },
+    {  75, 180,   0 }, {  72, 183,   0 }, {  69, 186,   0 }, {  66, 189,   0 },
+    {  63, 192,   0 }, {  60, 195,   0 }, {  57, 198,   0 }, {  54, 201,   0 },
+    {  51, 204,   0 }, {  48, 207,   0 }, {  45, 210,   0 }, {  42, 213,   0 },
+    {  39, 216,   0 }, {  36, 219,   0 }, {  33, 222,   0 }, {  30, 225,   0 },
+    {  27, 228,   0 }, {  24, 231,   0 }, {  21, 234,   0 }, {  18, 237,   0 },
+    {  15, 240,   0 }, {  12, 243,   0 }, {   9, 246,   0 }, {   6, 249,   0 },
+    {   3, 252,   0 }, {   0, 255,   0 }, {   0, 252,   3 }, {   0, 249,   6 },
+    {   0, 246,   9 }, {   0, 243,  12 }, {   0, 240,  15 }, {   0, 237,  18 },
+    {   0, 234,  21 }, {   0, 231,  24 }, {   0, 228,  27 }, {   0, 225,  30 },
+    {   0, 222,  33 }, {   0, 219,  36 }, {   0, 216,  39 }, {   0, 213,  42 },
+    {   0, 210,  45 }, {   0, 207,  48 }, {   0, 204,  51 }, {   0, 201,  54 },
+    {   0, 198,  57 }, {   0, 195,  60 }, {   0, 192,  63 }, {   0, 189,  66 },
+    {   0, 186,  69 }, {   0, 183,  72 }, {   0, 180,  75 }, {   0, 177,  78 },
+    {   0, 174,  81 }, {   0, 171,  84 }, {   0, 168,  87 }, {   0, 165,  90 },
+    {   0, 162,  93 }, {   0, 159,  96 }, {   0, 156,  99 }, {   0, 153, 102 },
+    {   0, 150, 105 }, {   0, 147, 108 }, {   0, 144, 111 }, {   0, 141, 114 },
+    {   0, 138, 117 }, {   0, 135, 120 }, {   0, 132, 123 }, {   0, 129, 126 },
+    {   0, 126, 129 }, {   0, 123, 132 }, {   0, 120, 135 }, {   0, 117, 138 },
+    {   0, 114, 141 }, {   0, 111, 144 }, {   0, 108, 147 }, {   0, 105, 150 },
+    {   0, 102, 153 }, {   0,  99, 156 }, {   0,  96, 159 }, {   0,  93, 162 },
+    {   0,  90, 165 }, {   0,  87, 168 }, {   0,  84, 171 }, {   0,  81, 174 },
+    {   0,  78, 177 }, {   0,  75, 180 }, {   0,  72, 183 }, {   0,  69, 186 },
+    {   0,  66, 189 }, {   0,  63, 192 }, {   0,  60, 195 }, {   0,  57, 198 },
+    {   0,  54, 201 }, {   0,  51, 204 }, {   0,  48, 207 }, {   0,  45, 210 },
+    {   0,  42, 213 }, {   0,  39, 216 }, {   0,  36, 219 }, {   0,  33, 222 },
+    {   0,  30, 225 }, {   0,  27, 228 }, {   0,  24, 231 }, {   0,  21, 234 },
+    {   0,  18, 237 }, {   0,  15, 240 }, {   0,  12, 243 }, {   0,   9, 246 },
+    {   0,   6, 249 }, {   0,   3, 252 }, {   0,   0, 255 }, {   3,   0, 252 },
+    {   6,   0, 249 }, {   9,   0, 246 }, {  12,   0, 243 }, {  15,   0, 240 },
+    {  18,   0, 237 }, {  21,   0, 234 }, {  24,   0, 231 }, {  27,   0, 228 },
+    {  30,   0, 225 }, {  33,   0, 222 }, {  36,   0, 219 }, {  39,   0, 216 },
+    {  42,   0, 213 }, {  45,   0, 210 }, {  48,   0, 207 }, {  51,   0, 204 },
+    {  54,   0, 201 }, {  57,   0, 198 }, {  60,   0, 195 }, {  63,   0, 192 },
+    {  66,   0, 189 }, {  69,   0, 186 }, {  72,   0, 183 }, {  75,   0, 180 },
+    {  78,   0, 177 }, {  81,   0, 174 }, {  84,   0, 171 }, {  87,   0, 168 },
+    {  90,   0, 165 }, {  93,   0, 162 }, {  96,   0, 159 }, {  99,   0, 156 },
+    { 102,   0, 153 }, { 105,   0, 150 }, { 108,   0, 147 }, { 111,   0, 144 },
+    { 114,   0, 141 }, { 117,   0, 138 }, { 120,   0, 135 }, { 123,   0, 132 },
+    { 126,   0, 129 }, { 129,   0, 126 }, { 132,   0, 123 }, { 135,   0, 120 },
+    { 138,   0, 117 }, { 141,   0, 114 }, { 144,   0, 111 }, { 147,   0, 108 },
+    { 150,   0, 105 }, { 153,   0, 102 }, { 156,   0,  99 }, { 159,   0,  96 },
+    { 162,   0,  93 }, { 165,   0,  90 }, { 168,   0,  87 }, { 171,   0,  84 },
+    { 174,   0,  81 }, { 177,   0,  78 }, { 180,   0,  75 }, { 183,   0,  72 },
+    { 186,   0,  69 }, { 189,   0,  66 }, { 192,   0,  63 }, { 195,   0,  60 },
+    { 198,   0,  57 }, { 201,   0,  54 }, { 204,   0,  51 }, { 207,   0,  48 },
+    { 210,   0,  45 }, { 213,   0,  42 }, { 216,   0,  39 }, { 219,   0,  36 },
+    { 222,   0,  33 }, { 225,   0,  30 }, { 228,   0,  27 }, { 231,   0,  24 },
+    { 234,   0,  21 }, { 237,   0,  18 }, { 240,   0,  15 }, { 243,   0,  12 },
+    { 246,   0,   9 }, { 249,   0,   6 }, { 252,   0,   3 }, { 255,   0,   0 }
+};
+
+// Pattern types supported (index into NeoPatternsRegistry):
+enum  pattern { NONE, RAINBOW_CYCLE, THEATER_CHASE, COLOR_WIPE, SCANNER, FADE, PATTERN_COUNT };
 // Patern directions supported:
 enum  direction { FORWARD, REVERSE };
+// How Update() makes up for steps that fell due between calls:
+enum  timebase { SKIP_STEPS, CATCH_UP };
+
+// Most steps one Update() draws when catching up; time beyond that is dropped
+#define NEO_PATTERNS_MAX_CATCH_UP_STEPS 8
+
+class NeoPatterns;
+
+// Start() parameters a pattern uses (sPatternDescriptor params); the others
+// are left as they are
+#define PATTERN_PARAM_COLOR1 0x01
+#define PATTERN_PARAM_COLOR2 0x02
+#define PATTERN_PARAM_STEPS 0x04      // TotalSteps, else init sets it
+#define PATTERN_PARAM_DIRECTION 0x08  // else the pattern runs FORWARD
+// The frame depends on Index alone (not on the previous frame), so steps
+// can be skipped
+#define PATTERN_SEEKABLE 0x80
+
+// A pattern, kept in flash.  Start() applies the common state and then calls
+// init (NULL if there is nothing else to set up); Update() calls update once
+// per Interval.  Patterns outside this file only need their own descriptor.
+typedef struct s_pattern_descriptor {
+    void (*init)(NeoPatterns *strip);
+    void (*update)(NeoPatterns *strip);
+    uint8_t params;
+} sPatternDescriptor;
 
 // NeoPattern Class - derived from the Adafruit_NeoPixel class
 class NeoPatterns : public Adafruit_NeoPixel
@@ -14,53 +110,425 @@ class NeoPatterns : public Adafruit_NeoPixel
     public:
 
     // Member Variables:  
-    pattern  ActivePattern;  // which pattern is running
+    const sPatternDescriptor *ActivePattern;  // which pattern is running (in flash, NULL = none)
     direction Direction;     // direction to run the pattern
     
     unsigned long Interval;   // milliseconds between updates
-    unsigned long lastUpdate; // last update of position
+    unsigned long lastUpdate; // time the current step fell due
+    timebase Timebase;        // what Update() does when it falls behind
     
     uint32_t Color1, Color2;  // What colors are in use
     uint16_t TotalSteps;  // total number of steps in the pattern
     uint16_t Index;  // current step within the pattern
+    uint16_t HueStep;  // wheel positions per pixel (8.8 fixed point) for RainbowCycle
     
     void (*OnComplete)();  // Callback on completion of pattern
+
+    bool FrameDirty;         // pixel data changed since the last show()
+    uint32_t ShowsIssued;    // show() calls that were pushed out to the strip
+    uint32_t ShowsSkipped;   // show() calls skipped because nothing changed
+    bool DeferShow;          // show() leaves the transfer to Flush()
+
+    uint8_t *StaticBuffer;   // caller-owned pixel buffer (NULL = heap allocated)
+    uint16_t StaticBufferSize; // bytes in StaticBuffer
+
+    const GammaLut *OutputLut; // gamma/brightness stage (NULL = send pixels as is)
+    uint8_t *WireBuffer;     // output of the stage, what actually goes out
+    uint8_t DitherFrames;    // output frames left to dither, then one rounded
+    uint8_t DitherPhase;
+    bool OutputStale;        // the strip may not match WireBuffer
     
     // Constructor - calls base-class constructor to initialize strip
     NeoPatterns(uint16_t pixels, uint8_t pin, uint8_t type, void (*callback)())
     :Adafruit_NeoPixel(pixels, pin, type)
     {
+        ActivePattern = NULL;
+        Timebase = SKIP_STEPS;
         OnComplete = callback;
+        FrameDirty = true;
+        ShowsIssued = 0;
+        ShowsSkipped = 0;
+        DeferShow = false;
+        StaticBuffer = NULL;
+        StaticBufferSize = 0;
+        InitOutputStage();
+    }
+
+    // Constructor - uses a fixed buffer of buffer_size bytes instead of the
+    // heap; updateLength() then only changes the active length
+    NeoPatterns(uint8_t *buffer, uint16_t buffer_size, uint16_t pixels, uint8_t pin, uint8_t type, void (*callback)())
+    :Adafruit_NeoPixel()
+    {
+        ActivePattern = NULL;
+        Timebase = SKIP_STEPS;
+        OnComplete = callback;
+        FrameDirty = true;
+        ShowsIssued = 0;
+        ShowsSkipped = 0;
+        DeferShow = false;
+        StaticBuffer = buffer;
+        StaticBufferSize = buffer_size;
+        InitOutputStage();
+
+        updateType(type);
+        setPin(pin);
+        Adafruit_NeoPixel::pixels = StaticBuffer;
+        updateLength(pixels);
+    }
+
+    // Move a fixed buffer strip to new render and wire buffers of size bytes
+    // each, e.g. when strips share one pool.  The length becomes what fits.
+    void SetBuffers(uint8_t *render, uint8_t *wire, uint16_t size)
+    {
+        StaticBuffer = render;
+        StaticBufferSize = size;
+        WireBuffer = wire;
+        Adafruit_NeoPixel::pixels = render;
+        updateLength(size / BytesPerPixel());
+    }
+
+    // The base class frees its pixel pointer, which must not happen to a fixed buffer
+    ~NeoPatterns()
+    {
+        if (StaticBuffer != NULL)
+        {
+            Adafruit_NeoPixel::pixels = NULL;
+        }
+    }
+
+    // Push the frame out now, or leave it for the frame compositor to flush
+    // when DeferShow is set
+    void show()
+    {
+        if (!DeferShow)
+        {
+            Flush();
+        }
+    }
+
+    // Push the frame out to the strip, but only if it has changed.
+    // show() masks interrupts for ~30us per pixel on AVR, so resending
+    // an identical frame only costs loop time and RC timing accuracy.
+    // With an output stage the frame is sent from WireBuffer, and resent
+    // for GAMMA_LUT_DITHER_FRAMES after the pixels last changed while the
+    // dither changes it.
+    void Flush()
+    {
+        bool send = FrameDirty;
+
+        if (FrameDirty)
+        {
+            DitherFrames = GAMMA_LUT_DITHER_FRAMES + 1;
+        }
+
+        if (OutputLut != NULL && (FrameDirty || DitherFrames != 0 || OutputStale))
+        {
+            send = RenderOutput();
+        }
+
+        if (send)
+        {
+            uint8_t *frame = pixels;
+
+            if (OutputLut != NULL)
+            {
+                pixels = WireBuffer;
+            }
+            Adafruit_NeoPixel::show();
+            pixels = frame;
+
+            ShowsIssued++;
+        }
+        else
+        {
+            ShowsSkipped++;
+        }
+
+        FrameDirty = false;
+    }
+
+    // Send the strip through a gamma/brightness table (shared between strips)
+    // into WireBuffer.  The table then owns the brightness, so the strip's own
+    // brightness is set to full and pixels keep their full precision colors.
+    // Returns false if the strip has no WireBuffer.
+    bool SetOutputLut(const GammaLut *lut)
+    {
+        if (WireBuffer == NULL)
+        {
+            return false;
+        }
+
+        Adafruit_NeoPixel::setBrightness(255);
+        OutputLut = lut;
+        OutputStale = true;
+        FrameDirty = true;
+
+        return true;
+    }
+
+    // Run the pixel buffer through the output table into WireBuffer, with
+    // an ordered temporal dither on the fraction below one output step
+    // while DitherFrames lasts and rounded after that.  Dithering ends at
+    // once if no byte has a fraction.  The pixel buffer is only read.
+    // Returns true if the output changed.
+    bool RenderOutput()
+    {
+        const GammaLut *lut = OutputLut;
+        bool dither = (DitherFrames > 1);
+        uint8_t phase = DitherPhase++;
+        uint8_t fractional = 0;
+        bool changed = OutputStale;
+
+        for (uint16_t i = 0; i < numBytes; i++)
+        {
+            uint16_t level = lut->Level(pixels[i]);
+            uint8_t threshold = dither ? GammaLutDither[(phase + i) & (GAMMA_LUT_DITHER_STEPS - 1)] : 128;
+            uint8_t out = (level + threshold) >> 8;
+
+            fractional |= (uint8_t)level;
+            if (out != WireBuffer[i])
+            {
+                WireBuffer[i] = out;
+                changed = true;
+            }
+        }
+
+        DitherFrames = (dither && fractional != 0) ? DitherFrames - 1 : 0;
+        OutputStale = false;
+
+        return changed;
+    }
+
+    // Time interrupts will be masked by the next Flush() (0 if nothing to send).
+    // Each byte takes 8 bits at 1.25us on an 800KHz strip, 2.5us at 400KHz.
+    uint16_t FlushMicros()
+    {
+        if (!FrameDirty && !(OutputLut != NULL && (DitherFrames != 0 || OutputStale)))
+        {
+            return 0;
+        }
+        return numBytes * (is800KHz ? 10 : 20);
+    }
+
+    // Force the next show() to push the frame even if it is unchanged
+    void MarkDirty()
+    {
+        FrameDirty = true;
+        OutputStale = true;
+    }
+
+    // Reset the show() counters
+    void ResetShowCounters()
+    {
+        ShowsIssued = 0;
+        ShowsSkipped = 0;
+    }
+
+    // Set a pixel color, marking the frame dirty only if the stored bytes change
+    void setPixelColor(uint16_t n, uint32_t c)
+    {
+        if (n < numLEDs)
+        {
+            uint8_t *p = &pixels[n * BytesPerPixel()];
+            uint32_t before = PixelBytes(p);
+            Adafruit_NeoPixel::setPixelColor(n, c);
+            if (PixelBytes(p) != before)
+            {
+                FrameDirty = true;
+            }
+        }
+    }
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+    {
+        setPixelColor(n, Color(r, g, b));
+    }
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+    {
+        setPixelColor(n, Color(r, g, b, w));
+    }
+
+    // Fill a range of pixels with a color (same semantics as Adafruit_NeoPixel::fill)
+    void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0)
+    {
+        uint16_t end;
+
+        if (first >= numLEDs)
+        {
+            return;
+        }
+
+        if (count == 0)
+        {
+            end = numLEDs;
+        }
+        else
+        {
+            end = first + count;
+            if (end > numLEDs)
+            {
+                end = numLEDs;
+            }
+        }
+
+        for (uint16_t i = first; i < end; i++)
+        {
+            setPixelColor(i, c);
+        }
+    }
+
+    // Set all pixels to off
+    void clear()
+    {
+        for (uint16_t i = 0; i < numBytes; i++)
+        {
+            if (pixels[i] != 0)
+            {
+                FrameDirty = true;
+                break;
+            }
+        }
+        Adafruit_NeoPixel::clear();
+    }
+
+    // Brightness rescales the pixel buffer, so a change dirties the frame
+    void setBrightness(uint8_t b)
+    {
+        if (b != getBrightness())
+        {
+            FrameDirty = true;
+        }
+        Adafruit_NeoPixel::setBrightness(b);
+    }
+
+    // Switching between RGB and RGBW resizes the buffer, so a fixed buffer
+    // must be kept away from the base class (which would free it)
+    void updateType(neoPixelType t)
+    {
+        if (StaticBuffer != NULL)
+        {
+            Adafruit_NeoPixel::pixels = NULL;
+            Adafruit_NeoPixel::updateType(t);
+            Adafruit_NeoPixel::pixels = StaticBuffer;
+            updateLength(numLEDs);
+        }
+        else
+        {
+            Adafruit_NeoPixel::updateType(t);
+        }
+        FrameDirty = true;
+    }
+
+    // Resizing clears the pixel buffer.  Heap strips reallocate it; fixed
+    // buffer strips just change the active length (clamped to capacity).
+    void updateLength(uint16_t n)
+    {
+        if (StaticBuffer != NULL)
+        {
+            if (n > StaticBufferSize / BytesPerPixel())
+            {
+                n = StaticBufferSize / BytesPerPixel();
+            }
+            numLEDs = n;
+            numBytes = n * BytesPerPixel();
+            memset(StaticBuffer, 0, numBytes);
+        }
+        else
+        {
+            Adafruit_NeoPixel::updateLength(n);
+        }
+        FrameDirty = true;
+        OutputStale = true;
     }
     
     // Update the pattern
     void Update()
     {
-        if((millis() - lastUpdate) > Interval) // time to update
+        Update(millis());
+    }
+
+    // Update the pattern against a caller supplied time (e.g. a frame clock).
+    // lastUpdate advances in whole Intervals rather than to now, so the
+    // overshoot of each call is not lost and the speed does not depend on
+    // how busy loop() is.  Steps that fell due since the last call are
+    // skipped (SKIP_STEPS, seekable patterns) or each drawn (CATCH_UP, and
+    // patterns that build on the previous frame).
+    void Update(unsigned long now)
+    {
+        unsigned long elapsed = now - lastUpdate;
+
+        if (ActivePattern == NULL || elapsed < Interval)
         {
-            lastUpdate = millis();
-            switch(ActivePattern)
+            return;
+        }
+
+        void (*update)(NeoPatterns *) = (void (*)(NeoPatterns *))pgm_read_ptr(&ActivePattern->update);
+
+        if (update == NULL || Interval == 0)
+        {
+            lastUpdate = now;
+            if (update != NULL)
             {
-                case RAINBOW_CYCLE:
-                    RainbowCycleUpdate();
-                    break;
-                case THEATER_CHASE:
-                    TheaterChaseUpdate();
-                    break;
-                case COLOR_WIPE:
-                    ColorWipeUpdate();
-                    break;
-                case SCANNER:
-                    ScannerUpdate();
-                    break;
-                case FADE:
-                    FadeUpdate();
-                    break;
-                default:
-                    break;
+                update(this);
             }
+            return;
+        }
+
+        unsigned long steps = elapsed / Interval;
+
+        lastUpdate += steps * Interval;
+
+        if (Timebase == SKIP_STEPS && (pgm_read_byte(&ActivePattern->params) & PATTERN_SEEKABLE))
+        {
+            Skip(steps - 1);
+            update(this);
+            return;
+        }
+
+        if (steps > NEO_PATTERNS_MAX_CATCH_UP_STEPS)
+        {
+            steps = NEO_PATTERNS_MAX_CATCH_UP_STEPS;
+        }
+        while (steps-- > 0)
+        {
+            update(this);
+        }
+    }
+
+    // Start a pattern from its descriptor (in flash)
+    void Start(const sPatternDescriptor *descriptor, uint8_t interval, uint32_t color1 = 0, uint32_t color2 = 0,
+               uint16_t steps = 0, direction dir = FORWARD)
+    {
+        uint8_t params = pgm_read_byte(&descriptor->params);
+        void (*init)(NeoPatterns *) = (void (*)(NeoPatterns *))pgm_read_ptr(&descriptor->init);
+
+        ActivePattern = descriptor;
+        Interval = interval;
+        lastUpdate = millis() - interval;  // first step is due now
+        Index = 0;
+        Direction = (params & PATTERN_PARAM_DIRECTION) ? dir : FORWARD;
+        if (params & PATTERN_PARAM_COLOR1)
+        {
+            Color1 = color1;
+        }
+        if (params & PATTERN_PARAM_COLOR2)
+        {
+            Color2 = color2;
+        }
+        if (params & PATTERN_PARAM_STEPS)
+        {
+            TotalSteps = steps;
+        }
+        if (init != NULL)
+        {
+            init(this);
         }
     }
+
+    // Start one of the built in patterns
+    void Start(pattern type, uint8_t interval, uint32_t color1 = 0, uint32_t color2 = 0,
+               uint16_t steps = 0, direction dir = FORWARD);
   
     // Increment the Index and reset at the end
     void Increment()
@@ -91,6 +559,20 @@ class NeoPatterns : public Adafruit_NeoPixel
         }
     }
     
+    // Move steps on without drawing them.  Whole cycles are left out, and
+    // so are their OnComplete calls.
+    void Skip(unsigned long steps)
+    {
+        if (TotalSteps > 0)
+        {
+            steps %= TotalSteps;
+        }
+        while (steps-- > 0)
+        {
+            Increment();
+        }
+    }
+
     // Reverse pattern direction
     void Reverse()
     {
@@ -109,19 +591,25 @@ class NeoPatterns : public Adafruit_NeoPixel
     // Initialize for a RainbowCycle
     void RainbowCycle(uint8_t interval, direction dir = FORWARD)
     {
-        ActivePattern = RAINBOW_CYCLE;
-        Interval = interval;
+        Start(RAINBOW_CYCLE, interval, 0, 0, 0, dir);
+    }
+
+    void RainbowCycleInit()
+    {
         TotalSteps = 255;
-        Index = 0;
-        Direction = dir;
+        // One division here instead of one per pixel per frame
+        HueStep = (numPixels() > 0) ? (uint16_t)(65536UL / numPixels()) : 0;
     }
     
     // Update the Rainbow Cycle Pattern
     void RainbowCycleUpdate()
     {
-        for(int i=0; i< (int)numPixels(); i++)
+        uint16_t hue = Index << 8;  // 8.8 fixed point wheel position
+
+        for(uint16_t i=0; i < numPixels(); i++)
         {
-            setPixelColor(i, Wheel(((i * 256 / numPixels()) + Index) & 255));
+            setPixelColor(i, Wheel(hue >> 8));
+            hue += HueStep;
         }
         show();
         Increment();
@@ -130,14 +618,14 @@ class NeoPatterns : public Adafruit_NeoPixel
     // Initialize for a Theater Chase
     void TheaterChase(uint32_t color1, uint32_t color2, uint8_t interval, direction dir = FORWARD)
     {
-        ActivePattern = THEATER_CHASE;
-        Interval = interval;
-        TotalSteps = numPixels();
-        Color1 = color1;
-        Color2 = color2;
-        Index = 0;
-        Direction = dir;
-   }
+        Start(THEATER_CHASE, interval, color1, color2, 0, dir);
+    }
+
+    void TheaterChaseInit()
+    {
+        // A multiple of the 3 pixel period, so the chase wraps without a jump
+        TotalSteps = ((numPixels() + 2) / 3) * 3;
+    }
     
     // Update the Theater Chase Pattern
     void TheaterChaseUpdate()
@@ -160,12 +648,12 @@ class NeoPatterns : public Adafruit_NeoPixel
     // Initialize for a ColorWipe
     void ColorWipe(uint32_t color, uint8_t interval, direction dir = FORWARD)
     {
-        ActivePattern = COLOR_WIPE;
-        Interval = interval;
+        Start(COLOR_WIPE, interval, color, 0, 0, dir);
+    }
+
+    void ColorWipeInit()
+    {
         TotalSteps = numPixels();
-        Color1 = color;
-        Index = 0;
-        Direction = dir;
     }
     
     // Update the Color Wipe Pattern
@@ -179,11 +667,12 @@ class NeoPatterns : public Adafruit_NeoPixel
     // Initialize for a SCANNNER
     void Scanner(uint32_t color1, uint8_t interval)
     {
-        ActivePattern = SCANNER;
-        Interval = interval;
+        Start(SCANNER, interval, color1);
+    }
+
+    void ScannerInit()
+    {
         TotalSteps = (numPixels() - 1) * 2;
-        Color1 = color1;
-        Index = 0;
     }
 
     // Update the Scanner Pattern
@@ -201,7 +690,7 @@ class NeoPatterns : public Adafruit_NeoPixel
             }
             else // Fading tail
             {
-                 setPixelColor(i, DimColor(getPixelColor(i)));
+                 DimPixel(i);
             }
         }
         show();
@@ -211,13 +700,7 @@ class NeoPatterns : public Adafruit_NeoPixel
     // Initialize for a Fade
     void Fade(uint32_t color1, uint32_t color2, uint16_t steps, uint8_t interval, direction dir = FORWARD)
     {
-        ActivePattern = FADE;
-        Interval = interval;
-        TotalSteps = steps;
-        Color1 = color1;
-        Color2 = color2;
-        Index = 0;
-        Direction = dir;
+        Start(FADE, interval, color1, color2, steps, dir);
     }
     
     // Update the Fade Pattern
@@ -234,7 +717,23 @@ class NeoPatterns : public Adafruit_NeoPixel
         Increment();
     }
    
-    // Calculate 50% dimmed version of a color (used by ScannerUpdate)
+    // Halve a pixel in the render buffer.  Works on the stored bytes, so
+    // there is no unpack/repack and the channel order does not matter.
+    void DimPixel(uint16_t n)
+    {
+        uint8_t *p = &pixels[n * BytesPerPixel()];
+
+        for (uint8_t c = 0; c < BytesPerPixel(); c++)
+        {
+            if (p[c] != 0)
+            {
+                p[c] >>= 1;
+                FrameDirty = true;
+            }
+        }
+    }
+
+    // Calculate 50% dimmed version of a color
     uint32_t DimColor(uint32_t color)
     {
         // Shift R, G and B components one bit to the right
@@ -270,26 +769,83 @@ class NeoPatterns : public Adafruit_NeoPixel
         return color & 0xFF;
     }
     
+    // Output stage defaults (no table, no wire buffer)
+    void InitOutputStage()
+    {
+        OutputLut = NULL;
+        WireBuffer = NULL;
+        DitherFrames = 0;
+        DitherPhase = 0;
+        OutputStale = true;
+    }
+
+    // Bytes of pixel data effects render into (capacity for a fixed buffer)
+    uint16_t RenderBufferBytes()
+    {
+        return (StaticBuffer != NULL) ? StaticBufferSize : numBytes;
+    }
+
+    // Bytes of output stage data (0 without a WireBuffer)
+    uint16_t WireBufferBytes()
+    {
+        return (WireBuffer != NULL) ? RenderBufferBytes() : 0;
+    }
+
+    // Number of bytes stored per pixel (3 for RGB, 4 for RGBW strips)
+    uint8_t BytesPerPixel()
+    {
+        return (wOffset == rOffset) ? 3 : 4;
+    }
+
+    // Returns the raw stored bytes of a pixel packed into 32 bits
+    uint32_t PixelBytes(const uint8_t *p)
+    {
+        uint32_t bytes = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+        if (BytesPerPixel() == 4)
+        {
+            bytes = (bytes << 8) | p[3];
+        }
+        return bytes;
+    }
+
     // Input a value 0 to 255 to get a color value.
     // The colours are a transition r - g - b - back to r.
     uint32_t Wheel(byte WheelPos)
     {
-        WheelPos = 255 - WheelPos;
-        if(WheelPos < 85)
-        {
-            return Color(255 - WheelPos * 3, 0, WheelPos * 3);
-        }
-        else if(WheelPos < 170)
-        {
-            WheelPos -= 85;
-            return Color(0, WheelPos * 3, 255 - WheelPos * 3);
-        }
-        else
-        {
-            WheelPos -= 170;
-            return Color(WheelPos * 3, 255 - WheelPos * 3, 0);
-        }
+        const uint8_t *rgb = NeoPatternsWheel[WheelPos];
+        return Color(pgm_read_byte(&rgb[0]), pgm_read_byte(&rgb[1]), pgm_read_byte(&rgb[2]));
     }
 };
 
+// Descriptor hooks of the built in patterns.  Each is a real function (it is
+// called through a pointer), so its flash cost shows up by name in the map
+// or in avr-nm --size-sort output.
+inline void neo_pattern_rainbow_cycle_init(NeoPatterns *strip) { strip->RainbowCycleInit(); }
+inline void neo_pattern_rainbow_cycle_update(NeoPatterns *strip) { strip->RainbowCycleUpdate(); }
+inline void neo_pattern_theater_chase_init(NeoPatterns *strip) { strip->TheaterChaseInit(); }
+inline void neo_pattern_theater_chase_update(NeoPatterns *strip) { strip->TheaterChaseUpdate(); }
+inline void neo_pattern_color_wipe_init(NeoPatterns *strip) { strip->ColorWipeInit(); }
+inline void neo_pattern_color_wipe_update(NeoPatterns *strip) { strip->ColorWipeUpdate(); }
+inline void neo_pattern_scanner_init(NeoPatterns *strip) { strip->ScannerInit(); }
+inline void neo_pattern_scanner_update(NeoPatterns *strip) { strip->ScannerUpdate(); }
+inline void neo_pattern_fade_update(NeoPatterns *strip) { strip->FadeUpdate(); }
+
+// Built in patterns, indexed by pattern
+const sPatternDescriptor NeoPatternsRegistry[PATTERN_COUNT] PROGMEM = {
+    { NULL, NULL, 0 },  // NONE
+    { neo_pattern_rainbow_cycle_init, neo_pattern_rainbow_cycle_update, PATTERN_PARAM_DIRECTION | PATTERN_SEEKABLE },
+    { neo_pattern_theater_chase_init, neo_pattern_theater_chase_update,
+      PATTERN_PARAM_COLOR1 | PATTERN_PARAM_COLOR2 | PATTERN_PARAM_DIRECTION | PATTERN_SEEKABLE },
+    { neo_pattern_color_wipe_init, neo_pattern_color_wipe_update, PATTERN_PARAM_COLOR1 | PATTERN_PARAM_DIRECTION },
+    { neo_pattern_scanner_init, neo_pattern_scanner_update, PATTERN_PARAM_COLOR1 },
+    { NULL, neo_pattern_fade_update,
+      PATTERN_PARAM_COLOR1 | PATTERN_PARAM_COLOR2 | PATTERN_PARAM_STEPS | PATTERN_PARAM_DIRECTION | PATTERN_SEEKABLE }
+};
+
+inline void NeoPatterns::Start(pattern type, uint8_t interval, uint32_t color1, uint32_t color2,
+                               uint16_t steps, direction dir)
+{
+    Start(&NeoPatternsRegistry[type], interval, color1, color2, steps, dir);
+}
+
 #endif /* _NEO_PATTERNS_H */
\ No newline at end of file
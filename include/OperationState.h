@@ -0,0 +1,24 @@
+#ifndef _OPERATION_STATE_H
+#define _OPERATION_STATE_H
+
+// Operating states of the nav light controller
+typedef enum e_operation_state {
+    OPERATION_STATE_INIT,
+    OPERATION_STATE_CONFIG_MAIN_ON_NAV,
+    OPERATION_STATE_CONFIG_MAIN_ON_STROBE,
+    OPERATION_STATE_CONFIG_MAIN_ON_BEACON,
+    OPERATION_STATE_CONFIG_MAIN_ON_LANDING,
+    OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET,
+    OPERATION_STATE_CONFIG_IN_NAV,             
+    OPERATION_STATE_CONFIG_IN_STROBE,          
+    OPERATION_STATE_CONFIG_IN_BEACON,
+    OPERATION_STATE_CONFIG_IN_LANDING,
+    OPERATION_STATE_CONFIG_IN_FACTORY_RESET,
+    OPERATION_STATE_NORMAL,
+    OPERATION_STATE_RAINBOW,
+    OPERATION_STATE_CHASE,
+    OPERATION_STATE_FAILSAFE,                  // RC signal lost (see check_rc_signal())
+    OPERATION_STATE_COUNT
+} eOperationState;
+
+#endif /* _OPERATION_STATE_H */
@@ -0,0 +1,83 @@
+#ifndef _PIN_CHANGE_DECODER_H
+#define _PIN_CHANGE_DECODER_H
+
+#include <Arduino.h>
+
+// Inputs of one port (bit per input)
+#define PIN_CHANGE_MAX_INPUTS 8
+
+// PinChangeDecoder Class - turns snapshots of a port's input levels into
+// high pulse widths, for RC PWM inputs on pin change interrupts.  The pin
+// change ISR only stores the levels and a timestamp whenever any watched
+// bit changed (one sample however many pins changed together); this runs
+// in loop() and finds each input's rising and falling edges by comparing
+// a sample with the one before.  Intervals use unsigned 32-bit arithmetic,
+// so micros() wraparound is harmless.
+class PinChangeDecoder
+{
+    public:
+
+    // Member Variables:
+    uint8_t Mask;                                   // inputs decoded
+    uint8_t Levels;                                 // levels of the last sample
+    uint8_t Rising;                                 // inputs whose rise time is known
+    uint32_t RiseTime[PIN_CHANGE_MAX_INPUTS];
+    uint16_t Width[PIN_CHANGE_MAX_INPUTS];          // last complete high pulse
+
+    // Constructor
+    PinChangeDecoder(uint8_t mask)
+    {
+        Mask = mask;
+        Levels = 0;
+        Rising = 0;
+    }
+
+    // Start from the levels the port has now (no pulse in progress)
+    void Begin(uint8_t levels)
+    {
+        Levels = levels & Mask;
+        Rising = 0;
+    }
+
+    // Forget the pulses in progress, e.g. after samples were lost
+    void Resync()
+    {
+        Rising = 0;
+    }
+
+    // Feed one sample.  Returns the inputs (bit per input) whose high pulse
+    // ended with it; their widths are in Width[].
+    uint8_t AddSample(uint8_t levels, uint32_t time_in_micro_seconds)
+    {
+        uint8_t changed;
+        uint8_t rose;
+        uint8_t complete;
+
+        levels &= Mask;
+        changed = levels ^ Levels;
+        rose = changed & levels;
+        complete = changed & ~levels & Rising;
+        Levels = levels;
+        Rising = (Rising & ~changed) | rose;
+
+        for (uint8_t i = 0; i < PIN_CHANGE_MAX_INPUTS; i++)
+        {
+            uint8_t bit = (1 << i);
+
+            if (rose & bit)
+            {
+                RiseTime[i] = time_in_micro_seconds;
+            }
+            else if (complete & bit)
+            {
+                uint32_t width = time_in_micro_seconds - RiseTime[i];
+
+                Width[i] = (width > 0xFFFF) ? 0xFFFF : (uint16_t)width;
+            }
+        }
+
+        return complete;
+    }
+};
+
+#endif /* _PIN_CHANGE_DECODER_H */
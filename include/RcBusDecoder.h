@@ -0,0 +1,327 @@
+#ifndef _RC_BUS_DECODER_H
+#define _RC_BUS_DECODER_H
+
+#include <Arduino.h>
+
+// Most channels a frame carries (SBUS has 16, iBUS 14, PPM usually 8)
+#define RC_BUS_MAX_CHANNELS 16
+
+// PPM: intervals between the rising edges that start each channel.  A
+// frame ends with a sync gap at least RC_PPM_MIN_SYNC long and needs at
+// least RC_PPM_MIN_CHANNELS channels.
+#define RC_PPM_MIN_CHANNEL_IN_MICRO_SECONDS 700
+#define RC_PPM_MAX_CHANNEL_IN_MICRO_SECONDS 2300
+#define RC_PPM_MIN_SYNC_IN_MICRO_SECONDS 2700
+#define RC_PPM_MIN_CHANNELS 4
+
+// SBUS: 25 byte frames at 100000 baud 8E2 (inverted), every 7 or 14ms
+#define RC_SBUS_FRAME_SIZE 25
+#define RC_SBUS_START 0x0F
+#define RC_SBUS_FLAG_FRAME_LOST 0x04
+#define RC_SBUS_FLAG_FAILSAFE 0x08
+
+// iBUS: 32 byte frames at 115200 baud 8N1, every 7ms
+#define RC_IBUS_FRAME_SIZE 32
+#define RC_IBUS_LENGTH 0x20
+#define RC_IBUS_COMMAND_CHANNELS 0x40
+#define RC_IBUS_CHANNELS 14
+
+// A decoded frame: every channel as a servo pulse width
+typedef struct s_rc_bus_frame {
+    uint16_t channels[RC_BUS_MAX_CHANNELS];   // micro seconds
+    uint8_t channel_count;
+    bool failsafe;              // the receiver has lost the transmitter (SBUS)
+} sRcBusFrame;
+
+// PpmDecoder Class - decodes a PPM sum signal from the timestamps of its
+// rising edges (one per channel plus one ending the last channel), fed one
+// at a time.  Channels are only published once a sync gap ends a frame
+// whose every interval was in range, so Frame always holds a whole frame.
+// Intervals use unsigned 32-bit arithmetic, so micros() wraparound is
+// harmless.
+class PpmDecoder
+{
+    public:
+
+    // Member Variables:
+    sRcBusFrame Frame;          // the last complete frame
+    uint16_t Pending[RC_BUS_MAX_CHANNELS];
+    uint8_t PendingCount;
+    bool Synced;                // a sync gap has been seen since the last error
+    bool HasEdge;
+    uint32_t LastEdge;
+    uint32_t PendingStart;      // first edge of the frame being received
+    uint32_t FrameStart;        // first and last edge of Frame's pulse train
+    uint32_t FrameEnd;
+
+    uint16_t FramesReceived;
+    uint16_t FrameErrors;
+
+    // Constructor
+    PpmDecoder()
+    {
+        memset(&Frame, 0, sizeof(Frame));
+        PendingCount = 0;
+        Synced = false;
+        HasEdge = false;
+        FramesReceived = 0;
+        FrameErrors = 0;
+    }
+
+    // Feed one rising edge.  Returns true when it completes a valid frame.
+    bool AddEdge(uint32_t edge_time_in_micro_seconds)
+    {
+        uint32_t interval = edge_time_in_micro_seconds - LastEdge;
+        bool had_edge = HasEdge;
+        bool complete = false;
+
+        LastEdge = edge_time_in_micro_seconds;
+        HasEdge = true;
+
+        if (!had_edge)
+        {
+            return false;
+        }
+
+        if (interval >= RC_PPM_MIN_SYNC_IN_MICRO_SECONDS)
+        {
+            if (Synced && PendingCount >= RC_PPM_MIN_CHANNELS)
+            {
+                memcpy(Frame.channels, Pending, PendingCount * sizeof(Pending[0]));
+                Frame.channel_count = PendingCount;
+                FrameStart = PendingStart;
+                FrameEnd = edge_time_in_micro_seconds - interval;
+                FramesReceived++;
+                complete = true;
+            }
+            else if (Synced)
+            {
+                FrameErrors++;
+            }
+
+            Synced = true;
+            PendingCount = 0;
+            PendingStart = edge_time_in_micro_seconds;
+            return complete;
+        }
+
+        if (!Synced)
+        {
+            return false;
+        }
+
+        if (interval < RC_PPM_MIN_CHANNEL_IN_MICRO_SECONDS
+                || interval > RC_PPM_MAX_CHANNEL_IN_MICRO_SECONDS
+                || PendingCount >= RC_BUS_MAX_CHANNELS)
+        {
+            // A glitch or a lost edge: drop the frame and wait for sync
+            FrameErrors++;
+            Synced = false;
+            return false;
+        }
+
+        Pending[PendingCount++] = (uint16_t)interval;
+
+        return false;
+    }
+};
+
+// SbusParser Class - incremental SBUS frame decoder, fed one byte at a
+// time.  The 11-bit channels are unpacked as the bytes arrive, so no frame
+// buffer is kept; Frame is only updated once the end byte checks out.  A
+// bad end byte drops the frame and the parser hunts for a start byte right
+// after an end byte (0x0F is common in channel data, so a start byte alone
+// could keep it out of step with back to back frames).
+class SbusParser
+{
+    public:
+
+    // Member Variables:
+    sRcBusFrame Frame;          // the last complete frame
+    uint16_t Pending[RC_BUS_MAX_CHANNELS];
+    uint8_t Received;           // bytes of the current frame, 0 = hunting
+    uint8_t PendingCount;
+    uint8_t Bits;               // bits waiting in Accumulator
+    uint32_t Accumulator;
+    uint8_t Flags;
+    uint8_t Previous;           // the byte before, while hunting
+
+    uint16_t FramesReceived;
+    uint16_t FrameErrors;
+    uint16_t FramesLost;        // frames the receiver reported lost
+
+    // Constructor
+    SbusParser()
+    {
+        memset(&Frame, 0, sizeof(Frame));
+        Received = 0;
+        Previous = 0x00;        // the line has been idle
+        FramesReceived = 0;
+        FrameErrors = 0;
+        FramesLost = 0;
+    }
+
+    // Feed one byte.  Returns true when it completes a valid frame.
+    bool Feed(uint8_t c)
+    {
+        if (Received == 0)
+        {
+            if (c == RC_SBUS_START && IsEnd(Previous))
+            {
+                Received = 1;
+                PendingCount = 0;
+                Bits = 0;
+                Accumulator = 0;
+            }
+            Previous = c;
+            return false;
+        }
+
+        Received++;
+
+        if (Received < RC_SBUS_FRAME_SIZE - 1)
+        {
+            // Channel data, least significant bit first
+            Accumulator |= (uint32_t)c << Bits;
+            Bits += 8;
+            if (Bits >= 11)
+            {
+                Pending[PendingCount++] = ToMicroSeconds(Accumulator & 0x7FF);
+                Accumulator >>= 11;
+                Bits -= 11;
+            }
+            return false;
+        }
+
+        if (Received == RC_SBUS_FRAME_SIZE - 1)
+        {
+            Flags = c;
+            return false;
+        }
+
+        Received = 0;
+        Previous = c;
+
+        if (!IsEnd(c))
+        {
+            FrameErrors++;
+            return false;
+        }
+
+        memcpy(Frame.channels, Pending, sizeof(Pending));
+        Frame.channel_count = RC_BUS_MAX_CHANNELS;
+        Frame.failsafe = (Flags & RC_SBUS_FLAG_FAILSAFE) != 0;
+        if (Flags & RC_SBUS_FLAG_FRAME_LOST)
+        {
+            FramesLost++;
+        }
+        FramesReceived++;
+
+        return true;
+    }
+
+    // End byte: 0x00, or SBUS2's 0x04/0x14/0x24/0x34
+    static bool IsEnd(uint8_t c)
+    {
+        return c == 0x00 || (c & 0xCF) == 0x04;
+    }
+
+    // 172..1811 is 987..2011 us, 992 the 1500 us center
+    static uint16_t ToMicroSeconds(uint16_t value)
+    {
+        return (uint16_t)(((uint32_t)value * 5) >> 3) + 880;
+    }
+};
+
+// IbusParser Class - incremental FlySky iBUS servo frame decoder, fed one
+// byte at a time.  The checksum is kept running and the channels are
+// staged as they arrive, so Frame is only updated by a frame that checks
+// out.  Anything else drops the frame and the parser hunts for the next
+// length byte.
+class IbusParser
+{
+    public:
+
+    // Member Variables:
+    sRcBusFrame Frame;          // the last complete frame
+    uint16_t Pending[RC_IBUS_CHANNELS];
+    uint8_t Received;           // bytes of the current frame, 0 = hunting
+    uint16_t Sum;               // of the bytes before the checksum
+    uint8_t Low;                // low byte of the word being received
+
+    uint16_t FramesReceived;
+    uint16_t FrameErrors;
+
+    // Constructor
+    IbusParser()
+    {
+        memset(&Frame, 0, sizeof(Frame));
+        Received = 0;
+        FramesReceived = 0;
+        FrameErrors = 0;
+    }
+
+    // Feed one byte.  Returns true when it completes a valid frame.
+    bool Feed(uint8_t c)
+    {
+        if (Received == 0)
+        {
+            if (c == RC_IBUS_LENGTH)
+            {
+                Received = 1;
+                Sum = c;
+            }
+            return false;
+        }
+
+        if (Received == 1)
+        {
+            if (c != RC_IBUS_COMMAND_CHANNELS)
+            {
+                Received = (c == RC_IBUS_LENGTH) ? 1 : 0;
+                return false;
+            }
+            Received = 2;
+            Sum += c;
+            return false;
+        }
+
+        uint8_t index = Received++;
+
+        if ((index & 1) == 0)
+        {
+            Low = c;
+            if (index < RC_IBUS_FRAME_SIZE - 2)
+            {
+                Sum += c;
+            }
+            return false;
+        }
+
+        uint16_t word = Low | ((uint16_t)c << 8);
+
+        if (index < RC_IBUS_FRAME_SIZE - 2)
+        {
+            Sum += c;
+            Pending[(index - 3) / 2] = word & 0x0FFF;  // the top nibble carries extra channels
+            return false;
+        }
+
+        Received = 0;
+
+        if (word != (uint16_t)(0xFFFF - Sum))
+        {
+            FrameErrors++;
+            return false;
+        }
+
+        memcpy(Frame.channels, Pending, sizeof(Pending));
+        Frame.channel_count = RC_IBUS_CHANNELS;
+        Frame.failsafe = false;
+        FramesReceived++;
+
+        return true;
+    }
+};
+
+#endif /* _RC_BUS_DECODER_H */
@@ -0,0 +1,222 @@
+#ifndef _RC_FRAME_SCHEDULER_H
+#define _RC_FRAME_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Accepted RC frame periods (standard receivers repeat every 20ms, fast
+// ones every 10-14ms)
+#define RC_FRAME_MIN_PERIOD_IN_MICRO_SECONDS 5000
+#define RC_FRAME_MAX_PERIOD_IN_MICRO_SECONDS 35000
+
+// Period changes smaller than this count as the same frame rate
+#define RC_FRAME_PERIOD_TOLERANCE_IN_MICRO_SECONDS 200
+
+// Consecutive consistent periods needed before a channel's phase is trusted
+#define RC_FRAME_LOCK_COUNT 2
+
+// A locked channel is dropped after this many periods without a pulse
+#define RC_FRAME_STALE_PERIODS 3
+
+// Per-channel frame timing
+typedef struct s_rc_frame_channel {
+    uint32_t last_pulse_start_in_micro_seconds;
+    uint16_t period_in_micro_seconds;
+    uint16_t pulse_width_in_micro_seconds;
+    uint8_t consistent_periods;
+    bool has_pulse;
+} sRcFrameChannel;
+
+// RcFrameScheduler Class - learns the frame period and pulse phase of each
+// RC channel from decoded pulses and predicts when the next edges will
+// arrive, so that work which masks interrupts (show()) can be started in the
+// dead time between pulses.  Channels that are not locked (no signal, or an
+// irregular one) impose no restriction, so without a receiver every request
+// is granted at once.  A request that has been held back for longer than
+// MaxHoldTime is granted anyway, so outputs can never starve.
+template <uint8_t Channels>
+class RcFrameScheduler
+{
+    public:
+
+    // Member Variables:
+    sRcFrameChannel Channel[Channels];
+
+    uint16_t GuardTime;          // margin kept clear around each predicted pulse
+    uint16_t MaxHoldTime;        // longest a request may be held back
+
+    bool Holding;                // the current request has been held back
+    uint32_t HoldStart;          // micros() of the first refusal
+
+    uint32_t ShowsDeferred;      // requests refused (one per attempt)
+    uint32_t CollisionsAvoided;  // held requests later granted in a gap
+    uint32_t ShowsForced;        // held requests granted after MaxHoldTime
+    uint32_t ShowsUnscheduled;   // requests granted with no channel locked
+
+    // Constructor
+    RcFrameScheduler(uint16_t guard_time, uint16_t max_hold_time)
+    {
+        GuardTime = guard_time;
+        MaxHoldTime = max_hold_time;
+        Holding = false;
+        HoldStart = 0;
+        ResetCounters();
+
+        for (uint8_t i = 0; i < Channels; i++)
+        {
+            Reset(i);
+        }
+    }
+
+    // Forget the timing of a channel
+    void Reset(uint8_t channel)
+    {
+        Channel[channel].has_pulse = false;
+        Channel[channel].consistent_periods = 0;
+        Channel[channel].period_in_micro_seconds = 0;
+        Channel[channel].pulse_width_in_micro_seconds = 0;
+    }
+
+    void ResetCounters()
+    {
+        ShowsDeferred = 0;
+        CollisionsAvoided = 0;
+        ShowsForced = 0;
+        ShowsUnscheduled = 0;
+    }
+
+    // Record a decoded pulse that ended at pulse_end with the given width
+    void AddPulse(uint8_t channel, uint32_t pulse_end_in_micro_seconds, uint16_t width)
+    {
+        sRcFrameChannel *ch = &Channel[channel];
+        uint32_t start = pulse_end_in_micro_seconds - width;
+
+        ch->pulse_width_in_micro_seconds = width;
+
+        if (ch->has_pulse)
+        {
+            uint32_t interval = start - ch->last_pulse_start_in_micro_seconds;
+
+            if (interval < RC_FRAME_MIN_PERIOD_IN_MICRO_SECONDS
+                    || interval > RC_FRAME_MAX_PERIOD_IN_MICRO_SECONDS)
+            {
+                ch->consistent_periods = 0;   // missed pulses or noise
+            }
+            else if (Difference(interval, ch->period_in_micro_seconds)
+                    <= RC_FRAME_PERIOD_TOLERANCE_IN_MICRO_SECONDS)
+            {
+                // Same rate: track slow drift
+                ch->period_in_micro_seconds += ((int16_t)(interval - ch->period_in_micro_seconds)) / 4;
+                if (ch->consistent_periods < RC_FRAME_LOCK_COUNT)
+                {
+                    ch->consistent_periods++;
+                }
+            }
+            else
+            {
+                ch->period_in_micro_seconds = interval;
+                ch->consistent_periods = 0;
+            }
+        }
+
+        ch->last_pulse_start_in_micro_seconds = start;
+        ch->has_pulse = true;
+    }
+
+    // Returns true if a channel's period and phase are known
+    bool IsLocked(uint8_t channel, uint32_t now)
+    {
+        const sRcFrameChannel *ch = &Channel[channel];
+
+        return ch->has_pulse
+                && ch->consistent_periods >= RC_FRAME_LOCK_COUNT
+                && now - ch->last_pulse_start_in_micro_seconds
+                        < (uint32_t)ch->period_in_micro_seconds * RC_FRAME_STALE_PERIODS;
+    }
+
+    // May something that masks interrupts for duration start at now?
+    bool CanShow(uint32_t now, uint16_t duration)
+    {
+        bool any_locked = false;
+        bool clear = true;
+
+        for (uint8_t i = 0; i < Channels; i++)
+        {
+            if (IsLocked(i, now))
+            {
+                any_locked = true;
+                if (Overlaps(&Channel[i], now, duration))
+                {
+                    clear = false;
+                }
+            }
+        }
+
+        if (!any_locked)
+        {
+            ShowsUnscheduled++;
+            Holding = false;
+            return true;
+        }
+
+        if (clear)
+        {
+            if (Holding)
+            {
+                CollisionsAvoided++;
+                Holding = false;
+            }
+            return true;
+        }
+
+        if (!Holding)
+        {
+            Holding = true;
+            HoldStart = now;
+        }
+        else if (now - HoldStart > MaxHoldTime)
+        {
+            ShowsForced++;
+            Holding = false;
+            return true;
+        }
+
+        ShowsDeferred++;
+        return false;
+    }
+
+    private:
+
+    // Does [now, now + duration] touch the current or next predicted pulse
+    // of a channel (widened by GuardTime on both sides)?
+    bool Overlaps(const sRcFrameChannel *ch, uint32_t now, uint16_t duration)
+    {
+        uint32_t period = ch->period_in_micro_seconds;
+        uint32_t since_start = now - ch->last_pulse_start_in_micro_seconds;
+
+        // Start of the latest predicted pulse at or before now
+        uint32_t pulse_start = ch->last_pulse_start_in_micro_seconds + (since_start / period) * period;
+
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            uint32_t window_start = pulse_start - GuardTime;
+            uint32_t window_length = ch->pulse_width_in_micro_seconds + 2 * (uint32_t)GuardTime;
+
+            // Two intervals intersect if either starts inside the other
+            if (now - window_start < window_length || window_start - now <= duration)
+            {
+                return true;
+            }
+
+            pulse_start += period;
+        }
+
+        return false;
+    }
+
+    static uint16_t Difference(uint32_t a, uint32_t b)
+    {
+        return (a > b) ? a - b : b - a;
+    }
+};
+
+#endif /* _RC_FRAME_SCHEDULER_H */
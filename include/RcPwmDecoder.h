@@ -0,0 +1,271 @@
+#ifndef _RC_PWM_DECODER_H
+#define _RC_PWM_DECODER_H
+
+#include <Arduino.h>
+
+// Consecutive good (or bad) pulses needed to make a channel valid (or invalid)
+#define RC_PWM_VALID_PULSE_COUNT 3
+#define RC_PWM_INVALID_PULSE_COUNT 3
+
+// Maps a pulse width onto switch positions.  Position n covers the widths
+// between boundaries[n - 1] and boundaries[n]; to change position the width
+// has to cross a boundary by more than hysteresis_in_micro_seconds.
+typedef struct s_rc_detent_map {
+    const uint16_t *boundaries;           // ascending, in PROGMEM
+    uint8_t boundary_count;               // positions = boundary_count + 1
+    uint16_t hysteresis_in_micro_seconds;
+} sRcDetentMap;
+
+// Per-channel decoder state
+typedef struct s_rc_pwm_channel {
+    const sRcDetentMap *detents;
+    uint32_t last_edge_time_in_micro_seconds;
+    uint16_t samples[3];          // last raw pulse widths (median filter)
+    uint16_t filtered_q4;         // IIR filtered pulse width, 1/16 us
+    uint16_t pulse_width_in_micro_seconds;
+    uint8_t sample_count;
+    uint8_t position;
+    uint8_t good_pulses;
+    uint8_t bad_pulses;
+    bool has_edge;
+    bool valid;
+} sRcPwmChannel;
+
+// RcPwmDecoder Class - decodes RC receiver servo pulses on N channels from
+// edge timestamps (any edge; the high pulse is told apart from the frame gap
+// by its length).  Intervals use unsigned 32-bit arithmetic so micros()
+// wraparound is harmless.  Each accepted width goes through a median-of-3
+// filter (rejects single-sample glitches) and an IIR low pass, and is then
+// mapped onto detent positions with hysteresis.
+template <uint8_t Channels>
+class RcPwmDecoder
+{
+    public:
+
+    // Member Variables:
+    sRcPwmChannel Channel[Channels];
+
+    uint16_t MinPulseWidth;   // shortest interval accepted as a pulse
+    uint16_t MaxPulseWidth;   // longest interval accepted as a pulse
+    uint8_t FilterShift;      // IIR strength: new = old + (sample - old) >> FilterShift
+
+    // Constructor
+    RcPwmDecoder(uint16_t min_pulse_width, uint16_t max_pulse_width, uint8_t filter_shift)
+    {
+        MinPulseWidth = min_pulse_width;
+        MaxPulseWidth = max_pulse_width;
+        FilterShift = filter_shift;
+
+        for (uint8_t i = 0; i < Channels; i++)
+        {
+            Channel[i].detents = NULL;
+            Reset(i);
+        }
+    }
+
+    // Assign the switch positions of a channel
+    void SetDetentMap(uint8_t channel, const sRcDetentMap *detents)
+    {
+        Channel[channel].detents = detents;
+        Channel[channel].position = 0;
+    }
+
+    // Forget everything decoded on a channel (e.g. after signal loss)
+    void Reset(uint8_t channel)
+    {
+        sRcPwmChannel *ch = &Channel[channel];
+
+        ch->has_edge = false;
+        ch->sample_count = 0;
+        ch->good_pulses = 0;
+        ch->bad_pulses = 0;
+        ch->valid = false;
+        ch->position = 0;
+        ch->pulse_width_in_micro_seconds = 0;
+        ch->filtered_q4 = 0;
+    }
+
+    // Feed one edge.  Returns true if it completed a pulse that was accepted.
+    bool AddEdge(uint8_t channel, uint32_t edge_time_in_micro_seconds)
+    {
+        sRcPwmChannel *ch = &Channel[channel];
+        uint32_t interval = edge_time_in_micro_seconds - ch->last_edge_time_in_micro_seconds;
+        bool had_edge = ch->has_edge;
+
+        ch->last_edge_time_in_micro_seconds = edge_time_in_micro_seconds;
+        ch->has_edge = true;
+
+        if (!had_edge || interval > MaxPulseWidth)
+        {
+            return false;   // first edge or the gap between pulses
+        }
+
+        if (interval < MinPulseWidth)
+        {
+            // Too short for a pulse: a glitch
+            AddGlitch(ch);
+            return false;
+        }
+
+        AddPulse(ch, (uint16_t)interval);
+        return true;
+    }
+
+    // Feed a pulse width measured elsewhere (a PPM or serial bus frame).
+    // Returns true if it was accepted; widths out of range count as glitches.
+    bool AddPulseWidth(uint8_t channel, uint16_t width)
+    {
+        sRcPwmChannel *ch = &Channel[channel];
+
+        if (width < MinPulseWidth || width > MaxPulseWidth)
+        {
+            AddGlitch(ch);
+            return false;
+        }
+
+        AddPulse(ch, width);
+        return true;
+    }
+
+    // Returns the filtered pulse width of a channel
+    uint16_t PulseWidth(uint8_t channel)
+    {
+        return Channel[channel].pulse_width_in_micro_seconds;
+    }
+
+    // Returns the most recent unfiltered pulse width of a channel
+    uint16_t RawPulseWidth(uint8_t channel)
+    {
+        return Channel[channel].samples[0];
+    }
+
+    // Returns the detent position of a channel
+    uint8_t Position(uint8_t channel)
+    {
+        return Channel[channel].position;
+    }
+
+    // Returns true once enough consecutive good pulses have been decoded
+    bool IsValid(uint8_t channel)
+    {
+        return Channel[channel].valid;
+    }
+
+    private:
+
+    void AddGlitch(sRcPwmChannel *ch)
+    {
+        ch->good_pulses = 0;
+        if (ch->bad_pulses < RC_PWM_INVALID_PULSE_COUNT)
+        {
+            ch->bad_pulses++;
+        }
+        if (ch->bad_pulses >= RC_PWM_INVALID_PULSE_COUNT)
+        {
+            ch->valid = false;
+        }
+    }
+
+    void AddPulse(sRcPwmChannel *ch, uint16_t width)
+    {
+        ch->bad_pulses = 0;
+        ch->samples[2] = ch->samples[1];
+        ch->samples[1] = ch->samples[0];
+        ch->samples[0] = width;
+
+        if (ch->sample_count < 3)
+        {
+            ch->sample_count++;
+        }
+
+        uint16_t median = (ch->sample_count < 3) ? width
+                : Median(ch->samples[0], ch->samples[1], ch->samples[2]);
+
+        if (ch->good_pulses == 0 && !ch->valid)
+        {
+            ch->filtered_q4 = median << 4;   // (re)start the filter at the sample
+        }
+        else
+        {
+            int16_t delta = (int16_t)((median << 4) - ch->filtered_q4);
+            ch->filtered_q4 += delta >> FilterShift;
+        }
+
+        ch->pulse_width_in_micro_seconds = (ch->filtered_q4 + 8) >> 4;
+
+        if (ch->good_pulses < RC_PWM_VALID_PULSE_COUNT)
+        {
+            ch->good_pulses++;
+        }
+
+        if (!ch->valid && ch->good_pulses >= RC_PWM_VALID_PULSE_COUNT)
+        {
+            ch->valid = true;
+            ch->position = RawPosition(ch->detents, ch->pulse_width_in_micro_seconds);
+        }
+        else if (ch->valid)
+        {
+            ch->position = HysteresisPosition(ch->detents, ch->position,
+                    ch->pulse_width_in_micro_seconds);
+        }
+    }
+
+    static uint16_t Median(uint16_t a, uint16_t b, uint16_t c)
+    {
+        if (a > b)
+        {
+            uint16_t t = a; a = b; b = t;
+        }
+        if (b > c)
+        {
+            b = c;
+        }
+        return (a > b) ? a : b;
+    }
+
+    static uint16_t Boundary(const sRcDetentMap *detents, uint8_t index)
+    {
+        return pgm_read_word(&detents->boundaries[index]);
+    }
+
+    // Position without hysteresis (used when a channel becomes valid)
+    static uint8_t RawPosition(const sRcDetentMap *detents, uint16_t width)
+    {
+        uint8_t position = 0;
+
+        if (detents != NULL)
+        {
+            while (position < detents->boundary_count && width > Boundary(detents, position))
+            {
+                position++;
+            }
+        }
+
+        return position;
+    }
+
+    // Position only moves once the width is clear of the boundary band
+    static uint8_t HysteresisPosition(const sRcDetentMap *detents, uint8_t position, uint16_t width)
+    {
+        if (detents == NULL)
+        {
+            return 0;
+        }
+
+        while (position < detents->boundary_count
+                && width > Boundary(detents, position) + detents->hysteresis_in_micro_seconds)
+        {
+            position++;
+        }
+
+        while (position > 0
+                && width < Boundary(detents, position - 1) - detents->hysteresis_in_micro_seconds)
+        {
+            position--;
+        }
+
+        return position;
+    }
+};
+
+#endif /* _RC_PWM_DECODER_H */
@@ -0,0 +1,128 @@
+#ifndef _RC_SIGNAL_MONITOR_H
+#define _RC_SIGNAL_MONITOR_H
+
+#include <Arduino.h>
+
+// A channel is lost after this many of its frame periods without a valid
+// pulse, or after RC_SIGNAL_DEFAULT_TIMEOUT_IN_MICRO_SECONDS while its
+// period is not known yet
+#define RC_SIGNAL_TIMEOUT_PERIODS 2
+#define RC_SIGNAL_DEFAULT_TIMEOUT_IN_MICRO_SECONDS 50000
+
+// Per-channel signal state
+typedef struct s_rc_signal_channel {
+    uint32_t last_pulse_in_micro_seconds;   // end of the last valid pulse
+    uint32_t deadline_in_micro_seconds;     // lost if no valid pulse by then
+} sRcSignalChannel;
+
+// RcSignalMonitor Class - declares an RC channel lost once it goes quiet
+// for RC_SIGNAL_TIMEOUT_PERIODS frames.  Only channels that have delivered
+// a valid pulse are watched, so inputs without a receiver never count as
+// lost.  AddPulse() moves the channel's deadline on; Check() is meant for a
+// periodic tick (the frame clock) and costs a single comparison against the
+// earliest deadline until one passes.  Times use unsigned 32-bit arithmetic,
+// so micros() wraparound is harmless.  Up to 8 channels.
+template <uint8_t Channels>
+class RcSignalMonitor
+{
+    public:
+
+    // Member Variables:
+    sRcSignalChannel Channel[Channels];
+
+    uint8_t ActiveMask;         // channels being watched (bit per channel)
+    uint8_t LostMask;           // channels lost and not valid again since
+    uint32_t NextDeadline;      // earliest deadline of the active channels
+
+    uint16_t LossCount;         // channels lost so far
+
+    // Constructor
+    RcSignalMonitor()
+    {
+        ActiveMask = 0;
+        LostMask = 0;
+        NextDeadline = 0;
+        LossCount = 0;
+    }
+
+    // Record a valid pulse that ended at now.  period_in_micro_seconds is the
+    // channel's frame period, 0 if not known.
+    void AddPulse(uint8_t channel, uint32_t now, uint16_t period_in_micro_seconds)
+    {
+        sRcSignalChannel *ch = &Channel[channel];
+        uint32_t timeout = (period_in_micro_seconds != 0)
+                ? (uint32_t)period_in_micro_seconds * RC_SIGNAL_TIMEOUT_PERIODS
+                : RC_SIGNAL_DEFAULT_TIMEOUT_IN_MICRO_SECONDS;
+
+        ch->last_pulse_in_micro_seconds = now;
+        ch->deadline_in_micro_seconds = now + timeout;
+
+        ActiveMask |= (1 << channel);
+        LostMask &= ~(1 << channel);
+
+        UpdateNextDeadline(now);
+    }
+
+    // Forget every channel: live ones are watched again from their next
+    // valid pulse, lost ones no longer count as lost
+    void Reset()
+    {
+        ActiveMask = 0;
+        LostMask = 0;
+    }
+
+    // Returns the channels that were lost since the last call (bit per
+    // channel), 0 if none
+    uint8_t Check(uint32_t now)
+    {
+        uint8_t lost = 0;
+
+        if (ActiveMask == 0 || (int32_t)(now - NextDeadline) < 0)
+        {
+            return 0;
+        }
+
+        for (uint8_t i = 0; i < Channels; i++)
+        {
+            if ((ActiveMask & (1 << i)) && (int32_t)(now - Channel[i].deadline_in_micro_seconds) >= 0)
+            {
+                lost |= (1 << i);
+                LossCount++;
+            }
+        }
+
+        ActiveMask &= ~lost;
+        LostMask |= lost;
+
+        UpdateNextDeadline(now);
+
+        return lost;
+    }
+
+    // Returns true if the channel is lost (and not valid again since)
+    bool IsLost(uint8_t channel)
+    {
+        return (LostMask & (1 << channel)) != 0;
+    }
+
+    private:
+
+    void UpdateNextDeadline(uint32_t now)
+    {
+        int32_t earliest = 0x7FFFFFFF;
+
+        for (uint8_t i = 0; i < Channels; i++)
+        {
+            int32_t remaining = (int32_t)(Channel[i].deadline_in_micro_seconds - now);
+
+            if ((ActiveMask & (1 << i)) && remaining < earliest)
+            {
+                earliest = remaining;
+            }
+        }
+
+        NextDeadline = now + earliest;
+    }
+};
+
+#endif /* _RC_SIGNAL_MONITOR_H */
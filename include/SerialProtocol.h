@@ -0,0 +1,133 @@
+#ifndef _SERIAL_PROTOCOL_H
+#define _SERIAL_PROTOCOL_H
+
+#include <Arduino.h>
+#include "Crc16.h"
+
+// Frame layout:  SYNC  LENGTH  TYPE  PAYLOAD[LENGTH]  CRC_LO  CRC_HI
+// The CRC-16 covers LENGTH, TYPE and the payload.  Anything that is not a
+// frame (e.g. DEBUG text on the same port) is skipped while hunting for SYNC.
+#define SERIAL_FRAME_SYNC 0xA5
+#define SERIAL_FRAME_MAX_PAYLOAD 32
+#define SERIAL_FRAME_OVERHEAD 5
+#define SERIAL_FRAME_MAX_SIZE (SERIAL_FRAME_MAX_PAYLOAD + SERIAL_FRAME_OVERHEAD)
+
+// A decoded frame
+typedef struct s_serial_frame {
+    uint8_t type;
+    uint8_t length;
+    uint8_t payload[SERIAL_FRAME_MAX_PAYLOAD];
+} sSerialFrame;
+
+// Build a frame in buffer (at least SERIAL_FRAME_OVERHEAD + length bytes).
+// Returns the frame size, or 0 if the payload is too long.
+inline uint8_t serial_frame_encode(uint8_t *buffer, uint8_t type, const void *payload, uint8_t length)
+{
+    if (length > SERIAL_FRAME_MAX_PAYLOAD)
+    {
+        return 0;
+    }
+
+    buffer[0] = SERIAL_FRAME_SYNC;
+    buffer[1] = length;
+    buffer[2] = type;
+    memcpy(&buffer[3], payload, length);
+
+    uint16_t crc = crc16(&buffer[1], length + 2);
+
+    buffer[3 + length] = (uint8_t)crc;
+    buffer[4 + length] = (uint8_t)(crc >> 8);
+
+    return length + SERIAL_FRAME_OVERHEAD;
+}
+
+// SerialFrameParser Class - incremental frame decoder, fed one byte at a
+// time so the caller decides how much work to do per loop() pass.  A bad
+// length or CRC drops the frame and the parser hunts for the next SYNC.
+class SerialFrameParser
+{
+    public:
+
+    enum parser_state { WAIT_SYNC, WAIT_LENGTH, WAIT_TYPE, WAIT_PAYLOAD, WAIT_CRC_LO, WAIT_CRC_HI };
+
+    // Member Variables:
+    sSerialFrame Frame;      // the last complete frame
+    parser_state State;
+    uint8_t Received;        // payload bytes received so far
+    uint16_t Crc;            // running CRC of the frame being received
+    uint16_t CrcLow;
+
+    uint16_t FramesReceived;
+    uint16_t CrcErrors;
+    uint16_t LengthErrors;
+
+    // Constructor
+    SerialFrameParser()
+    {
+        State = WAIT_SYNC;
+        FramesReceived = 0;
+        CrcErrors = 0;
+        LengthErrors = 0;
+    }
+
+    // Feed one byte.  Returns true when it completes a valid frame.
+    bool Feed(uint8_t c)
+    {
+        switch (State)
+        {
+            case WAIT_SYNC:
+                if (c == SERIAL_FRAME_SYNC)
+                {
+                    State = WAIT_LENGTH;
+                }
+                break;
+
+            case WAIT_LENGTH:
+                if (c > SERIAL_FRAME_MAX_PAYLOAD)
+                {
+                    LengthErrors++;
+                    State = (c == SERIAL_FRAME_SYNC) ? WAIT_LENGTH : WAIT_SYNC;
+                    break;
+                }
+                Frame.length = c;
+                Received = 0;
+                Crc = crc16_update(0xFFFF, c);
+                State = WAIT_TYPE;
+                break;
+
+            case WAIT_TYPE:
+                Frame.type = c;
+                Crc = crc16_update(Crc, c);
+                State = (Frame.length > 0) ? WAIT_PAYLOAD : WAIT_CRC_LO;
+                break;
+
+            case WAIT_PAYLOAD:
+                Frame.payload[Received++] = c;
+                Crc = crc16_update(Crc, c);
+                if (Received >= Frame.length)
+                {
+                    State = WAIT_CRC_LO;
+                }
+                break;
+
+            case WAIT_CRC_LO:
+                CrcLow = c;
+                State = WAIT_CRC_HI;
+                break;
+
+            case WAIT_CRC_HI:
+                State = WAIT_SYNC;
+                if ((uint16_t)(CrcLow | (c << 8)) == Crc)
+                {
+                    FramesReceived++;
+                    return true;
+                }
+                CrcErrors++;
+                break;
+        }
+
+        return false;
+    }
+};
+
+#endif /* _SERIAL_PROTOCOL_H */
@@ -0,0 +1,295 @@
+#include "Adafruit_NeoPixel.h"
+#include "NativeSim.h"
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t p, neoPixelType t)
+    : simShowCount(0), simBytesPushed(0), simWireMicros(0),
+      is800KHz(true), begun(false), numLEDs(0), numBytes(0), pin(-1),
+      brightness(0), pixels(NULL), rOffset(1), gOffset(0), bOffset(2),
+      wOffset(1), endTime(0)
+{
+    updateType(t);
+    updateLength(n);
+    setPin(p);
+}
+
+Adafruit_NeoPixel::Adafruit_NeoPixel()
+    : simShowCount(0), simBytesPushed(0), simWireMicros(0),
+      is800KHz(true), begun(false), numLEDs(0), numBytes(0), pin(-1),
+      brightness(0), pixels(NULL), rOffset(1), gOffset(0), bOffset(2),
+      wOffset(1), endTime(0)
+{
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel()
+{
+    if (pixels)
+    {
+        sim_heap_freed(numBytes);
+    }
+    free(pixels);
+}
+
+void Adafruit_NeoPixel::begin(void)
+{
+    begun = true;
+}
+
+void Adafruit_NeoPixel::updateLength(uint16_t n)
+{
+    if (pixels)
+    {
+        sim_heap_freed(numBytes);
+    }
+    free(pixels);
+
+    numBytes = n * ((wOffset == rOffset) ? 3 : 4);
+    if ((pixels = (uint8_t *)malloc(numBytes)))
+    {
+        sim_heap_allocated(numBytes);
+        memset(pixels, 0, numBytes);
+        numLEDs = n;
+    }
+    else
+    {
+        numLEDs = numBytes = 0;
+    }
+}
+
+void Adafruit_NeoPixel::updateType(neoPixelType t)
+{
+    bool oldThreeBytesPerPixel = (wOffset == rOffset);
+
+    wOffset = (t >> 6) & 0b11;
+    rOffset = (t >> 4) & 0b11;
+    gOffset = (t >> 2) & 0b11;
+    bOffset = t & 0b11;
+    is800KHz = (t < 256);
+
+    if (pixels)
+    {
+        bool newThreeBytesPerPixel = (wOffset == rOffset);
+        if (newThreeBytesPerPixel != oldThreeBytesPerPixel)
+        {
+            updateLength(numLEDs);
+        }
+    }
+}
+
+void Adafruit_NeoPixel::setPin(int16_t p)
+{
+    pin = p;
+}
+
+bool Adafruit_NeoPixel::canShow(void)
+{
+    uint32_t now = micros();
+    if (endTime > now)
+    {
+        endTime = now;
+    }
+    return (now - endTime) >= NEO_LATCH_MICROS;
+}
+
+void Adafruit_NeoPixel::show(void)
+{
+    if (!pixels)
+    {
+        return;
+    }
+
+    // Wait for the latch of the previous transfer (interrupts still enabled)
+    while (!canShow())
+    {
+        sim_advance_micros(NEO_LATCH_MICROS - (micros() - endTime));
+    }
+
+    uint32_t wire_us = numBytes * (is800KHz ? NEO_BYTE_MICROS_800KHZ : NEO_BYTE_MICROS_400KHZ);
+
+    sim_begin_masked();
+    sim_advance_micros(wire_us);
+    simShowCount++;
+    simBytesPushed += numBytes;
+    simWireMicros += wire_us;
+    endTime = micros();
+    sim_end_masked();
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (n < numLEDs)
+    {
+        if (brightness)
+        {
+            r = (r * brightness) >> 8;
+            g = (g * brightness) >> 8;
+            b = (b * brightness) >> 8;
+        }
+        uint8_t *p;
+        if (wOffset == rOffset)
+        {
+            p = &pixels[n * 3];
+        }
+        else
+        {
+            p = &pixels[n * 4];
+            p[wOffset] = 0;
+        }
+        p[rOffset] = r;
+        p[gOffset] = g;
+        p[bOffset] = b;
+    }
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+{
+    if (n < numLEDs)
+    {
+        if (brightness)
+        {
+            r = (r * brightness) >> 8;
+            g = (g * brightness) >> 8;
+            b = (b * brightness) >> 8;
+            w = (w * brightness) >> 8;
+        }
+        uint8_t *p;
+        if (wOffset == rOffset)
+        {
+            p = &pixels[n * 3];
+        }
+        else
+        {
+            p = &pixels[n * 4];
+            p[wOffset] = w;
+        }
+        p[rOffset] = r;
+        p[gOffset] = g;
+        p[bOffset] = b;
+    }
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c)
+{
+    if (n < numLEDs)
+    {
+        uint8_t *p, r = (uint8_t)(c >> 16), g = (uint8_t)(c >> 8), b = (uint8_t)c;
+        if (brightness)
+        {
+            r = (r * brightness) >> 8;
+            g = (g * brightness) >> 8;
+            b = (b * brightness) >> 8;
+        }
+        if (wOffset == rOffset)
+        {
+            p = &pixels[n * 3];
+        }
+        else
+        {
+            p = &pixels[n * 4];
+            uint8_t w = (uint8_t)(c >> 24);
+            p[wOffset] = brightness ? ((w * brightness) >> 8) : w;
+        }
+        p[rOffset] = r;
+        p[gOffset] = g;
+        p[bOffset] = b;
+    }
+}
+
+void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count)
+{
+    uint16_t i, end;
+
+    if (first >= numLEDs)
+    {
+        return;
+    }
+
+    if (count == 0)
+    {
+        end = numLEDs;
+    }
+    else
+    {
+        end = first + count;
+        if (end > numLEDs)
+        {
+            end = numLEDs;
+        }
+    }
+
+    for (i = first; i < end; i++)
+    {
+        this->setPixelColor(i, c);
+    }
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const
+{
+    if (n >= numLEDs)
+    {
+        return 0;
+    }
+
+    uint8_t *p;
+
+    if (wOffset == rOffset)
+    {
+        p = &pixels[n * 3];
+        if (brightness)
+        {
+            return (((uint32_t)(p[rOffset] << 8) / brightness) << 16)
+                 | (((uint32_t)(p[gOffset] << 8) / brightness) << 8)
+                 | ((uint32_t)(p[bOffset] << 8) / brightness);
+        }
+        return ((uint32_t)p[rOffset] << 16) | ((uint32_t)p[gOffset] << 8) | (uint32_t)p[bOffset];
+    }
+
+    p = &pixels[n * 4];
+    if (brightness)
+    {
+        return (((uint32_t)(p[wOffset] << 8) / brightness) << 24)
+             | (((uint32_t)(p[rOffset] << 8) / brightness) << 16)
+             | (((uint32_t)(p[gOffset] << 8) / brightness) << 8)
+             | ((uint32_t)(p[bOffset] << 8) / brightness);
+    }
+    return ((uint32_t)p[wOffset] << 24) | ((uint32_t)p[rOffset] << 16)
+         | ((uint32_t)p[gOffset] << 8) | (uint32_t)p[bOffset];
+}
+
+void Adafruit_NeoPixel::setBrightness(uint8_t b)
+{
+    uint8_t newBrightness = b + 1;
+
+    if (newBrightness != brightness)
+    {
+        uint8_t c, *ptr = pixels, oldBrightness = brightness - 1;
+        uint16_t scale;
+
+        if (oldBrightness == 0)
+        {
+            scale = 0;
+        }
+        else if (b == 255)
+        {
+            scale = 65535 / oldBrightness;
+        }
+        else
+        {
+            scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
+        }
+
+        for (uint16_t i = 0; i < numBytes; i++)
+        {
+            c = *ptr;
+            *ptr++ = (c * scale) >> 8;
+        }
+        brightness = newBrightness;
+    }
+}
+
+void Adafruit_NeoPixel::clear(void)
+{
+    if (pixels)
+    {
+        memset(pixels, 0, numBytes);
+    }
+}
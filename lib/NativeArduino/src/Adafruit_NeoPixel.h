@@ -0,0 +1,87 @@
+#ifndef _NATIVE_ADAFRUIT_NEOPIXEL_H
+#define _NATIVE_ADAFRUIT_NEOPIXEL_H
+
+// Host stand-in for Adafruit_NeoPixel.  The pixel buffer handling (colour
+// order, brightness scaling, allocation) follows the real library; show()
+// models the AVR bit-bang timing on the simulated clock: it waits out the
+// 300us latch, then masks interrupts for 10us per byte at 800 KHz.
+
+#include <Arduino.h>
+
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_RBG ((0 << 6) | (0 << 4) | (2 << 2) | (1))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_GBR ((2 << 6) | (2 << 4) | (0 << 2) | (1))
+#define NEO_BRG ((1 << 6) | (1 << 4) | (2 << 2) | (0))
+#define NEO_BGR ((2 << 6) | (2 << 4) | (1 << 2) | (0))
+#define NEO_RGBW ((3 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_GRBW ((3 << 6) | (1 << 4) | (0 << 2) | (2))
+
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+
+typedef uint16_t neoPixelType;
+
+#define NEO_LATCH_MICROS 300
+#define NEO_BYTE_MICROS_800KHZ 10
+#define NEO_BYTE_MICROS_400KHZ 20
+
+class Adafruit_NeoPixel
+{
+    public:
+
+    Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800);
+    Adafruit_NeoPixel(void);
+    ~Adafruit_NeoPixel();
+
+    void begin(void);
+    void show(void);
+    void setPin(int16_t p);
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+    void setPixelColor(uint16_t n, uint32_t c);
+    void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0);
+    void setBrightness(uint8_t b);
+    void clear(void);
+    void updateLength(uint16_t n);
+    void updateType(neoPixelType t);
+
+    bool canShow(void);
+    uint8_t *getPixels(void) const { return pixels; }
+    uint8_t getBrightness(void) const { return brightness - 1; }
+    int16_t getPin(void) const { return pin; }
+    uint16_t numPixels(void) const { return numLEDs; }
+    uint32_t getPixelColor(uint16_t n) const;
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b)
+    {
+        return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+    {
+        return ((uint32_t)w << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+    // Simulation statistics
+    uint32_t simShowCount;     // transfers actually clocked out
+    uint32_t simBytesPushed;   // bytes clocked out over the wire
+    uint64_t simWireMicros;    // time spent with interrupts masked
+
+    protected:
+
+    bool is800KHz;
+    bool begun;
+    uint16_t numLEDs;
+    uint16_t numBytes;
+    int16_t pin;
+    uint8_t brightness;
+    uint8_t *pixels;
+    uint8_t rOffset;
+    uint8_t gOffset;
+    uint8_t bOffset;
+    uint8_t wOffset;
+    uint32_t endTime;
+};
+
+#endif /* _NATIVE_ADAFRUIT_NEOPIXEL_H */
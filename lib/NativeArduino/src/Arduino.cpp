@@ -0,0 +1,722 @@
+#include <stdio.h>
+#include <deque>
+#include <vector>
+#include "Arduino.h"
+#include "NativeSim.h"
+
+#define NUM_EXTERNAL_INTERRUPTS 2
+#define PORT_B_FIRST_PIN 8
+#define PORT_B_PINS 6
+#define SERIAL_TX_BUFFER_SIZE 64
+#define SERIAL_RX_BUFFER_SIZE 64
+
+// Clock and interrupt state
+static uint64_t now_us = 0;
+static int masked_depth = 0;
+static bool irq_disabled = false;
+static int isr_depth = 0;
+static uint64_t masked_start_us = 0;
+static uint64_t masked_total_us = 0;
+static uint32_t late_interrupts = 0;
+
+static void (*isr_funcs[NUM_EXTERNAL_INTERRUPTS])(void);
+static int isr_modes[NUM_EXTERNAL_INTERRUPTS];
+static bool isr_pending[NUM_EXTERNAL_INTERRUPTS];
+
+// Pin change interrupt registers of port B (writes to PCIFR are ignored:
+// the pending flag is kept here)
+volatile uint8_t PCICR = 0;
+volatile uint8_t PCIFR = 0;
+volatile uint8_t PCMSK0 = 0;
+static bool port_b_pending = false;
+
+// Pin state (inputs float high, as if INPUT_PULLUP)
+static uint8_t pin_levels[NUM_DIGITAL_PINS] = {
+    HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH,
+    HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH
+};
+
+// RC PWM generators
+typedef struct s_pwm_input {
+    bool active;
+    bool high;
+    uint16_t width_us;
+    uint32_t period_us;
+    uint64_t rise_us;
+    uint64_t next_edge_us;
+} sPwmInput;
+
+static sPwmInput pwm_inputs[NUM_DIGITAL_PINS];
+
+static uint32_t random_state = 1;
+
+// Heap use of the stand-ins
+static uint32_t heap_bytes = 0;
+static uint32_t heap_peak_bytes = 0;
+
+HardwareSerial Serial;
+
+static bool interrupts_blocked()
+{
+    return masked_depth > 0 || irq_disabled || isr_depth > 0;
+}
+
+static void run_isr(int num)
+{
+    isr_depth++;
+    isr_funcs[num]();
+    isr_depth--;
+}
+
+static void run_port_b_isr()
+{
+    port_b_pending = false;
+    isr_depth++;
+    PCINT0_vect();
+    isr_depth--;
+}
+
+static void service_pending_interrupts()
+{
+    bool serviced = true;
+
+    while (serviced && !interrupts_blocked())
+    {
+        serviced = false;
+        if (port_b_pending)
+        {
+            late_interrupts++;
+            run_port_b_isr();
+            serviced = true;
+            continue;
+        }
+        for (int i = 0; i < NUM_EXTERNAL_INTERRUPTS; i++)
+        {
+            if (isr_pending[i])
+            {
+                isr_pending[i] = false;
+                late_interrupts++;
+                run_isr(i);
+                serviced = true;
+                break;
+            }
+        }
+    }
+}
+
+static void port_b_changed(uint8_t pin)
+{
+    if (PCINT0_vect == NULL
+        || (PCICR & _BV(PCIE0)) == 0
+        || (PCMSK0 & _BV(pin - PORT_B_FIRST_PIN)) == 0)
+    {
+        return;
+    }
+
+    if (interrupts_blocked())
+    {
+        port_b_pending = true;
+    }
+    else
+    {
+        run_port_b_isr();
+    }
+}
+
+static void pin_changed(uint8_t pin, int level)
+{
+    int num = digitalPinToInterrupt(pin);
+
+    if (pin >= PORT_B_FIRST_PIN && pin < PORT_B_FIRST_PIN + PORT_B_PINS)
+    {
+        port_b_changed(pin);
+        return;
+    }
+
+    if (num == NOT_AN_INTERRUPT || isr_funcs[num] == NULL)
+    {
+        return;
+    }
+
+    if ((isr_modes[num] == RISING && level != HIGH)
+        || (isr_modes[num] == FALLING && level != LOW))
+    {
+        return;
+    }
+
+    if (interrupts_blocked())
+    {
+        isr_pending[num] = true;
+    }
+    else
+    {
+        run_isr(num);
+    }
+}
+
+// SIMULATION CONTROLS
+uint64_t sim_now_micros()
+{
+    return now_us;
+}
+
+void sim_set_now_micros(uint64_t now)
+{
+    now_us = now;
+}
+
+void sim_advance_micros(uint32_t us)
+{
+    uint64_t target_us = now_us + us;
+
+    for (;;)
+    {
+        int next_pin = -1;
+
+        for (int pin = 0; pin < NUM_DIGITAL_PINS; pin++)
+        {
+            if (pwm_inputs[pin].active
+                && pwm_inputs[pin].next_edge_us <= target_us
+                && (next_pin < 0 || pwm_inputs[pin].next_edge_us < pwm_inputs[next_pin].next_edge_us))
+            {
+                next_pin = pin;
+            }
+        }
+
+        if (next_pin < 0)
+        {
+            break;
+        }
+
+        sPwmInput *input = &pwm_inputs[next_pin];
+
+        if (input->next_edge_us > now_us)
+        {
+            now_us = input->next_edge_us;
+        }
+
+        if (input->high)
+        {
+            input->high = false;
+            input->rise_us += input->period_us;
+            input->next_edge_us = input->rise_us;
+        }
+        else
+        {
+            input->high = true;
+            input->next_edge_us = input->rise_us + input->width_us;
+        }
+
+        sim_set_pin(next_pin, input->high ? HIGH : LOW);
+    }
+
+    if (now_us < target_us)
+    {
+        now_us = target_us;
+    }
+}
+
+void sim_begin_masked()
+{
+    if (masked_depth++ == 0)
+    {
+        masked_start_us = now_us;
+    }
+}
+
+void sim_end_masked()
+{
+    if (--masked_depth == 0)
+    {
+        masked_total_us += now_us - masked_start_us;
+        service_pending_interrupts();
+    }
+}
+
+bool sim_interrupts_masked()
+{
+    return interrupts_blocked();
+}
+
+uint64_t sim_masked_micros()
+{
+    return masked_total_us;
+}
+
+uint32_t sim_late_interrupts()
+{
+    return late_interrupts;
+}
+
+void sim_heap_allocated(size_t bytes)
+{
+    heap_bytes += bytes;
+    if (heap_bytes > heap_peak_bytes)
+    {
+        heap_peak_bytes = heap_bytes;
+    }
+}
+
+void sim_heap_freed(size_t bytes)
+{
+    heap_bytes -= bytes;
+}
+
+uint32_t sim_heap_bytes()
+{
+    return heap_bytes;
+}
+
+uint32_t sim_heap_peak_bytes()
+{
+    return heap_peak_bytes;
+}
+
+void sim_set_pin(uint8_t pin, int level)
+{
+    if (pin >= NUM_DIGITAL_PINS || pin_levels[pin] == level)
+    {
+        return;
+    }
+
+    pin_levels[pin] = level;
+    pin_changed(pin, level);
+}
+
+uint8_t sim_read_port_b()
+{
+    uint8_t levels = 0;
+
+    for (int i = 0; i < PORT_B_PINS; i++)
+    {
+        if (pin_levels[PORT_B_FIRST_PIN + i] == HIGH)
+        {
+            levels |= _BV(i);
+        }
+    }
+
+    return levels;
+}
+
+void sim_set_pwm_input(uint8_t pin, uint16_t width_us, uint32_t period_us, uint32_t phase_us)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return;
+    }
+
+    sPwmInput *input = &pwm_inputs[pin];
+
+    input->active = (width_us > 0);
+    input->high = false;
+    input->width_us = width_us;
+    input->period_us = period_us;
+    input->rise_us = now_us + phase_us;
+    input->next_edge_us = input->rise_us;
+
+    sim_set_pin(pin, LOW);
+}
+
+// ARDUINO CORE
+unsigned long millis()
+{
+    return (uint32_t)(now_us / 1000);
+}
+
+unsigned long micros()
+{
+    return (uint32_t)now_us;
+}
+
+void delay(unsigned long ms)
+{
+    sim_advance_micros(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    sim_advance_micros(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return (pin < NUM_DIGITAL_PINS) ? pin_levels[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin < NUM_DIGITAL_PINS)
+    {
+        pin_levels[pin] = val ? HIGH : LOW;
+    }
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode)
+{
+    if (interruptNum < NUM_EXTERNAL_INTERRUPTS)
+    {
+        isr_funcs[interruptNum] = userFunc;
+        isr_modes[interruptNum] = mode;
+        isr_pending[interruptNum] = false;
+    }
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+    if (interruptNum < NUM_EXTERNAL_INTERRUPTS)
+    {
+        isr_funcs[interruptNum] = NULL;
+        isr_pending[interruptNum] = false;
+    }
+}
+
+void noInterrupts()
+{
+    irq_disabled = true;
+}
+
+void interrupts()
+{
+    irq_disabled = false;
+    service_pending_interrupts();
+}
+
+// Deterministic so benchmark runs are repeatable
+long random(long howbig)
+{
+    if (howbig == 0)
+    {
+        return 0;
+    }
+    random_state = random_state * 1103515245UL + 12345UL;
+    return (long)((random_state >> 8) % (uint32_t)howbig);
+}
+
+long random(long howsmall, long howbig)
+{
+    if (howsmall >= howbig)
+    {
+        return howsmall;
+    }
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed)
+{
+    if (seed != 0)
+    {
+        random_state = (uint32_t)seed;
+    }
+}
+
+// SERIAL
+static uint8_t tx_count = 0;
+static uint64_t tx_last_drain_us = 0;
+static bool tx_echo = false;
+static bool tx_capture = false;
+static std::vector<uint8_t> tx_captured;
+
+// RX: bytes on the wire (with their arrival time) and the 64 byte ring the
+// RX interrupt would have filled
+typedef struct s_rx_byte {
+    uint64_t arrival_us;
+    uint8_t value;
+} sRxByte;
+
+static std::deque<sRxByte> rx_wire;
+static std::deque<uint8_t> rx_buffer;
+static uint64_t rx_last_arrival_us = 0;
+static uint32_t rx_overruns = 0;
+
+static uint32_t tx_byte_micros()
+{
+    return Serial.baud ? (uint32_t)(10000000UL / Serial.baud) : 0;
+}
+
+static void tx_drain()
+{
+    uint32_t byte_us = tx_byte_micros();
+
+    if (tx_count == 0 || byte_us == 0)
+    {
+        tx_last_drain_us = now_us;
+        return;
+    }
+
+    uint64_t drained = (now_us - tx_last_drain_us) / byte_us;
+
+    if (drained >= tx_count)
+    {
+        tx_count = 0;
+        tx_last_drain_us = now_us;
+    }
+    else
+    {
+        tx_count -= (uint8_t)drained;
+        tx_last_drain_us += drained * byte_us;
+    }
+}
+
+void HardwareSerial::begin(unsigned long rate)
+{
+    baud = rate;
+    tx_count = 0;
+    tx_last_drain_us = now_us;
+    tx_echo = (getenv("NATIVE_SERIAL_ECHO") != NULL);
+}
+
+void HardwareSerial::begin(unsigned long rate, uint8_t)
+{
+    begin(rate);
+}
+
+void HardwareSerial::end()
+{
+    baud = 0;
+}
+
+// Move every byte that has arrived by now into the RX ring
+static void rx_receive()
+{
+    while (!rx_wire.empty() && rx_wire.front().arrival_us <= now_us)
+    {
+        if (rx_buffer.size() < SERIAL_RX_BUFFER_SIZE)
+        {
+            rx_buffer.push_back(rx_wire.front().value);
+        }
+        else
+        {
+            rx_overruns++;
+        }
+        rx_wire.pop_front();
+    }
+}
+
+int HardwareSerial::available()
+{
+    rx_receive();
+    return (int)rx_buffer.size();
+}
+
+int HardwareSerial::read()
+{
+    rx_receive();
+
+    if (rx_buffer.empty())
+    {
+        return -1;
+    }
+
+    uint8_t c = rx_buffer.front();
+    rx_buffer.pop_front();
+    return c;
+}
+
+int HardwareSerial::availableForWrite()
+{
+    tx_drain();
+    return SERIAL_TX_BUFFER_SIZE - tx_count;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    if (baud == 0)
+    {
+        return 0;
+    }
+
+    tx_drain();
+
+    if (tx_count >= SERIAL_TX_BUFFER_SIZE)
+    {
+        uint32_t wait_us = tx_byte_micros() - (uint32_t)(now_us - tx_last_drain_us);
+        blockedMicros += wait_us;
+        sim_advance_micros(wait_us);
+        tx_drain();
+    }
+
+    tx_count++;
+    bytesWritten++;
+
+    if (tx_capture)
+    {
+        tx_captured.push_back(c);
+    }
+
+    if (tx_echo)
+    {
+        putchar(c);
+    }
+
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+void HardwareSerial::flush()
+{
+    tx_drain();
+    if (tx_count > 0)
+    {
+        uint32_t wait_us = tx_count * tx_byte_micros();
+        blockedMicros += wait_us;
+        sim_advance_micros(wait_us);
+        tx_drain();
+    }
+}
+
+static size_t print_unsigned(HardwareSerial *port, unsigned long n, int base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    if (base < 2)
+    {
+        base = 10;
+    }
+
+    *str = '\0';
+    do
+    {
+        char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+
+    return port->print(str);
+}
+
+static size_t print_signed(HardwareSerial *port, long n, int base)
+{
+    if (base == DEC && n < 0)
+    {
+        return port->print('-') + print_unsigned(port, (unsigned long)-n, base);
+    }
+    return print_unsigned(port, (unsigned long)n, base);
+}
+
+size_t HardwareSerial::print(const char *s)
+{
+    return write((const uint8_t *)s, strlen(s));
+}
+
+size_t HardwareSerial::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t HardwareSerial::print(int n, int base)
+{
+    return print_signed(this, n, base);
+}
+
+size_t HardwareSerial::print(unsigned int n, int base)
+{
+    return print_unsigned(this, n, base);
+}
+
+size_t HardwareSerial::print(long n, int base)
+{
+    return print_signed(this, n, base);
+}
+
+size_t HardwareSerial::print(unsigned long n, int base)
+{
+    return print_unsigned(this, n, base);
+}
+
+size_t HardwareSerial::print(double n, int digits)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return print(buf);
+}
+
+size_t HardwareSerial::println()
+{
+    return print("\r\n");
+}
+
+size_t HardwareSerial::println(const char *s)
+{
+    return print(s) + println();
+}
+
+size_t HardwareSerial::println(char c)
+{
+    return print(c) + println();
+}
+
+size_t HardwareSerial::println(int n, int base)
+{
+    return print(n, base) + println();
+}
+
+size_t HardwareSerial::println(unsigned int n, int base)
+{
+    return print(n, base) + println();
+}
+
+size_t HardwareSerial::println(long n, int base)
+{
+    return print(n, base) + println();
+}
+
+size_t HardwareSerial::println(unsigned long n, int base)
+{
+    return print(n, base) + println();
+}
+
+size_t HardwareSerial::println(double n, int digits)
+{
+    return print(n, digits) + println();
+}
+
+void sim_serial_inject(const uint8_t *data, size_t length)
+{
+    uint32_t byte_us = tx_byte_micros();
+    uint64_t arrival_us = (rx_last_arrival_us > now_us) ? rx_last_arrival_us : now_us;
+
+    while (length--)
+    {
+        arrival_us += byte_us;
+        rx_wire.push_back({ arrival_us, *data++ });
+    }
+
+    rx_last_arrival_us = arrival_us;
+}
+
+uint32_t sim_serial_rx_overruns()
+{
+    return rx_overruns;
+}
+
+void sim_serial_capture(bool enable)
+{
+    tx_capture = enable;
+    tx_captured.clear();
+}
+
+size_t sim_serial_take_output(uint8_t *buffer, size_t max_length)
+{
+    size_t n = (tx_captured.size() < max_length) ? tx_captured.size() : max_length;
+
+    memcpy(buffer, tx_captured.data(), n);
+    tx_captured.erase(tx_captured.begin(), tx_captured.begin() + n);
+
+    return n;
+}
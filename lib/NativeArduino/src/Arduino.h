@@ -0,0 +1,137 @@
+#ifndef _NATIVE_ARDUINO_H
+#define _NATIVE_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino core used by the firmware.
+// Time comes from the simulated clock in NativeSim.h, not the wall clock.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+// HardwareSerial frame formats (AVR UCSRC values)
+#define SERIAL_8N1 0x06
+#define SERIAL_8E2 0x2E
+
+#define NUM_DIGITAL_PINS 20
+#define NOT_AN_INTERRUPT -1
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+
+#define _BV(bit) (1 << (bit))
+
+// Pin change interrupt of port B (digital pins 8-13 are PB0-PB5).  PINB
+// reads the pin levels; ISR(PCINT0_vect) defines the handler, which runs on
+// a change of any pin set in PCMSK0 while PCIE0 is set in PCICR.  Changes
+// while interrupts are masked set one pending flag, as PCIF0 does.
+#define PCIE0 0
+#define PCIF0 0
+#define PINB (sim_read_port_b())
+#define ISR(vector) extern "C" void vector(void)
+
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCIFR;
+extern volatile uint8_t PCMSK0;
+
+uint8_t sim_read_port_b();
+extern "C" void PCINT0_vect(void) __attribute__((weak));
+
+// Flash access maps straight onto RAM on the host
+#define PROGMEM
+#define F(string_literal) (string_literal)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void * const *)(addr))
+#define memcpy_P memcpy
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+void noInterrupts();
+void interrupts();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// Serial port stand-in. Output is discarded unless NATIVE_SERIAL_ECHO is set
+// in the environment, but TX time is modelled: a write into a full 64 byte
+// buffer blocks the simulated clock just like the AVR HardwareSerial does.
+// RX bytes come from sim_serial_inject() (see NativeSim.h).
+class HardwareSerial
+{
+    public:
+
+    void begin(unsigned long baud);
+    void begin(unsigned long baud, uint8_t config);   // frame format is not modelled
+    void end();
+    int available();
+    int read();
+    int availableForWrite();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    void flush();
+
+    size_t print(const char *s);
+    size_t print(char c);
+    size_t print(int n, int base = DEC);
+    size_t print(unsigned int n, int base = DEC);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println();
+    size_t println(const char *s);
+    size_t println(char c);
+    size_t println(int n, int base = DEC);
+    size_t println(unsigned int n, int base = DEC);
+    size_t println(long n, int base = DEC);
+    size_t println(unsigned long n, int base = DEC);
+    size_t println(double n, int digits = 2);
+
+    operator bool() { return true; }
+
+    // Simulation statistics
+    unsigned long baud;
+    uint32_t bytesWritten;
+    uint32_t blockedMicros;
+};
+
+extern HardwareSerial Serial;
+
+#endif /* _NATIVE_ARDUINO_H */
@@ -0,0 +1,70 @@
+#ifndef _NATIVE_EEPROM_H
+#define _NATIVE_EEPROM_H
+
+// Host stand-in for the AVR EEPROM library (1 KB, erased cells read 0xFF)
+
+#include <Arduino.h>
+
+#define NATIVE_EEPROM_SIZE 1024
+
+class EEPROMClass
+{
+    public:
+
+    uint8_t cells[NATIVE_EEPROM_SIZE];
+    uint32_t writes;   // cell writes performed (update() skips unchanged cells)
+
+    EEPROMClass()
+    {
+        memset(cells, 0xFF, sizeof(cells));
+        writes = 0;
+    }
+
+    uint8_t read(int idx)
+    {
+        return cells[idx % NATIVE_EEPROM_SIZE];
+    }
+
+    void write(int idx, uint8_t val)
+    {
+        cells[idx % NATIVE_EEPROM_SIZE] = val;
+        writes++;
+    }
+
+    void update(int idx, uint8_t val)
+    {
+        if (read(idx) != val)
+        {
+            write(idx, val);
+        }
+    }
+
+    uint16_t length()
+    {
+        return NATIVE_EEPROM_SIZE;
+    }
+
+    template <typename T> T &get(int idx, T &t)
+    {
+        uint8_t *ptr = (uint8_t *)&t;
+        for (size_t count = sizeof(T); count; --count, ++idx)
+        {
+            *ptr++ = read(idx);
+        }
+        return t;
+    }
+
+    template <typename T> const T &put(int idx, const T &t)
+    {
+        const uint8_t *ptr = (const uint8_t *)&t;
+        for (size_t count = sizeof(T); count; --count, ++idx)
+        {
+            update(idx, *ptr++);
+        }
+        return t;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif /* _NATIVE_EEPROM_H */
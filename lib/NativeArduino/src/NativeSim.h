@@ -0,0 +1,49 @@
+#ifndef _NATIVE_SIM_H
+#define _NATIVE_SIM_H
+
+// Simulation controls for the native build.
+//
+// The clock only moves when the host tells it to (sim_advance_micros) or
+// when a stand-in models a blocking operation (show(), Serial TX).  While
+// interrupts are masked, pin edges are latched and their ISR runs late,
+// when interrupts are enabled again - the same way the AVR INTx and pin
+// change flags work.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Clock
+uint64_t sim_now_micros();
+void sim_set_now_micros(uint64_t now);
+void sim_advance_micros(uint32_t us);
+
+// Interrupt masking (used by the stand-ins that block with interrupts off)
+void sim_begin_masked();
+void sim_end_masked();
+bool sim_interrupts_masked();
+uint64_t sim_masked_micros();      // total time spent with interrupts masked
+uint32_t sim_late_interrupts();    // ISRs that ran late because of masking
+
+// Digital pins
+void sim_set_pin(uint8_t pin, int level);
+
+// RC receiver PWM stand-in on a pin: a pulse of width_us every period_us.
+// A width of 0 stops the signal (pin held low).
+void sim_set_pwm_input(uint8_t pin, uint16_t width_us, uint32_t period_us = 20000, uint32_t phase_us = 0);
+
+// Serial port: queue bytes for RX (they arrive one per byte time at the
+// configured baud rate into a 64 byte ring; bytes that find it full are
+// lost, as on the AVR) and collect TX output while capture is enabled
+void sim_serial_inject(const uint8_t *data, size_t length);
+uint32_t sim_serial_rx_overruns();
+void sim_serial_capture(bool enable);
+size_t sim_serial_take_output(uint8_t *buffer, size_t max_length);
+
+// Heap bytes the stand-ins have allocated (the Adafruit_NeoPixel pixel
+// buffers): now and at most
+void sim_heap_allocated(size_t bytes);
+void sim_heap_freed(size_t bytes);
+uint32_t sim_heap_bytes();
+uint32_t sim_heap_peak_bytes();
+
+#endif /* _NATIVE_SIM_H */
@@ -0,0 +1,130 @@
+#ifndef _NATIVE_ONE_BUTTON_H
+#define _NATIVE_ONE_BUTTON_H
+
+// Host stand-in for mathertel/OneButton 2.x covering the single click and
+// long press events.  The button is polled from tick(), so the host drives
+// it by changing the pin level with sim_set_pin().
+
+#include <Arduino.h>
+
+extern "C" {
+    typedef void (*callbackFunction)(void);
+}
+
+class OneButton
+{
+    public:
+
+    OneButton(const int pin, const boolean activeLow = true, const bool pullupActive = true)
+    {
+        _pin = pin;
+        _buttonPressed = activeLow ? LOW : HIGH;
+        _debounceTicks = 50;
+        _clickTicks = 400;
+        _pressTicks = 800;
+        _clickFunc = NULL;
+        _longPressStartFunc = NULL;
+        _longPressStopFunc = NULL;
+        _state = OCS_INIT;
+        _startTime = 0;
+        (void)pullupActive;
+    }
+
+    void setDebounceTicks(const int ticks) { _debounceTicks = ticks; }
+    void setClickTicks(const int ticks) { _clickTicks = ticks; }
+    void setPressTicks(const int ticks) { _pressTicks = ticks; }
+
+    void attachClick(callbackFunction newFunction) { _clickFunc = newFunction; }
+    void attachLongPressStart(callbackFunction newFunction) { _longPressStartFunc = newFunction; }
+    void attachLongPressStop(callbackFunction newFunction) { _longPressStopFunc = newFunction; }
+
+    bool isLongPressed() const { return _state == OCS_PRESS; }
+    bool isIdle() const { return _state == OCS_INIT; }
+
+    void reset()
+    {
+        _state = OCS_INIT;
+        _startTime = 0;
+    }
+
+    void tick()
+    {
+        tick(digitalRead(_pin) == _buttonPressed);
+    }
+
+    void tick(bool activeLevel)
+    {
+        unsigned long now = millis();
+        unsigned long waitTime = now - _startTime;
+
+        switch (_state)
+        {
+            case OCS_INIT:
+                if (activeLevel)
+                {
+                    _state = OCS_DOWN;
+                    _startTime = now;
+                }
+                break;
+
+            case OCS_DOWN:
+                if (!activeLevel && waitTime < _debounceTicks)
+                {
+                    _state = OCS_INIT;
+                }
+                else if (!activeLevel)
+                {
+                    _state = OCS_UP;
+                    _startTime = now;
+                }
+                else if (waitTime > _pressTicks)
+                {
+                    _state = OCS_PRESS;
+                    if (_longPressStartFunc)
+                    {
+                        _longPressStartFunc();
+                    }
+                }
+                break;
+
+            case OCS_UP:
+                if (waitTime >= _clickTicks)
+                {
+                    _state = OCS_INIT;
+                    if (_clickFunc)
+                    {
+                        _clickFunc();
+                    }
+                }
+                break;
+
+            case OCS_PRESS:
+                if (!activeLevel)
+                {
+                    _state = OCS_INIT;
+                    if (_longPressStopFunc)
+                    {
+                        _longPressStopFunc();
+                    }
+                }
+                break;
+        }
+    }
+
+    private:
+
+    enum stateMachine_t { OCS_INIT, OCS_DOWN, OCS_UP, OCS_PRESS };
+
+    int _pin;
+    int _buttonPressed;
+    unsigned int _debounceTicks;
+    unsigned int _clickTicks;
+    unsigned int _pressTicks;
+    callbackFunction _clickFunc;
+    callbackFunction _longPressStartFunc;
+    callbackFunction _longPressStopFunc;
+    stateMachine_t _state;
+    unsigned long _startTime;
+};
+
+#endif /* _NATIVE_ONE_BUTTON_H */
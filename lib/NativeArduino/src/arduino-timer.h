@@ -0,0 +1,211 @@
+#ifndef _NATIVE_ARDUINO_TIMER_H
+#define _NATIVE_ARDUINO_TIMER_H
+
+// Host stand-in for contrem/arduino-timer 3.x.  Scheduling semantics match
+// the real library, including repeating tasks restarting from the tick
+// time at which they ran (so late ticks accumulate as drift).
+
+#include <Arduino.h>
+
+#ifndef TIMER_MAX_TASKS
+    #define TIMER_MAX_TASKS 0x10
+#endif
+
+template <
+    size_t max_tasks = TIMER_MAX_TASKS,
+    unsigned long (*time_func)() = millis,
+    typename T = void *
+>
+class Timer
+{
+    public:
+
+    typedef uintptr_t Task;
+    typedef bool (*handler_t)(T opaque);
+
+    Timer()
+    {
+        cancel();
+    }
+
+    // Call handler with opaque as argument in delay units of time
+    Task in(unsigned long delay, handler_t h, T opaque = T())
+    {
+        return task_id(add_task(time_func(), delay, h, opaque));
+    }
+
+    // Call handler with opaque as argument at time
+    Task at(unsigned long time, handler_t h, T opaque = T())
+    {
+        const unsigned long now = time_func();
+        return task_id(add_task(now, time - now, h, opaque));
+    }
+
+    // Call handler with opaque as argument every interval units of time
+    Task every(unsigned long interval, handler_t h, T opaque = T())
+    {
+        return task_id(add_task(time_func(), interval, h, opaque, interval));
+    }
+
+    // Cancel the timer task
+    void cancel(Task &task)
+    {
+        if (!task)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < max_tasks; i++)
+        {
+            struct task * const t = &tasks[i];
+            if (t->handler && task_id(t) == task)
+            {
+                remove(t);
+                break;
+            }
+        }
+
+        task = (Task)NULL;
+    }
+
+    // Cancel all timer tasks
+    void cancel()
+    {
+        for (size_t i = 0; i < max_tasks; i++)
+        {
+            remove(&tasks[i]);
+        }
+    }
+
+    // Ticks the timer forward - call this function in loop()
+    unsigned long tick()
+    {
+        unsigned long ticks = (unsigned long)-1;
+
+        for (size_t i = 0; i < max_tasks; i++)
+        {
+            struct task * const task = &tasks[i];
+
+            if (task->handler)
+            {
+                const unsigned long t = time_func();
+                const unsigned long duration = t - task->start;
+
+                if (duration >= task->expires)
+                {
+                    task->repeat = task->handler(task->opaque) && task->repeat;
+
+                    if (task->repeat)
+                    {
+                        task->start = t;
+                    }
+                    else
+                    {
+                        remove(task);
+                    }
+                }
+                else
+                {
+                    const unsigned long remaining = task->expires - duration;
+                    ticks = remaining < ticks ? remaining : ticks;
+                }
+            }
+        }
+
+        return ticks == (unsigned long)-1 ? 0 : ticks;
+    }
+
+    // Number of active tasks
+    size_t size() const
+    {
+        size_t s = 0;
+        for (size_t i = 0; i < max_tasks; i++)
+        {
+            if (tasks[i].handler)
+            {
+                s++;
+            }
+        }
+        return s;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    private:
+
+    size_t ctr;
+
+    struct task
+    {
+        handler_t handler;
+        T opaque;
+        unsigned long start;
+        unsigned long expires;
+        size_t repeat;
+        size_t id;
+    } tasks[max_tasks];
+
+    void remove(struct task *task)
+    {
+        task->handler = NULL;
+        task->opaque = T();
+        task->start = 0;
+        task->expires = 0;
+        task->repeat = 0;
+        task->id = 0;
+    }
+
+    Task task_id(const struct task * const t)
+    {
+        const Task id = (Task)t;
+        return id ? id ^ t->id : id;
+    }
+
+    struct task *next_task_slot()
+    {
+        for (size_t i = 0; i < max_tasks; i++)
+        {
+            if (tasks[i].handler == NULL)
+            {
+                return &tasks[i];
+            }
+        }
+        return NULL;
+    }
+
+    struct task *add_task(unsigned long start, unsigned long expires,
+                          handler_t h, T opaque, bool repeat = 0)
+    {
+        struct task * const slot = next_task_slot();
+
+        if (!slot)
+        {
+            return NULL;
+        }
+
+        if (++ctr == 0)
+        {
+            ++ctr;
+        }
+
+        slot->id = ctr;
+        slot->handler = h;
+        slot->opaque = opaque;
+        slot->start = start;
+        slot->expires = expires;
+        slot->repeat = repeat;
+
+        return slot;
+    }
+};
+
+// Create a timer with the default number of tasks
+inline Timer<> timer_create_default()
+{
+    return Timer<>();
+}
+
+#endif /* _NATIVE_ARDUINO_TIMER_H */
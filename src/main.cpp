@@ -1,32 +1,84 @@
 // INCLUDES
-#include <math.h>       /* pow */
 #include <EEPROM.h>
 #include <arduino-timer.h>
 #include <Adafruit_NeoPixel.h>
 #include <OneButton.h>
 #include "NeoPatterns.h"
-
-#define DEBUG 1
-// Just making a change
+#include "OperationState.h"
+#include "ConfigMenu.h"
+#include "LightSequencer.h"
+#include "EventQueue.h"
+#include "RcPwmDecoder.h"
+#include "RcBusDecoder.h"
+#include "PinChangeDecoder.h"
+#include "FrameCompositor.h"
+#include "RcFrameScheduler.h"
+#include "RcSignalMonitor.h"
+#include "Envelope.h"
+#include "EepromRecordStore.h"
+#include "SerialProtocol.h"
+
+// Log level (see EventLog.h): LOG_LEVEL_NONE compiles logging out entirely
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#include "EventLog.h"
+
+// Per-stage loop() timing (see LoopProfiler.h): define LOOP_PROFILER to
+// compile it in (the native build does)
+#include "LoopProfiler.h"
+
+// Stack and heap high-water marks (see MemoryWatermark.h)
+#include "MemoryWatermark.h"
+
+// RC ISR run times, reported with the event log at debug level: define
+// ISR_TIMING to compile them in (the native build does)
 
 // TYPES
-typedef enum e_operation_state {
-    OPERATION_STATE_INIT,
-    OPERATION_STATE_CONFIG_MAIN_ON_NAV,     // Order is important as enum
-    OPERATION_STATE_CONFIG_MAIN_ON_STROBE,  // value is used in calculation
-    OPERATION_STATE_CONFIG_MAIN_ON_BEACON,
-    OPERATION_STATE_CONFIG_MAIN_ON_LANDING,
-    OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET,
-    OPERATION_STATE_CONFIG_IN_NAV,             
-    OPERATION_STATE_CONFIG_IN_STROBE,          
-    OPERATION_STATE_CONFIG_IN_BEACON,
-    OPERATION_STATE_CONFIG_IN_LANDING,
-    OPERATION_STATE_CONFIG_IN_FACTORY_RESET,
-    OPERATION_STATE_NORMAL,
-    OPERATION_STATE_RAINBOW,
-    OPERATION_STATE_CHASE
-} eOperationState;
-
+typedef enum e_sequence_segment {
+    SEQUENCE_SEGMENT_STROBE     // strobe segment of both nav strings
+} eSequenceSegment;
+
+typedef enum e_rc_event {
+    RC_EVENT_LANDING_LED_EDGE,
+    RC_EVENT_NAV_DISPLAY_MODE_EDGE,
+    RC_EVENT_PPM_EDGE
+} eRcEvent;
+
+// The functions the receiver controls (with RC_INPUT_PWM, one pin each)
+typedef enum e_rc_channel {
+    RC_CHANNEL_LANDING_LED,
+    RC_CHANNEL_NAV_DISPLAY_MODE,
+    RC_CHANNEL_COUNT
+} eRcChannel;
+
+typedef enum e_landing_led_position {
+    LANDING_LED_POSITION_OFF,
+    LANDING_LED_POSITION_ON
+} eLandingLedPosition;
+
+typedef enum e_nav_display_mode_position {
+    NAV_DISPLAY_MODE_POSITION_NAV,
+    NAV_DISPLAY_MODE_POSITION_RAINBOW,
+    NAV_DISPLAY_MODE_POSITION_CHASE
+} eNavDisplayModePosition;
+
+// What the lights do when the receiver's signal is lost
+typedef enum e_failsafe_pattern {
+    FAILSAFE_PATTERN_STROBE,    // fast white strobes on every LED of every strip
+    FAILSAFE_PATTERN_NAV,       // steady nav lights, landing lights on
+    FAILSAFE_PATTERN_HOLD,      // keep the current mode (no failsafe)
+    FAILSAFE_PATTERN_COUNT
+} eFailsafePattern;
+
+typedef struct s_isr_timing {
+    uint32_t count;                  // ISR invocations
+    uint32_t total_micro_seconds;    // total time spent in the ISRs
+    uint16_t max_micro_seconds;      // longest single ISR
+} sIsrTiming;
+
+// Legacy (pre config record) EEPROM layout: one byte per setting.  Only
+// read once, to carry the settings over into the config record.
 typedef enum e_eeprom_address {
     EEPROM_ADDRESS_NAV_LED_SEGMENT_COUNT,
     EEPROM_ADDRESS_STROBE_LED_SEGMENT_COUNT,
@@ -38,38 +90,203 @@ typedef enum e_eeprom_address {
     EEPROM_ADDRESS_LANDING_LED_SEGMENT_START_INDEX
 } eEepromAddress;
 
+// What a segment of the segment table shows
+typedef enum e_segment_role {
+    SEGMENT_ROLE_NAV,       // red on the port nav strip, green on any other
+    SEGMENT_ROLE_STROBE,
+    SEGMENT_ROLE_BEACON,
+    SEGMENT_ROLE_LANDING,
+    SEGMENT_ROLE_COUNT
+} eSegmentRole;
+
+// A run of LEDs with one role, at the same place on one or more strips
+typedef struct s_segment {
+    uint8_t strips;     // STRIP_MASK_* bits, one per entry of all_strips
+    uint8_t start;
+    uint8_t count;      // 0 = unused entry
+    uint8_t role;       // eSegmentRole
+} sSegment;
+
+// Segments beyond the one per role, e.g. a second nav light further along
+// a strip
+#define CONFIG_EXTRA_SEGMENT_COUNT 2
+
+// PPM/SBUS/iBUS channel or pin change input (0 = the first) that drives
+// each eRcChannel, or RC_BUS_CHANNEL_NONE
+#define RC_BUS_CHANNEL_NONE 0xFF
+
+// Settings as stored in EEPROM.  Only ever append fields (older records
+// are read over the defaults, see read_eeprom()) and bump
+// CONFIG_RECORD_VERSION when doing so.
+typedef struct s_config_record {
+    uint8_t nav_led_segment_count;
+    uint8_t strobe_led_segment_count;
+    uint8_t beacon_led_segment_count;
+    uint8_t landing_led_segment_count;
+    uint8_t nav_led_segment_start_index;
+    uint8_t strobe_led_segment_start_index;
+    uint8_t beacon_led_segment_start_index;
+    uint8_t landing_led_segment_start_index;
+    sSegment extra_segments[CONFIG_EXTRA_SEGMENT_COUNT];   // since version 2
+    uint8_t failsafe_pattern;                               // eFailsafePattern, since version 3
+    uint8_t rc_bus_channels[RC_CHANNEL_COUNT];              // since version 4, see below
+} sConfigRecord;
+
+// Serial protocol message types (frames as in SerialProtocol.h).  Replies
+// to GET_* commands have the command type with the top bit set.  A reply
+// that does not fit in the TX buffer is dropped rather than stalling loop();
+// every command is idempotent, so the host simply retries on a timeout.
+typedef enum e_serial_message {
+    SERIAL_MESSAGE_GET_CONFIG = 0x01,     // -> CONFIG
+    SERIAL_MESSAGE_SET_CONFIG = 0x02,     // sConfigRecord -> ACK / NAK
+    SERIAL_MESSAGE_SET_MODE = 0x03,       // eNavDisplayModePosition -> ACK / NAK
+    SERIAL_MESSAGE_STREAM_STATUS = 0x04,  // uint16_t interval in msecs, 0 = off -> ACK
+    SERIAL_MESSAGE_GET_STATUS = 0x05,     // -> STATUS
+    SERIAL_MESSAGE_GET_PROFILE = 0x07,    // eLoopStage -> PROFILE (LOOP_PROFILER builds)
+    SERIAL_MESSAGE_RESET_PROFILE = 0x08,  // -> ACK (LOOP_PROFILER builds)
+    SERIAL_MESSAGE_GET_MEMORY = 0x09,     // -> MEMORY
+    SERIAL_MESSAGE_CONFIG = 0x81,         // sConfigRecord
+    SERIAL_MESSAGE_STATUS = 0x85,         // sStatusReport
+    SERIAL_MESSAGE_LOG = 0x86,            // sLogRecord[], sent unasked when idle
+    SERIAL_MESSAGE_PROFILE = 0x87,        // eLoopStage, sLoopStageStats
+    SERIAL_MESSAGE_MEMORY = 0x89,         // sMemoryStatus
+    SERIAL_MESSAGE_ACK = 0xF0,            // command type
+    SERIAL_MESSAGE_NAK = 0xF1             // command type, eSerialNakReason
+} eSerialMessage;
+
+typedef enum e_serial_nak_reason {
+    SERIAL_NAK_UNKNOWN_MESSAGE,
+    SERIAL_NAK_BAD_LENGTH,
+    SERIAL_NAK_BAD_VALUE,       // config failed is_config_valid(), or no such mode
+    SERIAL_NAK_BUSY,            // in the config menu or failsafe
+    SERIAL_NAK_RC_OVERRIDE      // the receiver's mode switch is in control
+} eSerialNakReason;
+
+// loop() stages timed by the loop profiler, in the order they run
+typedef enum e_loop_stage {
+    LOOP_STAGE_TIMER,               // timer.tick()
+    LOOP_STAGE_COLOR_TIMER,         // color_timer.tick()
+    LOOP_STAGE_BUTTON,              // button.tick()
+    LOOP_STAGE_RC_EVENTS,           // process_rc_events()
+    LOOP_STAGE_SERIAL,              // process_serial_commands()
+    LOOP_STAGE_CONFIG_STATES,       // manage_config_states()
+    LOOP_STAGE_FRAME_TICK,          // frame clock and RC signal check, up to the render (frame passes only)
+    LOOP_STAGE_RUNNING_STATES,      // manage_running_states(), the render (frame passes only)
+    LOOP_STAGE_FLUSH,               // rest of compositor.Update(): flush gate and flush
+    LOOP_STAGE_LOG,                 // drain_event_log()
+    LOOP_STAGE_MEMORY,              // scan_memory()
+    LOOP_STAGE_LOOP,                // the whole pass
+    LOOP_STAGE_COUNT
+} eLoopStage;
+
+// Log record ids.  The comments are the host side format strings, used by
+// tools/log_decode.py: {n} is argument n, {n:state} an eOperationState and
+// {n:on_off} a flag.  Only ever append ids.
+typedef enum e_log_event {
+    LOG_EVENT_OVERFLOW = LOG_EVENT_ID_OVERFLOW,  // "Log overflow, {0} records lost"
+    LOG_EVENT_STARTING,                 // "Starting Nav Lights"
+    LOG_EVENT_STATE_TRANSITION,         // "State transition to {0:state}"
+    LOG_EVENT_CONFIG_RECORD_CREATED,    // "Initializing EEPROM config record"
+    LOG_EVENT_CONFIG_RECORD_MIGRATED,   // "Migrating EEPROM config record from version {0}"
+    LOG_EVENT_CONFIG_RECORD_SAVED,      // "Updating EEPROM"
+    LOG_EVENT_FACTORY_RESET,            // "Doing factory reset"
+    LOG_EVENT_MODIFYING_SEGMENT,        // "Modifying segment count in {0:state}"
+    LOG_EVENT_LANDING_LIGHTS,           // "Landing lights {0:on_off}, pulse {1} us"
+    LOG_EVENT_DISPLAY_MODE,             // "Display mode {0:state}, pulse {1} us"
+    LOG_EVENT_ISR_COUNT,                // "ISR count {0}, RC events dropped {1}"
+    LOG_EVENT_ISR_TIMING,               // "ISR avg {0} us, max {1} us"
+    LOG_EVENT_FRAME_COUNT,              // "Frames {0}, dropped {1}"
+    LOG_EVENT_RENDER_TIMING,            // "Render avg {0} us, max {1} us"
+    LOG_EVENT_FLUSH_TIMING,             // "Flush avg {0} us, max {1} us"
+    LOG_EVENT_SHOWS_DEFERRED,           // "Shows deferred {0}, collisions avoided {1}"
+    LOG_EVENT_SHOWS_FORCED,             // "Shows forced {0}, unscheduled {1}"
+    LOG_EVENT_STACK,                    // "Stack peak {0} B, {1} B never touched"
+    LOG_EVENT_HEAP,                     // "Heap {0} B, peak {1} B"
+    LOG_EVENT_MEMORY_LOW,               // "Stack came within {0} B of the heap"
+    LOG_EVENT_RC_SIGNAL_LOST,           // "RC signal lost on channel {0}, {1} ms after its last pulse"
+    LOG_EVENT_RC_SIGNAL_RESTORED        // "RC signal restored after {0} ms in failsafe"
+} eLogEvent;
+
+// STATUS payload (little endian, no padding on AVR or the host)
+typedef struct s_status_report {
+    uint32_t time_in_milliseconds;
+    uint16_t landing_led_pulse_width_in_micro_seconds;
+    uint16_t nav_display_mode_pulse_width_in_micro_seconds;
+    uint16_t frames_dropped;    // frame clock ticks dropped so far
+    uint8_t operation_state;
+    uint8_t flags;              // STATUS_FLAG_*
+} sStatusReport;
+
 // FUNCTION DECLARATIONS
-void initialize_eeprom_if_needed();
-bool initialize_eeprom_address_if_needed(eEepromAddress eepromAddress, int eepromValue);
 void read_eeprom();
 void update_eeprom();
+void default_config(sConfigRecord *config);
+bool read_legacy_eeprom(sConfigRecord *config);
+bool is_config_valid(const sConfigRecord *config);
+void apply_config(const sConfigRecord *config);
+void capture_config(sConfigRecord *config);
+
+// Serial protocol functions
+void process_serial_commands();
+void handle_serial_frame(const sSerialFrame *frame);
+bool send_serial_frame(uint8_t type, const void *payload, uint8_t length);
+void send_serial_nak(uint8_t type, eSerialNakReason reason);
+void send_status_report();
+bool is_running_state();
+void drain_event_log();
+void send_loop_profile(uint8_t stage);
+void scan_memory();
 
 void initialize_nav_lights();
 void turn_off_nav_lights();
-
-// Nav Strobe functions called by timer
-bool start_nav_strobe_on_1(void *);
-bool start_nav_strobe_off_1(void *);
-bool start_nav_strobe_on_2(void *);
-bool start_nav_strobe_off_2(void *);
-
-bool turn_on_nav_strobe(void *);
-bool turn_off_nav_strobe(void *);
-
-// Beacon functions called by timer
-bool start_on_beacon(void *);
-bool start_off_beacon(void *);
-
-bool turn_on_beacon(void *);
-bool turn_off_beacon(void *);
+void resize_strips();
+void segment_strip_lengths(const sSegment *table, uint16_t *lengths);
+uint16_t segment_pixel_bytes(const sSegment *table);
+uint16_t config_pixel_bytes(const sConfigRecord *config);
+bool segments_fit_pixel_pool();
+void config_segment_table(const sConfigRecord *config, sSegment *table);
+void render_segments();
+
+// Strobe sequence functions
+bool run_light_sequencer(void *);
+void apply_light_sequence_step(uint8_t segment, uint32_t color);
+
+// RC Receiver Event Functions
+void process_rc_events();
+void record_isr_time(unsigned long isr_start_time_in_micro_seconds);
+void report_isr_timing();
+void report_frame_timing();
+bool decode_rc_edge(eRcChannel channel, unsigned long edge_time_in_micro_seconds);
+bool accept_rc_pulse(eRcChannel channel, unsigned long pulse_end_in_micro_seconds);
+void check_rc_signal();
+void enter_failsafe();
+void leave_failsafe();
+void render_failsafe();
+bool can_flush_strips(unsigned long now_in_micro_seconds, uint16_t duration_in_micro_seconds);
 
 // Landing Lights Functions
 void LandingLightsPulseWidthTimer();
-void manage_landing_lights();
+void handle_landing_lights_edge(unsigned long edge_time_in_micro_seconds);
+void apply_landing_lights();
 
 // Color Mode Receiver Channel Functions
 void NavDisplayModePulseWidthTimer();
-void manage_nav_display_mode();
+void handle_nav_display_mode_edge(unsigned long edge_time_in_micro_seconds);
+void apply_nav_display_mode();
+
+// Single pin receiver input (PPM, SBUS or iBUS)
+void PpmEdgeTimer();
+void handle_ppm_edge(unsigned long edge_time_in_micro_seconds);
+void handle_rc_bus_frame(const sRcBusFrame *frame, unsigned long frame_end_in_micro_seconds,
+        uint16_t frame_duration_in_micro_seconds);
+void decode_rc_width(eRcChannel channel, unsigned long pulse_end_in_micro_seconds,
+        uint16_t pulse_width_in_micro_seconds, uint16_t pulse_duration_in_micro_seconds);
+
+// Pin change receiver input (a pin per channel on port B)
+void RcPinChangeTimer();
+void process_pin_changes();
+void handle_pin_change(uint8_t levels, unsigned long sample_time_in_micro_seconds);
+void set_nav_display_mode(eNavDisplayModePosition position);
 
 // Config functions called by timer
 bool turn_on_first_nav_led_no_repeat(void *);
@@ -78,6 +295,8 @@ bool turn_off_first_nav_led_no_repeat(void *);
 bool toggle_first_nav_led_with_color(uint32_t color);
 
 void blink_nav_for_number_of_segments(int num_of_blinks);
+void step_segment_count(uint8_t role);
+bool blink_nav_segment_count_tick(void *);
 
 bool turn_on_first_nav_led_with_color_no_repeat(uint32_t color);
 
@@ -91,6 +310,7 @@ void set_nav_lights_to_theater_chase();
 void update_color_mode_for_nav_lights();
 
 // Running State Management
+void render_frame();
 void manage_running_states();
 
 // Configuration Button functions
@@ -99,6 +319,17 @@ void long_click_start();
 
 // Configuration State Management
 void manage_config_states();
+bool dispatch_menu_event(eMenuEvent event);
+bool menu_start_display_mode(const sMenuTransition *transition);
+bool menu_enter_config(const sMenuTransition *transition);
+bool menu_exit_config(const sMenuTransition *transition);
+bool menu_show_segment_count(const sMenuTransition *transition);
+bool menu_step_segment_count(const sMenuTransition *transition);
+bool menu_leave_segment_count(const sMenuTransition *transition);
+bool menu_prompt_factory_reset(const sMenuTransition *transition);
+bool menu_factory_reset(const sMenuTransition *transition);
+bool menu_leave_factory_reset(const sMenuTransition *transition);
+bool menu_clear_failsafe(const sMenuTransition *transition);
 
 // STATIC DEFINES
 // Pin #s of Strings
@@ -107,21 +338,104 @@ void manage_config_states();
 #define BEACON_LED_STRING_PIN 6
 #define LANDING_LED_STRING_PIN 7
 
-// Pin #s for Nav Modes
+// Receiver input: a PWM pin per function (the two INT pins), or every
+// channel on one pin: a PPM sum signal, or SBUS / iBUS frames on the
+// serial port (which then belongs to the receiver: no serial protocol), or
+// a PWM pin per receiver channel on the port B pin change interrupt
+#define RC_INPUT_PWM 0
+#define RC_INPUT_PPM 1
+#define RC_INPUT_SBUS 2
+#define RC_INPUT_IBUS 3
+#define RC_INPUT_PCINT 4
+
+#ifndef RC_INPUT
+#define RC_INPUT RC_INPUT_PWM
+#endif
+
+#define RC_IS_SERIAL_BUS (RC_INPUT == RC_INPUT_SBUS || RC_INPUT == RC_INPUT_IBUS)
+
+// Pin #s for Nav Modes (RC_INPUT_PWM)
 #define LANDING_LED_TOGGLE_PIN 2
 #define NAV_DISPLAY_MODE_PIN 3
 
+// PPM sum signal pin (RC_INPUT_PPM)
+#define RC_PPM_PIN 2
+
+// Pin change inputs (RC_INPUT_PCINT): digital pins 8 (input 0) to 13
+// (input 5), PB0-PB5.  Port D is taken by the serial port and the strips.
+#define RC_PCINT_FIRST_PIN 8
+#define RC_PCINT_INPUTS 6
+#define RC_PCINT_MASK 0x3F
+
+// Serial bus port settings, and the time a frame takes on the wire (for
+// the flush scheduler, as the "pulse" of every function)
+#define RC_SBUS_BAUD_RATE 100000
+#define RC_SBUS_FRAME_IN_MICRO_SECONDS (RC_SBUS_FRAME_SIZE * 120)
+#define RC_IBUS_BAUD_RATE 115200
+#define RC_IBUS_FRAME_IN_MICRO_SECONDS (RC_IBUS_FRAME_SIZE * 87)
+
+// Default bus channels: AUX channels 5 and 6, or pins 8 and 9
+#if RC_INPUT == RC_INPUT_PCINT
+#define DEFAULT_LANDING_LED_BUS_CHANNEL 0
+#define DEFAULT_NAV_DISPLAY_MODE_BUS_CHANNEL 1
+#else
+#define DEFAULT_LANDING_LED_BUS_CHANNEL 4
+#define DEFAULT_NAV_DISPLAY_MODE_BUS_CHANNEL 5
+#endif
+
 // Default LEDs in Segments
 #define DEFAULT_NAV_LED_SEGMENT_COUNT 1
 #define DEFAULT_STROBE_LED_SEGMENT_COUNT 1
 #define DEFAULT_BEACON_LED_SEGMENT_COUNT 1
 #define DEFAULT_LANDING_LED_SEGMENT_COUNT 2
 
-// Max LEDs in Segments
-#define MAX_NAV_LED_SEGMENT_COUNT 2
-#define MAX_STROBE_LED_SEGMENT_COUNT 2
-#define MAX_BEACON_LED_SEGMENT_COUNT 2
-#define MAX_LANDING_LED_SEGMENT_COUNT 3
+#define STRIP_COUNT 4
+
+// sSegment strips bits, in all_strips order
+#define STRIP_MASK_PORT_NAV 0x01
+#define STRIP_MASK_STARBOARD_NAV 0x02
+#define STRIP_MASK_BEACON 0x04
+#define STRIP_MASK_LANDING 0x08
+#define STRIP_MASK_ALL 0x0F
+
+// Segment table: the segment of each role (entry = eSegmentRole) and then
+// the config record's extra segments
+#define SEGMENT_TABLE_SIZE (SEGMENT_ROLE_COUNT + CONFIG_EXTRA_SEGMENT_COUNT)
+
+// Pixel memory.  Every strip's render and wire buffers are laid out in one
+// pool for the configured segment counts, so any mix of segment lengths
+// that fits the pool is allowed.  The reserve is the SRAM the rest of the
+// firmware needs.  SRAM_STATIC_BYTES is its .data + .bss without the pool,
+// about 1.3 KB on a Nano: timer ~194 bytes, the four strips ~288, Serial
+// ~157, the event log 132, the RC event queue ~98, then the color timer,
+// button, compositor, RC decoders and serial parser.  `avr-size -A` of
+// the nanoatmega328 build gives the exact figure (.data + .bss minus
+// PIXEL_POOL_BYTES); update it when adding globals.  SRAM_STACK_BYTES is
+// the headroom kept for the stack and the ISRs; GET_MEMORY's stack depth
+// shows what a run really used.  Builds for a board with more SRAM can
+// raise PIXEL_POOL_BYTES.
+#define PIXEL_CHANNELS 3                          // NEO_GRB
+#define PIXEL_BYTES_PER_LED (2 * PIXEL_CHANNELS)  // render + wire buffer
+#ifndef PIXEL_POOL_BYTES
+#define PIXEL_POOL_BYTES 384                      // 64 LEDs
+#endif
+#define PIXEL_POOL_LEDS (PIXEL_POOL_BYTES / PIXEL_BYTES_PER_LED)
+#define SRAM_STATIC_BYTES 1320
+#define SRAM_STACK_BYTES 256
+#define SRAM_RESERVE_BYTES (SRAM_STATIC_BYTES + SRAM_STACK_BYTES)
+
+#if defined(RAMEND) && defined(RAMSTART) && PIXEL_POOL_BYTES + SRAM_RESERVE_BYTES > RAMEND - RAMSTART + 1
+#error "PIXEL_POOL_BYTES leaves too little SRAM for the rest of the firmware"
+#endif
+
+// Max LEDs in Segments: the most the pool holds with every other segment
+// at 1 LED (nav and strobe take an LED on both nav strips), and at most
+// 255 as a count is one byte in sConfigRecord
+#define SEGMENT_COUNT_LIMIT(leds) (((leds) > 255) ? 255 : (leds))
+#define MAX_NAV_LED_SEGMENT_COUNT SEGMENT_COUNT_LIMIT((PIXEL_POOL_LEDS - 2) / 2 - 1)
+#define MAX_STROBE_LED_SEGMENT_COUNT SEGMENT_COUNT_LIMIT((PIXEL_POOL_LEDS - 2) / 2 - 1)
+#define MAX_BEACON_LED_SEGMENT_COUNT SEGMENT_COUNT_LIMIT(PIXEL_POOL_LEDS - 2 * 2 - 1)
+#define MAX_LANDING_LED_SEGMENT_COUNT SEGMENT_COUNT_LIMIT(PIXEL_POOL_LEDS - 2 * 2 - 1)
 
 // Start index of Segments in String
 #define DEFAULT_NAV_LED_SEGMENT_START_INDEX 0
@@ -129,9 +443,39 @@ void manage_config_states();
 #define DEFAULT_BEACON_LED_SEGMENT_START_INDEX 0
 #define DEFAULT_LANDING_LED_SEGMENT_START_INDEX 0
 
+#if (2 * (DEFAULT_NAV_LED_SEGMENT_COUNT + DEFAULT_STROBE_LED_SEGMENT_COUNT) + DEFAULT_BEACON_LED_SEGMENT_COUNT \
+        + DEFAULT_LANDING_LED_SEGMENT_COUNT) * PIXEL_BYTES_PER_LED > PIXEL_POOL_BYTES
+#error "The default segment counts do not fit in PIXEL_POOL_BYTES"
+#endif
+
 // EEPROM definitions
 #define EEPROM_ADDRESS_EMPTY 255
 
+// Config record: version of sConfigRecord, and the wear leveled slots it
+// rotates through (placed after the legacy per-byte settings)
+#define CONFIG_RECORD_VERSION 4
+#define CONFIG_STORE_BASE_ADDRESS 16
+#define CONFIG_STORE_SLOT_COUNT 8
+#define CONFIG_STORE_SLOT_SIZE 32
+
+// Serial port (protocol frames only)
+#define SERIAL_BAUD_RATE 115200
+
+// Most received bytes parsed per loop() pass (the RX ring holds 64)
+#define SERIAL_PARSE_BUDGET_BYTES 16
+
+// Log ring size (records, power of two), records per LOG frame, and the
+// least time to the next frame tick for loop() to count as idle
+#define LOG_BUFFER_RECORDS 16
+#define LOG_RECORDS_PER_FRAME (SERIAL_FRAME_MAX_PAYLOAD / sizeof(sLogRecord))
+#define LOG_DRAIN_MIN_IDLE_IN_MICRO_SECONDS 2000
+
+// sStatusReport flags
+#define STATUS_FLAG_LANDING_LIGHTS_ON 0x01
+#define STATUS_FLAG_LANDING_LED_RC_LOCKED 0x02
+#define STATUS_FLAG_NAV_DISPLAY_MODE_RC_LOCKED 0x04
+#define STATUS_FLAG_RC_SIGNAL_LOST 0x08
+
 // Neo Pixel Brightness
 #define NEO_PIXEL_BRIGHTNESS 12 //255 //12
 
@@ -143,20 +487,17 @@ void manage_config_states();
 #define CONFIG_MENU_ITEM_DURATION_IN_MSECS 3000
 
 // VARS
-// Count of LEDs in Segments
-int nav_led_segment_count = DEFAULT_NAV_LED_SEGMENT_COUNT;
-int strobe_led_segment_count = DEFAULT_STROBE_LED_SEGMENT_COUNT;
-int beacon_led_segment_count = DEFAULT_BEACON_LED_SEGMENT_COUNT;
-int landing_led_segment_count = DEFAULT_LANDING_LED_SEGMENT_COUNT;
-
-// Start index of Segments in String
-int nav_led_segment_start_index = DEFAULT_NAV_LED_SEGMENT_START_INDEX;
-int strobe_led_segment_start_index = DEFAULT_STROBE_LED_SEGMENT_START_INDEX;
-int beacon_led_segment_start_index = DEFAULT_BEACON_LED_SEGMENT_START_INDEX;
-int landing_led_segment_start_index = DEFAULT_LANDING_LED_SEGMENT_START_INDEX;
-
-// Count of LEDs in Strings
-int nav_and_strobe_led_string_count = nav_led_segment_count + strobe_led_segment_count;
+// Segment table (see config_segment_table()); strip lengths follow from it
+sSegment segment_table[SEGMENT_TABLE_SIZE] = {
+    { STRIP_MASK_PORT_NAV | STRIP_MASK_STARBOARD_NAV,
+            DEFAULT_NAV_LED_SEGMENT_START_INDEX, DEFAULT_NAV_LED_SEGMENT_COUNT, SEGMENT_ROLE_NAV },
+    { STRIP_MASK_PORT_NAV | STRIP_MASK_STARBOARD_NAV,
+            DEFAULT_STROBE_LED_SEGMENT_START_INDEX, DEFAULT_STROBE_LED_SEGMENT_COUNT, SEGMENT_ROLE_STROBE },
+    { STRIP_MASK_BEACON,
+            DEFAULT_BEACON_LED_SEGMENT_START_INDEX, DEFAULT_BEACON_LED_SEGMENT_COUNT, SEGMENT_ROLE_BEACON },
+    { STRIP_MASK_LANDING,
+            DEFAULT_LANDING_LED_SEGMENT_START_INDEX, DEFAULT_LANDING_LED_SEGMENT_COUNT, SEGMENT_ROLE_LANDING }
+};
 
 // Colors
 uint32_t black = Adafruit_NeoPixel::Color(0, 0, 0);
@@ -175,76 +516,317 @@ bool is_config_setting_modified = false;
 
 bool landing_lights_on = false;
 
+// Bus channel or pin change input of each eRcChannel (single pin or pin
+// change receiver input)
+uint8_t rc_bus_channels[RC_CHANNEL_COUNT] = {
+    DEFAULT_LANDING_LED_BUS_CHANNEL,
+    DEFAULT_NAV_DISPLAY_MODE_BUS_CHANNEL
+};
+
+// Failsafe (see check_rc_signal())
+uint8_t failsafe_pattern = FAILSAFE_PATTERN_STROBE;     // eFailsafePattern
+eNavDisplayModePosition failsafe_resume_position;       // mode to go back to
+unsigned long failsafe_start_in_milliseconds;
+
+uint32_t strobe_color = 0;   // set by the light sequencer
+
 bool toggle_first_nav_led_on = false;
 
-#define MAX_PULSE_WIDTH 2015
-#define HIGH_PWM_POSITION 1900
-#define MID_PWM_POSITION 1400
-#define LOW_PWM_POSITION 900
+// Config menu segment count blinks
+uint16_t segment_blink_ticks_remaining = 0;
+
+// Serial protocol
+uint16_t status_stream_interval_in_milliseconds = 0;  // 0 = not streaming
+unsigned long status_stream_last_in_milliseconds;
+uint16_t serial_frames_dropped = 0;   // replies not sent, TX buffer was full
+
+// RC PWM decoding
+#define RC_MIN_PULSE_WIDTH 800
+#define RC_MAX_PULSE_WIDTH 2200
+#define RC_PULSE_FILTER_SHIFT 2
+#define RC_DETENT_HYSTERESIS 100
+
+// Switch position boundaries (pulse widths in micro seconds)
+const uint16_t landing_led_detent_boundaries[] PROGMEM = { 1700 };
+const uint16_t nav_display_mode_detent_boundaries[] PROGMEM = { 1250, 1750 };
+
+const sRcDetentMap landing_led_detents = {
+    landing_led_detent_boundaries, 1, RC_DETENT_HYSTERESIS
+};
+
+const sRcDetentMap nav_display_mode_detents = {
+    nav_display_mode_detent_boundaries, 2, RC_DETENT_HYSTERESIS
+};
+
+RcPwmDecoder<RC_CHANNEL_COUNT> rc_decoder(RC_MIN_PULSE_WIDTH, RC_MAX_PULSE_WIDTH, RC_PULSE_FILTER_SHIFT);
+
+// RC Receiver Event Queue (ISRs only capture edge timestamps)
+#define RC_EVENT_QUEUE_SIZE 16
+#define ISR_TIMING_REPORT_INTERVAL_IN_MSECS 5000
+
+// Memory high-water marks: scan interval, and the least untouched SRAM
+// between heap and stack before scan_memory() warns
+#define MEMORY_SCAN_INTERVAL_IN_MSECS 5000
+#define MEMORY_FREE_WARN_BYTES 64
+
+// Frame clock: every strip is rendered and flushed together at this rate
+#define TARGET_FRAMES_PER_SECOND 100
+
+// Flushes are started clear of predicted RC pulse edges by this margin, and
+// held back at most one RC frame before going out regardless
+#define RC_FRAME_GUARD_IN_MICRO_SECONDS 150
+#define RC_FRAME_MAX_HOLD_IN_MICRO_SECONDS 25000
+
+RcFrameScheduler<RC_CHANNEL_COUNT> rc_frame_scheduler(RC_FRAME_GUARD_IN_MICRO_SECONDS,
+        RC_FRAME_MAX_HOLD_IN_MICRO_SECONDS);
+
+EventQueue<RC_EVENT_QUEUE_SIZE> rc_event_queue;
+
+#if RC_INPUT == RC_INPUT_PPM
+PpmDecoder rc_bus_decoder;
+#elif RC_INPUT == RC_INPUT_SBUS
+SbusParser rc_bus_decoder;
+#elif RC_INPUT == RC_INPUT_IBUS
+IbusParser rc_bus_decoder;
+#elif RC_INPUT == RC_INPUT_PCINT
+// Port B samples from the pin change ISR (the event type holds the levels)
+EventQueue<RC_EVENT_QUEUE_SIZE> rc_pin_change_queue;
+PinChangeDecoder rc_pin_change_decoder(RC_PCINT_MASK);
+volatile uint8_t rc_pin_change_levels;      // levels of the last sample (ISR side)
+uint16_t rc_pin_change_dropped;             // queue drops already resynced (loop side)
+#endif
+
+// Signal loss: checked on every frame tick, so detection takes at most
+// RC_SIGNAL_TIMEOUT_PERIODS RC frames plus one frame after the last pulse
+RcSignalMonitor<RC_CHANNEL_COUNT> rc_signal_monitor;
+
+volatile sIsrTiming isr_timing;
+unsigned long isr_timing_last_report_in_milliseconds;
+
+unsigned long memory_scan_last_in_milliseconds;
 
 // Landing Lights PWM vars
-volatile long landing_led_pulse_start_time_in_micro_seconds;
-volatile long landing_led_pulse_current_time_in_micro_seconds;
-volatile long landing_led_pulses;
 int landing_led_pulse_width_in_micro_seconds;
 
 // Nav Display Mode PWM vars
-volatile long nav_display_mode_pulse_start_time_in_micro_seconds;
-volatile long nav_display_mode_pulse_current_time_in_micro_seconds;
-volatile long nav_display_mode_pulses;
 int nav_display_mode_pulse_width_in_micro_seconds;
 
 // Times
-unsigned long long_button_press_start_time_in_milliseconds;
-unsigned long config_state_start_time_in_milliseconds;
 unsigned long current_time_in_milliseconds;
 unsigned long current_config_state_timer_in_milliseconds;
-unsigned long config_loop_duration_in_milliseconds
-        = (int)(OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET)
-        * CONFIG_MENU_ITEM_DURATION_IN_MSECS;
+
+// Strobe flash profile: double strobe flash (the beacon follows an envelope)
+const sSequenceStep nav_light_sequence_steps[] PROGMEM = {
+    {   0, SEQUENCE_SEGMENT_STROBE, SEQUENCE_COLOR(255, 255, 255) },
+    {  50, SEQUENCE_SEGMENT_STROBE, SEQUENCE_COLOR(0, 0, 0) },
+    { 100, SEQUENCE_SEGMENT_STROBE, SEQUENCE_COLOR(255, 255, 255) },
+    { 150, SEQUENCE_SEGMENT_STROBE, SEQUENCE_COLOR(0, 0, 0) }
+};
+
+const sSequenceProfile nav_light_sequence = {
+    nav_light_sequence_steps,
+    sizeof(nav_light_sequence_steps) / sizeof(nav_light_sequence_steps[0]),
+    1000
+};
+
+// Failsafe strobe: every LED flashes white, four times a second
+const sSequenceStep failsafe_light_sequence_steps[] PROGMEM = {
+    {   0, SEQUENCE_SEGMENT_STROBE, SEQUENCE_COLOR(255, 255, 255) },
+    {  40, SEQUENCE_SEGMENT_STROBE, SEQUENCE_COLOR(0, 0, 0) }
+};
+
+const sSequenceProfile failsafe_light_sequence = {
+    failsafe_light_sequence_steps,
+    sizeof(failsafe_light_sequence_steps) / sizeof(failsafe_light_sequence_steps[0]),
+    250
+};
+
+// Beacon envelope: shape, period and start relative to the strobe sequence
+#define BEACON_ENVELOPE_SHAPE ENVELOPE_EXPONENTIAL
+#define BEACON_ENVELOPE_PERIOD_IN_MSECS 1000
+#define BEACON_ENVELOPE_DELAY_IN_MSECS 500
+
+// Operation state machine: the display modes, and the config menu shown on
+// the first port nav LED.  A long click enters the menu, which steps through
+// its items on a timeout; a click opens an item and then adds an LED to
+// that segment (or, on factory reset, a long click resets).
+#define MENU_GREEN MENU_COLOR(0, 255, 0)
+#define MENU_BLUE MENU_COLOR(0, 0, 255)
+#define MENU_RED MENU_COLOR(255, 0, 0)
+#define MENU_YELLOW MENU_COLOR(255, 255, 0)
+#define MENU_PURPLE MENU_COLOR(255, 0, 255)
+
+const sMenuTransition menu_transitions[] PROGMEM = {
+    // Display modes
+    { OPERATION_STATE_NORMAL, MENU_EVENT_CLICK, OPERATION_STATE_RAINBOW, 0,
+            MENU_INDICATOR_NONE, menu_start_display_mode },
+    { OPERATION_STATE_RAINBOW, MENU_EVENT_CLICK, OPERATION_STATE_CHASE, 0,
+            MENU_INDICATOR_NONE, menu_start_display_mode },
+    { OPERATION_STATE_CHASE, MENU_EVENT_CLICK, OPERATION_STATE_NORMAL, 0,
+            MENU_INDICATOR_NONE, menu_start_display_mode },
+    { OPERATION_STATE_NORMAL, MENU_EVENT_LONG_CLICK, OPERATION_STATE_CONFIG_MAIN_ON_NAV, 0,
+            MENU_GREEN, menu_enter_config },
+    { OPERATION_STATE_RAINBOW, MENU_EVENT_LONG_CLICK, OPERATION_STATE_CONFIG_MAIN_ON_NAV, 0,
+            MENU_GREEN, menu_enter_config },
+    { OPERATION_STATE_CHASE, MENU_EVENT_LONG_CLICK, OPERATION_STATE_CONFIG_MAIN_ON_NAV, 0,
+            MENU_GREEN, menu_enter_config },
+
+    // Failsafe: a long click gives up on the lost channels (e.g. a receiver
+    // unplugged on purpose)
+    { OPERATION_STATE_FAILSAFE, MENU_EVENT_LONG_CLICK, OPERATION_STATE_NORMAL, 0,
+            MENU_INDICATOR_NONE, menu_clear_failsafe },
+
+    // Main menu
+    { OPERATION_STATE_CONFIG_MAIN_ON_NAV, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_STROBE, 0,
+            MENU_BLUE, NULL },
+    { OPERATION_STATE_CONFIG_MAIN_ON_STROBE, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_BEACON, 0,
+            MENU_RED, NULL },
+    { OPERATION_STATE_CONFIG_MAIN_ON_BEACON, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_LANDING, 0,
+            MENU_YELLOW, NULL },
+    { OPERATION_STATE_CONFIG_MAIN_ON_LANDING, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET, 0,
+            MENU_PURPLE, NULL },
+    { OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_NAV, 0,
+            MENU_GREEN, NULL },
+    { OPERATION_STATE_CONFIG_MAIN_ON_NAV, MENU_EVENT_CLICK, OPERATION_STATE_CONFIG_IN_NAV, SEGMENT_ROLE_NAV,
+            MENU_INDICATOR_NONE, menu_show_segment_count },
+    { OPERATION_STATE_CONFIG_MAIN_ON_STROBE, MENU_EVENT_CLICK, OPERATION_STATE_CONFIG_IN_STROBE, SEGMENT_ROLE_STROBE,
+            MENU_INDICATOR_NONE, menu_show_segment_count },
+    { OPERATION_STATE_CONFIG_MAIN_ON_BEACON, MENU_EVENT_CLICK, OPERATION_STATE_CONFIG_IN_BEACON, SEGMENT_ROLE_BEACON,
+            MENU_INDICATOR_NONE, menu_show_segment_count },
+    { OPERATION_STATE_CONFIG_MAIN_ON_LANDING, MENU_EVENT_CLICK, OPERATION_STATE_CONFIG_IN_LANDING, SEGMENT_ROLE_LANDING,
+            MENU_INDICATOR_NONE, menu_show_segment_count },
+    { OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET, MENU_EVENT_CLICK, OPERATION_STATE_CONFIG_IN_FACTORY_RESET, 0,
+            MENU_PURPLE, menu_prompt_factory_reset },
+    { OPERATION_STATE_CONFIG_MAIN_ON_NAV, MENU_EVENT_LONG_CLICK, OPERATION_STATE_NORMAL, 0,
+            MENU_INDICATOR_NONE, menu_exit_config },
+    { OPERATION_STATE_CONFIG_MAIN_ON_STROBE, MENU_EVENT_LONG_CLICK, OPERATION_STATE_NORMAL, 0,
+            MENU_INDICATOR_NONE, menu_exit_config },
+    { OPERATION_STATE_CONFIG_MAIN_ON_BEACON, MENU_EVENT_LONG_CLICK, OPERATION_STATE_NORMAL, 0,
+            MENU_INDICATOR_NONE, menu_exit_config },
+    { OPERATION_STATE_CONFIG_MAIN_ON_LANDING, MENU_EVENT_LONG_CLICK, OPERATION_STATE_NORMAL, 0,
+            MENU_INDICATOR_NONE, menu_exit_config },
+    { OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET, MENU_EVENT_LONG_CLICK, OPERATION_STATE_NORMAL, 0,
+            MENU_INDICATOR_NONE, menu_exit_config },
+
+    // Menu items: the timeout goes on to the next main menu item
+    { OPERATION_STATE_CONFIG_IN_NAV, MENU_EVENT_CLICK, OPERATION_STATE_CONFIG_IN_NAV, SEGMENT_ROLE_NAV,
+            MENU_INDICATOR_NONE, menu_step_segment_count },
+    { OPERATION_STATE_CONFIG_IN_STROBE, MENU_EVENT_CLICK, OPERATION_STATE_CONFIG_IN_STROBE, SEGMENT_ROLE_STROBE,
+            MENU_INDICATOR_NONE, menu_step_segment_count },
+    { OPERATION_STATE_CONFIG_IN_BEACON, MENU_EVENT_CLICK, OPERATION_STATE_CONFIG_IN_BEACON, SEGMENT_ROLE_BEACON,
+            MENU_INDICATOR_NONE, menu_step_segment_count },
+    { OPERATION_STATE_CONFIG_IN_LANDING, MENU_EVENT_CLICK, OPERATION_STATE_CONFIG_IN_LANDING, SEGMENT_ROLE_LANDING,
+            MENU_INDICATOR_NONE, menu_step_segment_count },
+    { OPERATION_STATE_CONFIG_IN_FACTORY_RESET, MENU_EVENT_LONG_CLICK, OPERATION_STATE_CONFIG_IN_FACTORY_RESET, 0,
+            MENU_PURPLE, menu_factory_reset },
+    { OPERATION_STATE_CONFIG_IN_NAV, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_STROBE, 0,
+            MENU_BLUE, menu_leave_segment_count },
+    { OPERATION_STATE_CONFIG_IN_STROBE, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_BEACON, 0,
+            MENU_RED, menu_leave_segment_count },
+    { OPERATION_STATE_CONFIG_IN_BEACON, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_LANDING, 0,
+            MENU_YELLOW, menu_leave_segment_count },
+    { OPERATION_STATE_CONFIG_IN_LANDING, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET, 0,
+            MENU_PURPLE, menu_leave_segment_count },
+    { OPERATION_STATE_CONFIG_IN_FACTORY_RESET, MENU_EVENT_TIMEOUT, OPERATION_STATE_CONFIG_MAIN_ON_NAV, 0,
+            MENU_GREEN, menu_leave_factory_reset }
+};
+
+const uint8_t menu_transition_count = sizeof(menu_transitions) / sizeof(menu_transitions[0]);
 
 // INSTANCES
+EepromRecordStore<CONFIG_STORE_BASE_ADDRESS, CONFIG_STORE_SLOT_COUNT, CONFIG_STORE_SLOT_SIZE> config_store;
+sConfigRecord saved_config;   // what the current config record holds
+
+SerialFrameParser serial_parser;
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+EventLog<LOG_BUFFER_RECORDS> event_log;
+#endif
+
+#ifdef LOOP_PROFILER
+LoopProfiler<LOOP_STAGE_COUNT> loop_profiler;
+#endif
+
+MemoryWatermark memory_watermark;
+
 Timer<12> timer; // 12 concurrent tasks, using millis as resolution
 
 Timer<2, millis, uint32_t> color_timer;
 
+Timer<12>::Task segment_blink_task = 0;  // blink_nav_for_number_of_segments()
+
+// Render and wire buffers of every strip (laid out by resize_strips())
+uint8_t pixel_pool[PIXEL_POOL_BYTES];
+
 NeoPatterns port_nav_strip(
-        nav_and_strobe_led_string_count, 
+        pixel_pool,
+        0,
+        0,
         PORT_NAV_AND_STROBE_LED_STRING_PIN, 
         NEO_GRB + NEO_KHZ800, 
         NULL);
 
 NeoPatterns starboard_nav_strip(
-        nav_and_strobe_led_string_count, 
+        pixel_pool,
+        0,
+        0,
         STARBOARD_NAV_AND_STROBE_LED_STRING_PIN, 
         NEO_GRB + NEO_KHZ800, 
         NULL);
 
 NeoPatterns beacon_strip(
-        beacon_led_segment_count,
+        pixel_pool,
+        0,
+        0,
         BEACON_LED_STRING_PIN, 
         NEO_GRB + NEO_KHZ800,
         NULL);
 
 NeoPatterns landing_strip(
-        landing_led_segment_count,
+        pixel_pool,
+        0,
+        0,
         LANDING_LED_STRING_PIN, 
         NEO_GRB + NEO_KHZ800,
         NULL);
 
+// Every strip, for code that handles them all alike
+NeoPatterns *all_strips[STRIP_COUNT] = {
+    &port_nav_strip,
+    &starboard_nav_strip,
+    &beacon_strip,
+    &landing_strip
+};
+
+// Gamma corrected output at NEO_PIXEL_BRIGHTNESS, shared by every strip
+// (the table is built by the compiler and stays in flash)
+const uint16_t output_lut_table[256] PROGMEM = GAMMA_LUT_TABLE(NEO_PIXEL_BRIGHTNESS);
+GammaLut output_lut(output_lut_table);
+
+FrameCompositor compositor(all_strips, STRIP_COUNT, TARGET_FRAMES_PER_SECOND, render_frame);
+
+LightSequencer light_sequencer(apply_light_sequence_step);
+
+Envelope beacon_envelope(BEACON_ENVELOPE_SHAPE, BEACON_ENVELOPE_PERIOD_IN_MSECS);
+
 OneButton button(BUTTON_PIN); // NOTE:  Default constructor uses pull-up resistor 
                               //        and expects button to be active low
 // SETUP AND MAIN LOOP
 //////////////////////
 void setup()
 {
-    Serial.begin(9600);
-
-#ifdef DEBUG
-    Serial.println("** Starting Nav Lights **");
-#endif // DEBUG
-    initialize_eeprom_if_needed();
-
+    // First, while the stack is at its shallowest
+    memory_watermark.Paint();
+
+    #if RC_INPUT == RC_INPUT_SBUS
+    Serial.begin(RC_SBUS_BAUD_RATE, SERIAL_8E2);
+    #elif RC_INPUT == RC_INPUT_IBUS
+    Serial.begin(RC_IBUS_BAUD_RATE);
+    #else
+    Serial.begin(SERIAL_BAUD_RATE);
+    #endif
+
+    LOG_INFO(LOG_EVENT_STARTING, 0, 0);
     read_eeprom();
 
     // Setup Button for Configuration
@@ -254,452 +836,1338 @@ void setup()
 
     initialize_nav_lights();
 
+    rc_decoder.SetDetentMap(RC_CHANNEL_LANDING_LED, &landing_led_detents);
+    rc_decoder.SetDetentMap(RC_CHANNEL_NAV_DISPLAY_MODE, &nav_display_mode_detents);
+
+    #if RC_INPUT == RC_INPUT_PWM
     pinMode(LANDING_LED_TOGGLE_PIN, INPUT_PULLUP);
     pinMode(NAV_DISPLAY_MODE_PIN, INPUT_PULLUP);
 
     attachInterrupt(digitalPinToInterrupt(LANDING_LED_TOGGLE_PIN), LandingLightsPulseWidthTimer, CHANGE);
     attachInterrupt(digitalPinToInterrupt(NAV_DISPLAY_MODE_PIN), NavDisplayModePulseWidthTimer, CHANGE);
+    #elif RC_INPUT == RC_INPUT_PPM
+    pinMode(RC_PPM_PIN, INPUT_PULLUP);
+
+    attachInterrupt(digitalPinToInterrupt(RC_PPM_PIN), PpmEdgeTimer, RISING);
+    #elif RC_INPUT == RC_INPUT_PCINT
+    for (uint8_t i = 0; i < RC_PCINT_INPUTS; i++)
+    {
+        pinMode(RC_PCINT_FIRST_PIN + i, INPUT_PULLUP);
+    }
+
+    rc_pin_change_levels = PINB & RC_PCINT_MASK;
+    rc_pin_change_decoder.Begin(rc_pin_change_levels);
+
+    PCMSK0 = RC_PCINT_MASK;
+    PCIFR = _BV(PCIF0);         // clear a stale flag
+    PCICR |= _BV(PCIE0);
+    #endif
 
-#ifdef DEBUG
-    Serial.println("******");
-    Serial.println("Current State: OPERATION_STATE_NORMAL");
-#endif // DEBUG
+    // From here on show() only marks a strip; the compositor flushes them
+    compositor.CanFlush = can_flush_strips;
+    compositor.Begin(micros());
+
+    LOG_INFO(LOG_EVENT_STATE_TRANSITION, OPERATION_STATE_NORMAL, 0);
 }
 
 void loop()
 {
+    LOOP_PROFILE_BEGIN();
+
     timer.tick();
+    LOOP_PROFILE(LOOP_STAGE_TIMER);
     color_timer.tick();
+    LOOP_PROFILE(LOOP_STAGE_COLOR_TIMER);
     button.tick();
+    LOOP_PROFILE(LOOP_STAGE_BUTTON);
 
-    manage_running_states();
-    manage_config_states();
+    process_rc_events();
+    LOOP_PROFILE(LOOP_STAGE_RC_EVENTS);
 
-    switch (operation_state)
-    {
-        case OPERATION_STATE_NORMAL:
-        case OPERATION_STATE_RAINBOW:
-        case OPERATION_STATE_CHASE:
+    process_serial_commands();
+    LOOP_PROFILE(LOOP_STAGE_SERIAL);
 
-            manage_nav_display_mode();
+    manage_config_states();
+    LOOP_PROFILE(LOOP_STAGE_CONFIG_STATES);
 
-            break;
+    // Render (render_frame) and flush all strips on the frame clock
+    compositor.Update(micros());
+    LOOP_PROFILE(LOOP_STAGE_FLUSH);
 
-        default:
+    drain_event_log();
+    LOOP_PROFILE(LOOP_STAGE_LOG);
 
-            break;
-    }
+    scan_memory();
+    LOOP_PROFILE(LOOP_STAGE_MEMORY);
 
-    if (operation_state == OPERATION_STATE_NORMAL)
-    {
-        manage_landing_lights();
-    }
+    LOOP_PROFILE_END(LOOP_STAGE_LOOP);
 }
 //////////////////////
 
 // FUNCTION DEFINITIONS
-// Initialization of EEPROM (if needed)
-void initialize_eeprom_if_needed()
+// EEPROM Functions
+// Load the settings with a single record read, migrating older layouts
+void read_eeprom()
 {
-    initialize_eeprom_address_if_needed(e_eeprom_address::EEPROM_ADDRESS_NAV_LED_SEGMENT_COUNT, DEFAULT_NAV_LED_SEGMENT_COUNT);
-
-    initialize_eeprom_address_if_needed(e_eeprom_address::EEPROM_ADDRESS_STROBE_LED_SEGMENT_COUNT,
-            DEFAULT_STROBE_LED_SEGMENT_COUNT);
-
-    initialize_eeprom_address_if_needed(e_eeprom_address::EEPROM_ADDRESS_BEACON_LED_SEGMENT_COUNT,
-            DEFAULT_BEACON_LED_SEGMENT_COUNT);
+    sConfigRecord config;
+    uint8_t version = 0;
 
-    initialize_eeprom_address_if_needed(e_eeprom_address::EEPROM_ADDRESS_LANDING_LED_SEGMENT_COUNT,
-            DEFAULT_LANDING_LED_SEGMENT_COUNT);
+    default_config(&config);
 
-    initialize_eeprom_address_if_needed(e_eeprom_address::EEPROM_ADDRESS_NAV_LED_SEGMENT_START_INDEX, DEFAULT_NAV_LED_SEGMENT_START_INDEX);
-
-    initialize_eeprom_address_if_needed(e_eeprom_address::EEPROM_ADDRESS_STROBE_LED_SEGMENT_START_INDEX,
-            DEFAULT_STROBE_LED_SEGMENT_START_INDEX);
-
-    initialize_eeprom_address_if_needed(e_eeprom_address::EEPROM_ADDRESS_BEACON_LED_SEGMENT_START_INDEX,
-            DEFAULT_BEACON_LED_SEGMENT_START_INDEX);
-
-    initialize_eeprom_address_if_needed(e_eeprom_address::EEPROM_ADDRESS_LANDING_LED_SEGMENT_START_INDEX,
-            DEFAULT_LANDING_LED_SEGMENT_START_INDEX);
-}
-
-bool initialize_eeprom_address_if_needed(eEepromAddress eepromAddress, int eepromValue)
-{
-    bool retVal = false;
+    if (config_store.Load(&config, sizeof(config), &version) == 0)
+    {
+        // No valid record: carry over the legacy per-byte settings if any
+        if (!read_legacy_eeprom(&config) || !is_config_valid(&config))
+        {
+            default_config(&config);
+        }
 
-    if (EEPROM.read(eepromAddress) == EEPROM_ADDRESS_EMPTY)
+        LOG_INFO(LOG_EVENT_CONFIG_RECORD_CREATED, 0, 0);
+        config_store.Save(&config, sizeof(config), CONFIG_RECORD_VERSION);
+    }
+    else if (version < CONFIG_RECORD_VERSION)
     {
-        #ifdef DEBUG
-        Serial.print("Initializing EEPROM ADDRESS: ");
-        Serial.println(eepromAddress);
-        #endif // DEBUG
-        EEPROM.write(eepromAddress, eepromValue);
-        retVal = true;
+        // Fields added since version still hold their defaults; per version
+        // fix-ups of existing fields go here
+        LOG_INFO(LOG_EVENT_CONFIG_RECORD_MIGRATED, version, 0);
+        config_store.Save(&config, sizeof(config), CONFIG_RECORD_VERSION);
     }
 
-    return retVal;
-}
+    if (!is_config_valid(&config))
+    {
+        default_config(&config);
+    }
 
-void read_eeprom()
-{
-    nav_led_segment_count = EEPROM.read(e_eeprom_address::EEPROM_ADDRESS_NAV_LED_SEGMENT_COUNT);
-    strobe_led_segment_count = EEPROM.read(e_eeprom_address::EEPROM_ADDRESS_STROBE_LED_SEGMENT_COUNT);
-    beacon_led_segment_count = EEPROM.read(e_eeprom_address::EEPROM_ADDRESS_BEACON_LED_SEGMENT_COUNT);
-    landing_led_segment_count = EEPROM.read(e_eeprom_address::EEPROM_ADDRESS_LANDING_LED_SEGMENT_COUNT);
- 
-    nav_led_segment_start_index = EEPROM.read(e_eeprom_address::EEPROM_ADDRESS_NAV_LED_SEGMENT_START_INDEX);
-    strobe_led_segment_start_index = EEPROM.read(e_eeprom_address::EEPROM_ADDRESS_STROBE_LED_SEGMENT_START_INDEX);
-    beacon_led_segment_start_index = EEPROM.read(e_eeprom_address::EEPROM_ADDRESS_BEACON_LED_SEGMENT_START_INDEX);
-    landing_led_segment_start_index = EEPROM.read(e_eeprom_address::EEPROM_ADDRESS_LANDING_LED_SEGMENT_START_INDEX);
+    saved_config = config;
+    apply_config(&config);
 }
 
+// Save the settings as a new record (all or nothing), if they changed
 void update_eeprom()
 {
-    #ifdef DEBUG
-    Serial.println("Updating EEPROM");
-    #endif // DEBUG
-    EEPROM.update(e_eeprom_address::EEPROM_ADDRESS_NAV_LED_SEGMENT_COUNT, nav_led_segment_count);
-    EEPROM.update(e_eeprom_address::EEPROM_ADDRESS_STROBE_LED_SEGMENT_COUNT, strobe_led_segment_count);
-    EEPROM.update((e_eeprom_address::EEPROM_ADDRESS_BEACON_LED_SEGMENT_COUNT), beacon_led_segment_count);
-    EEPROM.update(e_eeprom_address::EEPROM_ADDRESS_LANDING_LED_SEGMENT_COUNT, landing_led_segment_count);
-            
-    EEPROM.update(e_eeprom_address::EEPROM_ADDRESS_NAV_LED_SEGMENT_START_INDEX, nav_led_segment_start_index);
-    EEPROM.update(e_eeprom_address::EEPROM_ADDRESS_STROBE_LED_SEGMENT_START_INDEX, strobe_led_segment_start_index);
-    EEPROM.update(e_eeprom_address::EEPROM_ADDRESS_BEACON_LED_SEGMENT_START_INDEX, beacon_led_segment_start_index);
-    EEPROM.update(e_eeprom_address::EEPROM_ADDRESS_LANDING_LED_SEGMENT_START_INDEX, landing_led_segment_start_index);
-}
-
-// Initialization of Nav Lights
-void initialize_nav_lights()
-{
-    // Inititalize State
-    operation_state = OPERATION_STATE_INIT;
-
-    // Initialize LED Strips
-    port_nav_strip.begin();
-    port_nav_strip.updateLength(nav_led_segment_count + strobe_led_segment_count);
-    port_nav_strip.setBrightness(NEO_PIXEL_BRIGHTNESS);
-    port_nav_strip.show();
-
-    starboard_nav_strip.begin();
-    starboard_nav_strip.updateLength(nav_led_segment_count + strobe_led_segment_count);
-    starboard_nav_strip.setBrightness(NEO_PIXEL_BRIGHTNESS);
-    starboard_nav_strip.show();
-
-    beacon_strip.begin();
-    beacon_strip.updateLength(beacon_led_segment_count);
-    beacon_strip.setBrightness(NEO_PIXEL_BRIGHTNESS);
-    beacon_strip.show();
+    sConfigRecord config;
 
-    landing_strip.begin();
-    landing_strip.updateLength(landing_led_segment_count);
-    landing_strip.setBrightness(NEO_PIXEL_BRIGHTNESS);
-    landing_strip.show();
-
-    // Set Pixel Colors //
-    // Port Nav
-    port_nav_strip.clear();
-    port_nav_strip.show();
-    port_nav_strip.fill(red, nav_led_segment_start_index, nav_led_segment_count);
-    port_nav_strip.show();
-
-    // Starboard Nav
-    starboard_nav_strip.clear();
-    starboard_nav_strip.show();
-    starboard_nav_strip.fill(green, nav_led_segment_start_index, nav_led_segment_count);
-    starboard_nav_strip.show();
-
-    // Setup Timer for Nav Strobes
-    timer.in(0, start_nav_strobe_on_1);
-    timer.in(50, start_nav_strobe_off_1);
-    timer.in(100, start_nav_strobe_on_2);
-    timer.in(150, start_nav_strobe_off_2);
-
-    // Setup Timer for Beacon
-    timer.in(500, start_on_beacon);
-    timer.in(600, start_off_beacon);
+    capture_config(&config);
 
-    // Landing
-    landing_strip.clear();
-    landing_strip.fill(white, landing_led_segment_start_index, landing_led_segment_count);
-    landing_strip.show();
-
-    landing_lights_on = true;
+    if (config_store.Loaded && memcmp(&config, &saved_config, sizeof(config)) == 0)
+    {
+        return;
+    }
 
-    operation_state = OPERATION_STATE_NORMAL;
+    LOG_INFO(LOG_EVENT_CONFIG_RECORD_SAVED, 0, 0);
+    config_store.Save(&config, sizeof(config), CONFIG_RECORD_VERSION);
+    saved_config = config;
 }
 
-// Turn off Nav Lights
-void turn_off_nav_lights()
+void default_config(sConfigRecord *config)
 {
-    timer.cancel();
-    port_nav_strip.clear();
-    port_nav_strip.show();
-    starboard_nav_strip.clear();
-    starboard_nav_strip.show();
-    beacon_strip.clear();
-    beacon_strip.show();
-    landing_lights_on = false;
-    landing_strip.clear();
-    landing_strip.show();
-}
+    memset(config, 0, sizeof(*config));
 
-// Nav Strobe functions
-bool start_nav_strobe_on_1(void *) {
-    timer.every(1000, turn_on_nav_strobe);
-    return false;
-}
+    config->nav_led_segment_count = DEFAULT_NAV_LED_SEGMENT_COUNT;
+    config->strobe_led_segment_count = DEFAULT_STROBE_LED_SEGMENT_COUNT;
+    config->beacon_led_segment_count = DEFAULT_BEACON_LED_SEGMENT_COUNT;
+    config->landing_led_segment_count = DEFAULT_LANDING_LED_SEGMENT_COUNT;
 
-bool start_nav_strobe_off_1(void *) {
-    timer.every(1000, turn_off_nav_strobe);
-    return false;
-}
+    config->nav_led_segment_start_index = DEFAULT_NAV_LED_SEGMENT_START_INDEX;
+    config->strobe_led_segment_start_index = DEFAULT_STROBE_LED_SEGMENT_START_INDEX;
+    config->beacon_led_segment_start_index = DEFAULT_BEACON_LED_SEGMENT_START_INDEX;
+    config->landing_led_segment_start_index = DEFAULT_LANDING_LED_SEGMENT_START_INDEX;
 
-bool start_nav_strobe_on_2(void *) {
-    timer.every(1000, turn_on_nav_strobe);
-    return false;
-}
+    config->failsafe_pattern = FAILSAFE_PATTERN_STROBE;
 
-bool start_nav_strobe_off_2(void *) {
-    timer.every(1000, turn_off_nav_strobe);
-    return false;
+    config->rc_bus_channels[RC_CHANNEL_LANDING_LED] = DEFAULT_LANDING_LED_BUS_CHANNEL;
+    config->rc_bus_channels[RC_CHANNEL_NAV_DISPLAY_MODE] = DEFAULT_NAV_DISPLAY_MODE_BUS_CHANNEL;
 }
 
-bool turn_on_nav_strobe(void *) {
-    port_nav_strip.fill(white, strobe_led_segment_start_index,
-            strobe_led_segment_count);
-    port_nav_strip.show();
-
-    starboard_nav_strip.fill(white, strobe_led_segment_start_index,
-            strobe_led_segment_count);
-    starboard_nav_strip.show();
-
-    return true;
-}
+// Returns false if the legacy layout was never written
+bool read_legacy_eeprom(sConfigRecord *config)
+{
+    if (EEPROM.read(EEPROM_ADDRESS_NAV_LED_SEGMENT_COUNT) == EEPROM_ADDRESS_EMPTY)
+    {
+        return false;
+    }
 
-bool turn_off_nav_strobe(void *) {
-    port_nav_strip.fill(black, 
-                        strobe_led_segment_start_index,
-                        strobe_led_segment_count);
-    port_nav_strip.show();
+    config->nav_led_segment_count = EEPROM.read(EEPROM_ADDRESS_NAV_LED_SEGMENT_COUNT);
+    config->strobe_led_segment_count = EEPROM.read(EEPROM_ADDRESS_STROBE_LED_SEGMENT_COUNT);
+    config->beacon_led_segment_count = EEPROM.read(EEPROM_ADDRESS_BEACON_LED_SEGMENT_COUNT);
+    config->landing_led_segment_count = EEPROM.read(EEPROM_ADDRESS_LANDING_LED_SEGMENT_COUNT);
 
-    starboard_nav_strip.fill(black, 
-                        strobe_led_segment_start_index,
-                        strobe_led_segment_count);
-    starboard_nav_strip.show();
+    config->nav_led_segment_start_index = EEPROM.read(EEPROM_ADDRESS_NAV_LED_SEGMENT_START_INDEX);
+    config->strobe_led_segment_start_index = EEPROM.read(EEPROM_ADDRESS_STROBE_LED_SEGMENT_START_INDEX);
+    config->beacon_led_segment_start_index = EEPROM.read(EEPROM_ADDRESS_BEACON_LED_SEGMENT_START_INDEX);
+    config->landing_led_segment_start_index = EEPROM.read(EEPROM_ADDRESS_LANDING_LED_SEGMENT_START_INDEX);
 
-   return true;
+    return true;
 }
 
-// Beacon functions
-bool start_on_beacon(void *) {
-    timer.every(1000, turn_on_beacon);
-    return false;
-}
+// Every segment of a role must have at least one LED, the extra segments
+// must name a role and at least one strip, the strips must fit in the
+// pixel pool, the failsafe pattern must exist and the bus channels must
+// be in a frame
+bool is_config_valid(const sConfigRecord *config)
+{
+    for (uint8_t i = 0; i < RC_CHANNEL_COUNT; i++)
+    {
+        if (config->rc_bus_channels[i] >= RC_BUS_MAX_CHANNELS
+                && config->rc_bus_channels[i] != RC_BUS_CHANNEL_NONE)
+        {
+            return false;
+        }
+    }
 
-bool start_off_beacon(void *) {
-    timer.every(1000, turn_off_beacon);
-    return false;
-}
+    for (uint8_t i = 0; i < CONFIG_EXTRA_SEGMENT_COUNT; i++)
+    {
+        const sSegment *segment = &config->extra_segments[i];
 
-bool turn_on_beacon(void *) {
-    beacon_strip.fill(red, beacon_led_segment_start_index, beacon_led_segment_count);
-    beacon_strip.show();
-    return true; // to repeat the action - false to stop
-}
+        if (segment->count != 0
+                && (segment->role >= SEGMENT_ROLE_COUNT
+                    || segment->strips == 0
+                    || (segment->strips & ~STRIP_MASK_ALL) != 0))
+        {
+            return false;
+        }
+    }
 
-bool turn_off_beacon(void *) {
-    beacon_strip.fill(black, beacon_led_segment_start_index, beacon_led_segment_count);
-    beacon_strip.show();
-    return true; // to repeat the action - false to stop
+    return config->nav_led_segment_count >= 1
+        && config->nav_led_segment_count <= MAX_NAV_LED_SEGMENT_COUNT
+        && config->strobe_led_segment_count >= 1
+        && config->strobe_led_segment_count <= MAX_STROBE_LED_SEGMENT_COUNT
+        && config->beacon_led_segment_count >= 1
+        && config->beacon_led_segment_count <= MAX_BEACON_LED_SEGMENT_COUNT
+        && config->landing_led_segment_count >= 1
+        && config->landing_led_segment_count <= MAX_LANDING_LED_SEGMENT_COUNT
+        && config_pixel_bytes(config) <= PIXEL_POOL_BYTES
+        && config->failsafe_pattern < FAILSAFE_PATTERN_COUNT;
 }
 
-// Landing Lights Functions
-void LandingLightsPulseWidthTimer() {
-    noInterrupts();
-    landing_led_pulse_current_time_in_micro_seconds = micros();
-    interrupts();
+// Each strip is as long as the furthest segment end on it
+void segment_strip_lengths(const sSegment *table, uint16_t *lengths)
+{
+    memset(lengths, 0, STRIP_COUNT * sizeof(uint16_t));
 
-    if (landing_led_pulse_current_time_in_micro_seconds 
-            > landing_led_pulse_start_time_in_micro_seconds)
+    for (uint8_t i = 0; i < SEGMENT_TABLE_SIZE; i++)
     {
-        landing_led_pulses = landing_led_pulse_current_time_in_micro_seconds
-                - landing_led_pulse_start_time_in_micro_seconds;
+        uint16_t end = table[i].start + table[i].count;
 
-        landing_led_pulse_start_time_in_micro_seconds
-            = landing_led_pulse_current_time_in_micro_seconds;
-
-        if (landing_led_pulses < MAX_PULSE_WIDTH)
+        for (uint8_t strip = 0; strip < STRIP_COUNT; strip++)
         {
-            landing_led_pulse_width_in_micro_seconds = landing_led_pulses;
-
-            if (operation_state == OPERATION_STATE_NORMAL)
+            if (table[i].count != 0 && (table[i].strips & (1 << strip)) && end > lengths[strip])
             {
-                if (!landing_lights_on && landing_led_pulse_width_in_micro_seconds > HIGH_PWM_POSITION) {
-                    landing_lights_on = true;
-                    #ifdef DEBUG
-                    Serial.println("Landing Lights: ON");
-                    Serial.println(landing_led_pulse_width_in_micro_seconds);
-                    #endif // DEBUG
-                } else if (landing_lights_on && landing_led_pulse_width_in_micro_seconds <= HIGH_PWM_POSITION) {
-                    landing_lights_on = false;
-                    #ifdef DEBUG
-                    Serial.println("Landing Lights: OFF");
-                    Serial.println(landing_led_pulse_width_in_micro_seconds);
-                    #endif // DEBUG
-                }
+                lengths[strip] = end;
             }
         }
     }
 }
 
-void manage_landing_lights()
+// Pixel pool bytes the strips of a segment table take
+uint16_t segment_pixel_bytes(const sSegment *table)
 {
+    uint16_t lengths[STRIP_COUNT];
+    uint16_t leds = 0;
 
-    if (landing_lights_on) {
-        landing_strip.fill(white, landing_led_segment_start_index, landing_led_segment_count);
-        landing_strip.show();
-    } else {
-        landing_strip.fill(black, landing_led_segment_start_index, landing_led_segment_count);
-        landing_strip.show();
+    segment_strip_lengths(table, lengths);
+
+    for (uint8_t strip = 0; strip < STRIP_COUNT; strip++)
+    {
+        leds += lengths[strip];
     }
 
-    #ifdef DEBUG
-    //Serial.println(landing_led_pulse_width_in_micro_seconds);
-    #endif // DEBUG
+    return leds * PIXEL_BYTES_PER_LED;
 }
 
-void NavDisplayModePulseWidthTimer()
+// Pixel pool bytes a config needs
+uint16_t config_pixel_bytes(const sConfigRecord *config)
 {
-    noInterrupts();
-    nav_display_mode_pulse_current_time_in_micro_seconds = micros();
-    interrupts();
+    sSegment table[SEGMENT_TABLE_SIZE];
 
-    if (nav_display_mode_pulse_current_time_in_micro_seconds 
-            > nav_display_mode_pulse_start_time_in_micro_seconds)
-    {
-        nav_display_mode_pulses = nav_display_mode_pulse_current_time_in_micro_seconds
-                - nav_display_mode_pulse_start_time_in_micro_seconds;
-
-        nav_display_mode_pulse_start_time_in_micro_seconds
-            = nav_display_mode_pulse_current_time_in_micro_seconds;
-
-        if (nav_display_mode_pulses < MAX_PULSE_WIDTH)
-        {
-            nav_display_mode_pulse_width_in_micro_seconds = nav_display_mode_pulses;
-
-            if (operation_state != OPERATION_STATE_CHASE
-                && nav_display_mode_pulse_width_in_micro_seconds > 2000 - 100
-                /*&& nav_display_mode_pulse_width_in_micro_seconds < 2100*/) {
-                operation_state = OPERATION_STATE_CHASE;
-                #ifdef DEBUG
-                Serial.println("Display Mode: THEATER CHASE");
-                Serial.println(nav_display_mode_pulse_width_in_micro_seconds);
-                #endif // DEBUG
-
-                turn_off_nav_lights();
-
-                set_nav_lights_to_theater_chase();
-
-            } else if (operation_state != OPERATION_STATE_RAINBOW
-                && nav_display_mode_pulse_width_in_micro_seconds > 1500 - 100
-                && nav_display_mode_pulse_width_in_micro_seconds < 1500 + 100) {
-                operation_state = OPERATION_STATE_RAINBOW;
-                #ifdef DEBUG
-                Serial.println("Display Mode: RAINBOW");
-                Serial.println(nav_display_mode_pulse_width_in_micro_seconds);
-                #endif // DEBUG
-
-                turn_off_nav_lights();
-
-                set_nav_lights_to_rainbow();
+    config_segment_table(config, table);
 
-            } else if (operation_state != OPERATION_STATE_NORMAL
-                //&& nav_display_mode_pulse_width_in_micro_seconds > 1000 - 100
-                && nav_display_mode_pulse_width_in_micro_seconds < 1000 + 100) {
-                operation_state = OPERATION_STATE_NORMAL;
-                #ifdef DEBUG
-                Serial.println("Display Mode: NAV");
-                Serial.println(nav_display_mode_pulse_width_in_micro_seconds);
-                #endif // DEBUG
-
-                turn_off_nav_lights();
-
-                initialize_nav_lights();
-            }
-        }
-    }
+    return segment_pixel_bytes(table);
 }
 
-void manage_nav_display_mode()
+// Does the segment table (as edited by the config menu) fit the pixel pool?
+bool segments_fit_pixel_pool()
 {
-    #ifdef DEBUG
-    //Serial.println(nav_display_mode_pulse_width_in_micro_seconds);
-    #endif // DEBUG
+    return segment_pixel_bytes(segment_table) <= PIXEL_POOL_BYTES;
 }
 
-void set_nav_lights_to_rainbow()
+// Segment table of a config: nav and strobe on both nav strips, beacon and
+// landing on their own strip, then the extra segments
+void config_segment_table(const sConfigRecord *config, sSegment *table)
 {
-    port_nav_strip.RainbowCycle(3);
-    starboard_nav_strip.RainbowCycle(3);
-    beacon_strip.RainbowCycle(3);
-    landing_strip.RainbowCycle(3);
+    table[SEGMENT_ROLE_NAV].strips = STRIP_MASK_PORT_NAV | STRIP_MASK_STARBOARD_NAV;
+    table[SEGMENT_ROLE_NAV].start = config->nav_led_segment_start_index;
+    table[SEGMENT_ROLE_NAV].count = config->nav_led_segment_count;
+    table[SEGMENT_ROLE_NAV].role = SEGMENT_ROLE_NAV;
+
+    table[SEGMENT_ROLE_STROBE].strips = STRIP_MASK_PORT_NAV | STRIP_MASK_STARBOARD_NAV;
+    table[SEGMENT_ROLE_STROBE].start = config->strobe_led_segment_start_index;
+    table[SEGMENT_ROLE_STROBE].count = config->strobe_led_segment_count;
+    table[SEGMENT_ROLE_STROBE].role = SEGMENT_ROLE_STROBE;
+
+    table[SEGMENT_ROLE_BEACON].strips = STRIP_MASK_BEACON;
+    table[SEGMENT_ROLE_BEACON].start = config->beacon_led_segment_start_index;
+    table[SEGMENT_ROLE_BEACON].count = config->beacon_led_segment_count;
+    table[SEGMENT_ROLE_BEACON].role = SEGMENT_ROLE_BEACON;
+
+    table[SEGMENT_ROLE_LANDING].strips = STRIP_MASK_LANDING;
+    table[SEGMENT_ROLE_LANDING].start = config->landing_led_segment_start_index;
+    table[SEGMENT_ROLE_LANDING].count = config->landing_led_segment_count;
+    table[SEGMENT_ROLE_LANDING].role = SEGMENT_ROLE_LANDING;
+
+    memcpy(&table[SEGMENT_ROLE_COUNT], config->extra_segments, sizeof(config->extra_segments));
 }
 
-void set_nav_lights_to_theater_chase()
+void apply_config(const sConfigRecord *config)
 {
-    uint8_t random_color = random(255);
-    uint8_t anti_random_color = random_color + 128;
+    config_segment_table(config, segment_table);
+    failsafe_pattern = config->failsafe_pattern;
 
-    port_nav_strip.ActivePattern = THEATER_CHASE;
-    port_nav_strip.Interval = 100;
-    port_nav_strip.Color1 = port_nav_strip.Wheel(random_color);
-    port_nav_strip.Color2 = port_nav_strip.Wheel(anti_random_color);
+    // Functions moved to another bus channel start over
+    if (memcmp(rc_bus_channels, config->rc_bus_channels, sizeof(rc_bus_channels)) != 0)
+    {
+        memcpy(rc_bus_channels, config->rc_bus_channels, sizeof(rc_bus_channels));
+        for (uint8_t channel = 0; channel < RC_CHANNEL_COUNT; channel++)
+        {
+            rc_decoder.Reset(channel);
+        }
+        rc_signal_monitor.Reset();
+    }
+}
+
+void capture_config(sConfigRecord *config)
+{
+    config->nav_led_segment_count = segment_table[SEGMENT_ROLE_NAV].count;
+    config->strobe_led_segment_count = segment_table[SEGMENT_ROLE_STROBE].count;
+    config->beacon_led_segment_count = segment_table[SEGMENT_ROLE_BEACON].count;
+    config->landing_led_segment_count = segment_table[SEGMENT_ROLE_LANDING].count;
 
-    starboard_nav_strip.ActivePattern = THEATER_CHASE;
-    starboard_nav_strip.Interval = 100;
-    starboard_nav_strip.Color1 = starboard_nav_strip.Wheel(random_color);
-    starboard_nav_strip.Color2 = starboard_nav_strip.Wheel(anti_random_color);
+    config->nav_led_segment_start_index = segment_table[SEGMENT_ROLE_NAV].start;
+    config->strobe_led_segment_start_index = segment_table[SEGMENT_ROLE_STROBE].start;
+    config->beacon_led_segment_start_index = segment_table[SEGMENT_ROLE_BEACON].start;
+    config->landing_led_segment_start_index = segment_table[SEGMENT_ROLE_LANDING].start;
 
-    beacon_strip.ActivePattern = THEATER_CHASE;
-    beacon_strip.Interval = 100;
-    beacon_strip.Color1 = beacon_strip.Wheel(random_color);
-    beacon_strip.Color2 = beacon_strip.Wheel(anti_random_color);
+    memcpy(config->extra_segments, &segment_table[SEGMENT_ROLE_COUNT], sizeof(config->extra_segments));
 
-    landing_strip.ActivePattern = THEATER_CHASE;
-    landing_strip.Interval = 100;
-    landing_strip.Color1 = landing_strip.Wheel(random_color);
-    landing_strip.Color2 = landing_strip.Wheel(anti_random_color);
+    config->failsafe_pattern = failsafe_pattern;
+    memcpy(config->rc_bus_channels, rc_bus_channels, sizeof(config->rc_bus_channels));
 }
 
-void update_color_mode_for_nav_lights()
+// Serial Protocol Functions
+// Parse at most SERIAL_PARSE_BUDGET_BYTES received bytes (the rest wait in
+// the RX ring for the next pass) and send the status stream when due.  With
+// a serial bus receiver the bytes are its frames instead, and nothing is
+// sent.
+void process_serial_commands()
 {
-    port_nav_strip.Update();
-    starboard_nav_strip.Update();
-    beacon_strip.Update();
-    landing_strip.Update();
+    for (uint8_t i = 0; i < SERIAL_PARSE_BUDGET_BYTES && Serial.available() > 0; i++)
+    {
+        #if RC_IS_SERIAL_BUS
+        if (rc_bus_decoder.Feed(Serial.read()))
+        {
+            handle_rc_bus_frame(&rc_bus_decoder.Frame, micros(),
+                    (RC_INPUT == RC_INPUT_SBUS) ? RC_SBUS_FRAME_IN_MICRO_SECONDS : RC_IBUS_FRAME_IN_MICRO_SECONDS);
+        }
+        #else
+        if (serial_parser.Feed(Serial.read()))
+        {
+            handle_serial_frame(&serial_parser.Frame);
+        }
+        #endif // RC_IS_SERIAL_BUS
+    }
+
+    #if !RC_IS_SERIAL_BUS
+    if (status_stream_interval_in_milliseconds > 0
+            && millis() - status_stream_last_in_milliseconds >= status_stream_interval_in_milliseconds)
+    {
+        status_stream_last_in_milliseconds = millis();
+        send_status_report();
+    }
+    #endif // RC_IS_SERIAL_BUS
 }
 
-void manage_running_states()
+void handle_serial_frame(const sSerialFrame *frame)
 {
-    switch (operation_state)
+    switch (frame->type)
     {
-        case OPERATION_STATE_NORMAL:
-            
-            break;
-        
-        case OPERATION_STATE_RAINBOW:
+        case SERIAL_MESSAGE_GET_CONFIG:
+        {
+            sConfigRecord config;
 
-            update_color_mode_for_nav_lights();
+            capture_config(&config);
+            send_serial_frame(SERIAL_MESSAGE_CONFIG, &config, sizeof(config));
 
             break;
+        }
 
-        case OPERATION_STATE_CHASE:
+        case SERIAL_MESSAGE_SET_CONFIG:
+        {
+            sConfigRecord config;
 
-            update_color_mode_for_nav_lights();
+            if (frame->length != sizeof(config))
+            {
+                send_serial_nak(frame->type, SERIAL_NAK_BAD_LENGTH);
+                break;
+            }
 
-            break;
+            if (!is_running_state())
+            {
+                send_serial_nak(frame->type, SERIAL_NAK_BUSY);
+                break;
+            }
+
+            memcpy(&config, frame->payload, sizeof(config));
+
+            if (!is_config_valid(&config))
+            {
+                send_serial_nak(frame->type, SERIAL_NAK_BAD_VALUE);
+                break;
+            }
+
+            // Same as leaving the config menu: save, then restart in NAV
+            apply_config(&config);
+            update_eeprom();
+            turn_off_nav_lights();
+            initialize_nav_lights();
+
+            send_serial_frame(SERIAL_MESSAGE_ACK, &frame->type, 1);
+
+            break;
+        }
+
+        case SERIAL_MESSAGE_SET_MODE:
+
+            if (frame->length != 1)
+            {
+                send_serial_nak(frame->type, SERIAL_NAK_BAD_LENGTH);
+            }
+            else if (frame->payload[0] > NAV_DISPLAY_MODE_POSITION_CHASE)
+            {
+                send_serial_nak(frame->type, SERIAL_NAK_BAD_VALUE);
+            }
+            else if (!is_running_state())
+            {
+                send_serial_nak(frame->type, SERIAL_NAK_BUSY);
+            }
+            else if (rc_frame_scheduler.IsLocked(RC_CHANNEL_NAV_DISPLAY_MODE, micros()))
+            {
+                // The switch would put its own mode back on the next pulse
+                send_serial_nak(frame->type, SERIAL_NAK_RC_OVERRIDE);
+            }
+            else
+            {
+                set_nav_display_mode((eNavDisplayModePosition)frame->payload[0]);
+                send_serial_frame(SERIAL_MESSAGE_ACK, &frame->type, 1);
+            }
+
+            break;
+
+        case SERIAL_MESSAGE_STREAM_STATUS:
+
+            if (frame->length != sizeof(status_stream_interval_in_milliseconds))
+            {
+                send_serial_nak(frame->type, SERIAL_NAK_BAD_LENGTH);
+                break;
+            }
+
+            memcpy(&status_stream_interval_in_milliseconds, frame->payload,
+                    sizeof(status_stream_interval_in_milliseconds));
+            status_stream_last_in_milliseconds = millis();
+            send_serial_frame(SERIAL_MESSAGE_ACK, &frame->type, 1);
+
+            break;
+
+        case SERIAL_MESSAGE_GET_STATUS:
+
+            send_status_report();
+
+            break;
+
+        case SERIAL_MESSAGE_GET_MEMORY:
+
+            send_serial_frame(SERIAL_MESSAGE_MEMORY, &memory_watermark.Status, sizeof(sMemoryStatus));
+
+            break;
+
+        #ifdef LOOP_PROFILER
+        case SERIAL_MESSAGE_GET_PROFILE:
+
+            if (frame->length != 1)
+            {
+                send_serial_nak(frame->type, SERIAL_NAK_BAD_LENGTH);
+            }
+            else if (frame->payload[0] >= LOOP_STAGE_COUNT)
+            {
+                send_serial_nak(frame->type, SERIAL_NAK_BAD_VALUE);
+            }
+            else
+            {
+                send_loop_profile(frame->payload[0]);
+            }
+
+            break;
+
+        case SERIAL_MESSAGE_RESET_PROFILE:
+
+            loop_profiler.Reset();
+            send_serial_frame(SERIAL_MESSAGE_ACK, &frame->type, 1);
+
+            break;
+        #endif // LOOP_PROFILER
+
+        default:
+
+            send_serial_nak(frame->type, SERIAL_NAK_UNKNOWN_MESSAGE);
+
+            break;
+    }
+}
+
+// Queue a frame for the TX interrupt, or drop it if it would not fit in the
+// TX buffer: write() blocks loop() until there is room, which at 115200 baud
+// is up to 3ms for a full frame.  With a serial bus receiver the port runs
+// at the bus's baud rate and format, and no frame is ever sent.
+bool send_serial_frame(uint8_t type, const void *payload, uint8_t length)
+{
+    #if RC_IS_SERIAL_BUS
+    (void)type;
+    (void)payload;
+    (void)length;
+
+    return false;
+    #else
+    uint8_t buffer[SERIAL_FRAME_MAX_SIZE];
+    uint8_t size = serial_frame_encode(buffer, type, payload, length);
+
+    if (size == 0 || Serial.availableForWrite() < size)
+    {
+        serial_frames_dropped++;
+        return false;
+    }
+
+    Serial.write(buffer, size);
+
+    return true;
+    #endif // RC_IS_SERIAL_BUS
+}
+
+void send_serial_nak(uint8_t type, eSerialNakReason reason)
+{
+    uint8_t payload[2] = { type, (uint8_t)reason };
+
+    send_serial_frame(SERIAL_MESSAGE_NAK, payload, sizeof(payload));
+}
+
+void send_status_report()
+{
+    sStatusReport status;
+
+    status.time_in_milliseconds = millis();
+    status.landing_led_pulse_width_in_micro_seconds = landing_led_pulse_width_in_micro_seconds;
+    status.nav_display_mode_pulse_width_in_micro_seconds = nav_display_mode_pulse_width_in_micro_seconds;
+    status.frames_dropped = compositor.Timing.frames_dropped;
+    status.operation_state = operation_state;
+    status.flags = 0;
+
+    if (landing_lights_on)
+    {
+        status.flags |= STATUS_FLAG_LANDING_LIGHTS_ON;
+    }
+    if (rc_frame_scheduler.IsLocked(RC_CHANNEL_LANDING_LED, micros()))
+    {
+        status.flags |= STATUS_FLAG_LANDING_LED_RC_LOCKED;
+    }
+    if (rc_frame_scheduler.IsLocked(RC_CHANNEL_NAV_DISPLAY_MODE, micros()))
+    {
+        status.flags |= STATUS_FLAG_NAV_DISPLAY_MODE_RC_LOCKED;
+    }
+    if (rc_signal_monitor.LostMask != 0)
+    {
+        status.flags |= STATUS_FLAG_RC_SIGNAL_LOST;
+    }
+
+    send_serial_frame(SERIAL_MESSAGE_STATUS, &status, sizeof(status));
+}
+
+// Send queued log records, one frame per call and only while loop() is
+// idle: no frame waiting for its flush, the next frame tick not close and
+// room in the TX buffer for a whole frame, so it never waits on the port.
+// With a serial bus receiver the records stay in the ring.
+void drain_event_log()
+{
+    #if LOG_LEVEL > LOG_LEVEL_NONE && !RC_IS_SERIAL_BUS
+    sLogRecord records[LOG_RECORDS_PER_FRAME];
+
+    if (event_log.IsEmpty()
+            || compositor.FlushPending
+            || (long)(compositor.NextFrame - micros()) < LOG_DRAIN_MIN_IDLE_IN_MICRO_SECONDS
+            || Serial.availableForWrite() < SERIAL_FRAME_MAX_SIZE)
+    {
+        return;
+    }
+
+    uint8_t count = event_log.Take(records, LOG_RECORDS_PER_FRAME);
+
+    send_serial_frame(SERIAL_MESSAGE_LOG, records, count * sizeof(sLogRecord));
+    #endif // LOG_LEVEL
+}
+
+// PROFILE reply: the stage followed by its sLoopStageStats
+void send_loop_profile(uint8_t stage)
+{
+    #ifdef LOOP_PROFILER
+    uint8_t payload[1 + sizeof(sLoopStageStats)];
+
+    payload[0] = stage;
+    memcpy(&payload[1], &loop_profiler.Stage[stage], sizeof(sLoopStageStats));
+    send_serial_frame(SERIAL_MESSAGE_PROFILE, payload, sizeof(payload));
+    #endif // LOOP_PROFILER
+}
+
+// Memory high-water marks: scan every MEMORY_SCAN_INTERVAL_IN_MSECS, log
+// them, and warn while the stack comes close to the heap
+void scan_memory()
+{
+    if (millis() - memory_scan_last_in_milliseconds < MEMORY_SCAN_INTERVAL_IN_MSECS)
+    {
+        return;
+    }
+    memory_scan_last_in_milliseconds = millis();
+
+    memory_watermark.Scan();
+
+    const sMemoryStatus *status = &memory_watermark.Status;
+
+    LOG_DEBUG(LOG_EVENT_STACK, status->stack_peak_bytes, status->free_min_bytes);
+    LOG_DEBUG(LOG_EVENT_HEAP, status->heap_bytes, status->heap_peak_bytes);
+
+    // stack_peak_bytes is 0 where the stack is not measured (the host)
+    if (status->stack_peak_bytes != 0 && status->free_min_bytes < MEMORY_FREE_WARN_BYTES)
+    {
+        LOG_WARN(LOG_EVENT_MEMORY_LOW, status->free_min_bytes, 0);
+    }
+}
+
+// Display modes (as opposed to the config menu)
+bool is_running_state()
+{
+    return operation_state == OPERATION_STATE_NORMAL
+        || operation_state == OPERATION_STATE_RAINBOW
+        || operation_state == OPERATION_STATE_CHASE;
+}
+
+// Initialization of Nav Lights
+void initialize_nav_lights()
+{
+    // Inititalize State
+    operation_state = OPERATION_STATE_INIT;
+
+    // Initialize LED Strips
+    resize_strips();
+
+    port_nav_strip.begin();
+    port_nav_strip.SetOutputLut(&output_lut);
+    port_nav_strip.show();
+
+    starboard_nav_strip.begin();
+    starboard_nav_strip.SetOutputLut(&output_lut);
+    starboard_nav_strip.show();
+
+    beacon_strip.begin();
+    beacon_strip.SetOutputLut(&output_lut);
+    beacon_strip.show();
+
+    landing_strip.begin();
+    landing_strip.SetOutputLut(&output_lut);
+    landing_strip.show();
+
+    // Setup Timer for Nav Strobes (a single sequencer task)
+    strobe_color = black;
+    light_sequencer.Start(&nav_light_sequence, millis());
+    timer.in(0, run_light_sequencer);
+
+    // Beacon (follows the envelope from here on)
+    beacon_envelope.Start(millis() + BEACON_ENVELOPE_DELAY_IN_MSECS);
+
+    landing_lights_on = true;
+
+    // Set Pixel Colors (then every frame while in OPERATION_STATE_NORMAL)
+    render_segments();
+
+    operation_state = OPERATION_STATE_NORMAL;
+}
+
+// Lay the strips' render and wire buffers out in the pixel pool for the
+// segment table (clears every strip)
+void resize_strips()
+{
+    uint16_t lengths[STRIP_COUNT];
+    uint8_t *next = pixel_pool;
+
+    segment_strip_lengths(segment_table, lengths);
+
+    for (uint8_t i = 0; i < STRIP_COUNT; i++)
+    {
+        uint16_t bytes = lengths[i] * PIXEL_CHANNELS;
+
+        all_strips[i]->SetBuffers(next, next + bytes, bytes);
+        next += 2 * bytes;
+    }
+}
+
+// Turn off Nav Lights
+void turn_off_nav_lights()
+{
+    timer.cancel();
+    light_sequencer.Stop();
+    port_nav_strip.clear();
+    port_nav_strip.show();
+    starboard_nav_strip.clear();
+    starboard_nav_strip.show();
+    beacon_strip.clear();
+    beacon_strip.show();
+    landing_lights_on = false;
+    landing_strip.clear();
+    landing_strip.show();
+}
+
+// Strobe sequence functions
+bool run_light_sequencer(void *) {
+    unsigned long next_step_in_msecs = light_sequencer.Update(millis());
+
+    // Reschedule for the next step.  The sequence uses one task, but this
+    // one only frees its slot on return, so it needs two of the timer's 12
+    // for that moment (whoever restarts the sequence cancels the timer
+    // first, see turn_off_nav_lights(), so there is never a second chain).
+    if (light_sequencer.Profile != NULL)
+    {
+        timer.in(next_step_in_msecs, run_light_sequencer);
+    }
+
+    return false;
+}
+
+// The step's color shows from the next frame on (render_segments()).  The
+// beacon follows beacon_envelope, so the strobe is the only sequenced segment.
+void apply_light_sequence_step(uint8_t segment, uint32_t color) {
+    if (segment == SEQUENCE_SEGMENT_STROBE)
+    {
+        strobe_color = color;
+    }
+}
+
+// Draw the segment table in one pass: each entry is filled with its role's
+// color on each of its strips, later entries over earlier ones.  fill()
+// only marks a strip dirty if its pixels change.
+void render_segments()
+{
+    uint32_t role_colors[SEGMENT_ROLE_COUNT];
+
+    role_colors[SEGMENT_ROLE_NAV] = green;
+    role_colors[SEGMENT_ROLE_STROBE] = strobe_color;
+    role_colors[SEGMENT_ROLE_BEACON] = Envelope::Scale(red, beacon_envelope.Level(millis()));
+    role_colors[SEGMENT_ROLE_LANDING] = landing_lights_on ? white : black;
+
+    for (uint8_t i = 0; i < SEGMENT_TABLE_SIZE; i++)
+    {
+        const sSegment *segment = &segment_table[i];
+
+        for (uint8_t strip = 0; strip < STRIP_COUNT && segment->count != 0; strip++)
+        {
+            if (segment->strips & (1 << strip))
+            {
+                uint32_t color = (segment->role == SEGMENT_ROLE_NAV && (1 << strip) == STRIP_MASK_PORT_NAV) ? red : role_colors[segment->role];
+
+                all_strips[strip]->fill(color, segment->start, segment->count);
+            }
+        }
+    }
+
+    for (uint8_t strip = 0; strip < STRIP_COUNT; strip++)
+    {
+        all_strips[strip]->show();
+    }
+}
+
+// RC Receiver Event Functions
+// Drain the edges captured by the ISRs and act on them outside interrupt context
+void process_rc_events()
+{
+    sEvent event;
+
+    while (rc_event_queue.Pop(&event))
+    {
+        switch (event.type)
+        {
+            case RC_EVENT_LANDING_LED_EDGE:
+
+                handle_landing_lights_edge(event.timestamp_in_micro_seconds);
+
+                break;
+
+            case RC_EVENT_NAV_DISPLAY_MODE_EDGE:
+
+                handle_nav_display_mode_edge(event.timestamp_in_micro_seconds);
+
+                break;
+
+            case RC_EVENT_PPM_EDGE:
+
+                handle_ppm_edge(event.timestamp_in_micro_seconds);
+
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    #if RC_INPUT == RC_INPUT_PCINT
+    process_pin_changes();
+    #endif
+
+    #if defined(ISR_TIMING) && LOG_LEVEL >= LOG_LEVEL_DEBUG
+    if (millis() - isr_timing_last_report_in_milliseconds > ISR_TIMING_REPORT_INTERVAL_IN_MSECS)
+    {
+        isr_timing_last_report_in_milliseconds = millis();
+        report_isr_timing();
+        report_frame_timing();
+    }
+    #endif // ISR_TIMING && LOG_LEVEL_DEBUG
+}
+
+// Feed one edge to the decoder (and completed pulses to the frame scheduler).
+// Returns true if it completed a pulse on a channel with a valid signal.
+bool decode_rc_edge(eRcChannel channel, unsigned long edge_time_in_micro_seconds)
+{
+    if (!rc_decoder.AddEdge(channel, edge_time_in_micro_seconds))
+    {
+        return false;
+    }
+
+    rc_frame_scheduler.AddPulse(channel, edge_time_in_micro_seconds, rc_decoder.RawPulseWidth(channel));
+
+    return accept_rc_pulse(channel, edge_time_in_micro_seconds);
+}
+
+// A pulse the decoder has taken: returns true if the channel's signal is
+// valid, which keeps it from timing out (and may end failsafe)
+bool accept_rc_pulse(eRcChannel channel, unsigned long pulse_end_in_micro_seconds)
+{
+    if (!rc_decoder.IsValid(channel))
+    {
+        return false;
+    }
+
+    rc_signal_monitor.AddPulse(channel, pulse_end_in_micro_seconds,
+            rc_frame_scheduler.IsLocked(channel, pulse_end_in_micro_seconds)
+                ? rc_frame_scheduler.Channel[channel].period_in_micro_seconds : 0);
+
+    // Every lost channel is valid again
+    if (operation_state == OPERATION_STATE_FAILSAFE && rc_signal_monitor.LostMask == 0)
+    {
+        leave_failsafe();
+    }
+
+    return true;
+}
+
+// Frame tick: act on channels whose pulses stopped.  A lost channel's
+// decoder starts over, so it needs RC_PWM_VALID_PULSE_COUNT good pulses
+// to count as back.  While displaying, any loss switches to the failsafe
+// pattern until every lost channel is back.
+void check_rc_signal()
+{
+    uint8_t lost = rc_signal_monitor.Check(micros());
+
+    if (lost == 0)
+    {
+        return;
+    }
+
+    for (uint8_t channel = 0; channel < RC_CHANNEL_COUNT; channel++)
+    {
+        if (lost & (1 << channel))
+        {
+            LOG_WARN(LOG_EVENT_RC_SIGNAL_LOST, channel,
+                    log_clamp((micros() - rc_signal_monitor.Channel[channel].last_pulse_in_micro_seconds) / 1000));
+            rc_decoder.Reset(channel);
+        }
+    }
+
+    if (lost & (1 << RC_CHANNEL_LANDING_LED))
+    {
+        landing_led_pulse_width_in_micro_seconds = 0;
+    }
+    if (lost & (1 << RC_CHANNEL_NAV_DISPLAY_MODE))
+    {
+        nav_display_mode_pulse_width_in_micro_seconds = 0;
+    }
+
+    if (is_running_state() && failsafe_pattern != FAILSAFE_PATTERN_HOLD)
+    {
+        enter_failsafe();
+    }
+}
+
+void enter_failsafe()
+{
+    switch (operation_state)
+    {
+        case OPERATION_STATE_RAINBOW:
+
+            failsafe_resume_position = NAV_DISPLAY_MODE_POSITION_RAINBOW;
+
+            break;
+
+        case OPERATION_STATE_CHASE:
+
+            failsafe_resume_position = NAV_DISPLAY_MODE_POSITION_CHASE;
+
+            break;
+
+        default:
+
+            failsafe_resume_position = NAV_DISPLAY_MODE_POSITION_NAV;
+
+            break;
+    }
+
+    turn_off_nav_lights();
+
+    if (failsafe_pattern == FAILSAFE_PATTERN_NAV)
+    {
+        initialize_nav_lights();
+    }
+    else
+    {
+        strobe_color = black;
+        light_sequencer.Start(&failsafe_light_sequence, millis());
+        timer.in(0, run_light_sequencer);
+    }
+
+    operation_state = OPERATION_STATE_FAILSAFE;
+    failsafe_start_in_milliseconds = millis();
+    LOG_INFO(LOG_EVENT_STATE_TRANSITION, OPERATION_STATE_FAILSAFE, 0);
+}
+
+// Back to the mode the switch asks for, or the one failsafe interrupted
+void leave_failsafe()
+{
+    eNavDisplayModePosition position = failsafe_resume_position;
+
+    if (rc_decoder.IsValid(RC_CHANNEL_NAV_DISPLAY_MODE))
+    {
+        position = (eNavDisplayModePosition)rc_decoder.Position(RC_CHANNEL_NAV_DISPLAY_MODE);
+    }
+
+    LOG_INFO(LOG_EVENT_RC_SIGNAL_RESTORED, log_clamp(millis() - failsafe_start_in_milliseconds), 0);
+
+    set_nav_display_mode(position);
+}
+
+// Failsafe strobe: every LED of every strip in the strobe color
+void render_failsafe()
+{
+    for (uint8_t strip = 0; strip < STRIP_COUNT; strip++)
+    {
+        all_strips[strip]->fill(strobe_color);
+        all_strips[strip]->show();
+    }
+}
+
+// Compositor flush gate: only mask interrupts in the gaps between RC pulses
+bool can_flush_strips(unsigned long now_in_micro_seconds, uint16_t duration_in_micro_seconds)
+{
+    return rc_frame_scheduler.CanShow(now_in_micro_seconds, duration_in_micro_seconds);
+}
+
+// Called at the end of each ISR (interrupts are already masked there)
+void record_isr_time(unsigned long isr_start_time_in_micro_seconds)
+{
+    unsigned long elapsed_in_micro_seconds = micros() - isr_start_time_in_micro_seconds;
+
+    isr_timing.count++;
+    isr_timing.total_micro_seconds += elapsed_in_micro_seconds;
+
+    if (elapsed_in_micro_seconds > isr_timing.max_micro_seconds)
+    {
+        isr_timing.max_micro_seconds = elapsed_in_micro_seconds;
+    }
+}
+
+void report_isr_timing()
+{
+    sIsrTiming timing;
+    uint16_t dropped;
+
+    noInterrupts();
+    timing.count = isr_timing.count;
+    timing.total_micro_seconds = isr_timing.total_micro_seconds;
+    timing.max_micro_seconds = isr_timing.max_micro_seconds;
+    dropped = rc_event_queue.Dropped;
+    #if RC_INPUT == RC_INPUT_PCINT
+    dropped += rc_pin_change_queue.Dropped;
+    #endif
+    interrupts();
+
+    LOG_DEBUG(LOG_EVENT_ISR_COUNT, log_clamp(timing.count), dropped);
+    LOG_DEBUG(LOG_EVENT_ISR_TIMING,
+            log_clamp(timing.count ? timing.total_micro_seconds / timing.count : 0),
+            timing.max_micro_seconds);
+}
+
+void report_frame_timing()
+{
+    const sFrameTiming *timing = &compositor.Timing;
+
+    LOG_DEBUG(LOG_EVENT_FRAME_COUNT, log_clamp(timing->frames), log_clamp(timing->frames_dropped));
+    LOG_DEBUG(LOG_EVENT_RENDER_TIMING,
+            log_clamp(timing->frames ? timing->render_total_micro_seconds / timing->frames : 0),
+            log_clamp(timing->render_max_micro_seconds));
+    LOG_DEBUG(LOG_EVENT_FLUSH_TIMING,
+            log_clamp(timing->frames ? timing->flush_total_micro_seconds / timing->frames : 0),
+            log_clamp(timing->flush_max_micro_seconds));
+    LOG_DEBUG(LOG_EVENT_SHOWS_DEFERRED, log_clamp(rc_frame_scheduler.ShowsDeferred),
+            log_clamp(rc_frame_scheduler.CollisionsAvoided));
+    LOG_DEBUG(LOG_EVENT_SHOWS_FORCED, log_clamp(rc_frame_scheduler.ShowsForced),
+            log_clamp(rc_frame_scheduler.ShowsUnscheduled));
+}
+
+// Landing Lights Functions
+void LandingLightsPulseWidthTimer() {
+    unsigned long now_in_micro_seconds = micros();
+
+    rc_event_queue.Push(RC_EVENT_LANDING_LED_EDGE, now_in_micro_seconds);
+
+    #ifdef ISR_TIMING
+    record_isr_time(now_in_micro_seconds);
+    #endif // ISR_TIMING
+}
+
+void handle_landing_lights_edge(unsigned long edge_time_in_micro_seconds) {
+    if (decode_rc_edge(RC_CHANNEL_LANDING_LED, edge_time_in_micro_seconds))
+    {
+        apply_landing_lights();
+    }
+}
+
+// Act on a valid landing lights pulse
+void apply_landing_lights() {
+    landing_led_pulse_width_in_micro_seconds = rc_decoder.PulseWidth(RC_CHANNEL_LANDING_LED);
+
+    if (operation_state == OPERATION_STATE_NORMAL)
+    {
+        bool switch_on = (rc_decoder.Position(RC_CHANNEL_LANDING_LED) == LANDING_LED_POSITION_ON);
+
+        if (!landing_lights_on && switch_on) {
+            landing_lights_on = true;
+            LOG_INFO(LOG_EVENT_LANDING_LIGHTS, 1, landing_led_pulse_width_in_micro_seconds);
+        } else if (landing_lights_on && !switch_on) {
+            landing_lights_on = false;
+            LOG_INFO(LOG_EVENT_LANDING_LIGHTS, 0, landing_led_pulse_width_in_micro_seconds);
+        }
+    }
+}
+
+void NavDisplayModePulseWidthTimer()
+{
+    unsigned long now_in_micro_seconds = micros();
+
+    rc_event_queue.Push(RC_EVENT_NAV_DISPLAY_MODE_EDGE, now_in_micro_seconds);
+
+    #ifdef ISR_TIMING
+    record_isr_time(now_in_micro_seconds);
+    #endif // ISR_TIMING
+}
+
+void handle_nav_display_mode_edge(unsigned long edge_time_in_micro_seconds)
+{
+    if (decode_rc_edge(RC_CHANNEL_NAV_DISPLAY_MODE, edge_time_in_micro_seconds))
+    {
+        apply_nav_display_mode();
+    }
+}
+
+// Act on a valid display mode pulse
+void apply_nav_display_mode()
+{
+    nav_display_mode_pulse_width_in_micro_seconds = rc_decoder.PulseWidth(RC_CHANNEL_NAV_DISPLAY_MODE);
+
+    // Failsafe ends only once every lost channel is back (accept_rc_pulse())
+    if (operation_state == OPERATION_STATE_FAILSAFE)
+    {
+        return;
+    }
+
+    set_nav_display_mode((eNavDisplayModePosition)rc_decoder.Position(RC_CHANNEL_NAV_DISPLAY_MODE));
+}
+
+// Single pin receiver input
+void PpmEdgeTimer()
+{
+    unsigned long now_in_micro_seconds = micros();
+
+    rc_event_queue.Push(RC_EVENT_PPM_EDGE, now_in_micro_seconds);
+
+    #ifdef ISR_TIMING
+    record_isr_time(now_in_micro_seconds);
+    #endif // ISR_TIMING
+}
+
+void handle_ppm_edge(unsigned long edge_time_in_micro_seconds)
+{
+    #if RC_INPUT == RC_INPUT_PPM
+    if (rc_bus_decoder.AddEdge(edge_time_in_micro_seconds))
+    {
+        handle_rc_bus_frame(&rc_bus_decoder.Frame, rc_bus_decoder.FrameEnd,
+                rc_bus_decoder.FrameEnd - rc_bus_decoder.FrameStart);
+    }
+    #else
+    (void)edge_time_in_micro_seconds;
+    #endif // RC_INPUT_PPM
+}
+
+// A whole frame of channels: each function takes the channel rc_bus_channels
+// assigns it, as if it were a pulse on its own pin that ended with the
+// frame.  The frame's time on the wire stands in for the pulse, so strip
+// flushes go in the gap between frames.  Frames the receiver flags as
+// failsafe are ignored, so the functions time out (check_rc_signal()).
+void handle_rc_bus_frame(const sRcBusFrame *frame, unsigned long frame_end_in_micro_seconds,
+        uint16_t frame_duration_in_micro_seconds)
+{
+    if (frame->failsafe)
+    {
+        return;
+    }
+
+    for (uint8_t channel = 0; channel < RC_CHANNEL_COUNT; channel++)
+    {
+        uint8_t source = rc_bus_channels[channel];
+
+        if (source >= frame->channel_count)
+        {
+            continue;
+        }
+
+        decode_rc_width((eRcChannel)channel, frame_end_in_micro_seconds, frame->channels[source],
+                frame_duration_in_micro_seconds);
+    }
+}
+
+// A pulse whose width is measured elsewhere (a bus frame, a pin change
+// input): as decode_rc_edge(), then act on it.  The duration is the time
+// the pulse held the input, for the flush scheduler.
+void decode_rc_width(eRcChannel channel, unsigned long pulse_end_in_micro_seconds,
+        uint16_t pulse_width_in_micro_seconds, uint16_t pulse_duration_in_micro_seconds)
+{
+    rc_frame_scheduler.AddPulse(channel, pulse_end_in_micro_seconds, pulse_duration_in_micro_seconds);
+
+    if (!rc_decoder.AddPulseWidth(channel, pulse_width_in_micro_seconds)
+            || !accept_rc_pulse(channel, pulse_end_in_micro_seconds))
+    {
+        return;
+    }
+
+    if (channel == RC_CHANNEL_LANDING_LED)
+    {
+        apply_landing_lights();
+    }
+    else
+    {
+        apply_nav_display_mode();
+    }
+}
+
+#if RC_INPUT == RC_INPUT_PCINT
+// Pin change receiver input: one interrupt for the whole port, so edges
+// that arrive together cost one sample, and the ISR takes the same time
+// however many channels are connected
+ISR(PCINT0_vect)
+{
+    RcPinChangeTimer();
+}
+
+void RcPinChangeTimer()
+{
+    unsigned long now_in_micro_seconds = micros();
+    uint8_t levels = PINB & RC_PCINT_MASK;
+
+    // A pin that changed back before the read leaves nothing to record
+    if (levels != rc_pin_change_levels)
+    {
+        rc_pin_change_levels = levels;
+        rc_pin_change_queue.Push(levels, now_in_micro_seconds);
+    }
+
+    #ifdef ISR_TIMING
+    record_isr_time(now_in_micro_seconds);
+    #endif // ISR_TIMING
+}
+
+// Drain the port samples.  A sample lost to a full queue leaves the pulses
+// then in progress unknowable, so they are dropped rather than mismeasured.
+void process_pin_changes()
+{
+    sEvent event;
+    uint16_t dropped;
+
+    noInterrupts();
+    dropped = rc_pin_change_queue.Dropped;
+    interrupts();
+
+    if (dropped != rc_pin_change_dropped)
+    {
+        rc_pin_change_dropped = dropped;
+        rc_pin_change_decoder.Resync();
+    }
+
+    while (rc_pin_change_queue.Pop(&event))
+    {
+        handle_pin_change(event.type, event.timestamp_in_micro_seconds);
+    }
+}
+
+// One port sample: each function takes the input rc_bus_channels assigns
+// it, and its pulse ends with the sample its pin fell in
+void handle_pin_change(uint8_t levels, unsigned long sample_time_in_micro_seconds)
+{
+    uint8_t complete = rc_pin_change_decoder.AddSample(levels, sample_time_in_micro_seconds);
+
+    for (uint8_t channel = 0; complete != 0 && channel < RC_CHANNEL_COUNT; channel++)
+    {
+        uint8_t input = rc_bus_channels[channel];
+
+        if (input < RC_PCINT_INPUTS && (complete & (1 << input)))
+        {
+            uint16_t width = rc_pin_change_decoder.Width[input];
+
+            decode_rc_width((eRcChannel)channel, sample_time_in_micro_seconds, width, width);
+        }
+    }
+}
+#endif // RC_INPUT_PCINT
+
+// Switch the running display mode (from the RC switch or a serial command)
+void set_nav_display_mode(eNavDisplayModePosition position)
+{
+    switch (position)
+    {
+        case NAV_DISPLAY_MODE_POSITION_CHASE:
+
+            if (operation_state != OPERATION_STATE_CHASE) {
+                operation_state = OPERATION_STATE_CHASE;
+                LOG_INFO(LOG_EVENT_DISPLAY_MODE, OPERATION_STATE_CHASE, nav_display_mode_pulse_width_in_micro_seconds);
+
+                turn_off_nav_lights();
+
+                set_nav_lights_to_theater_chase();
+            }
+
+            break;
+
+        case NAV_DISPLAY_MODE_POSITION_RAINBOW:
+
+            if (operation_state != OPERATION_STATE_RAINBOW) {
+                operation_state = OPERATION_STATE_RAINBOW;
+                LOG_INFO(LOG_EVENT_DISPLAY_MODE, OPERATION_STATE_RAINBOW, nav_display_mode_pulse_width_in_micro_seconds);
+
+                turn_off_nav_lights();
+
+                set_nav_lights_to_rainbow();
+            }
+
+            break;
+
+        case NAV_DISPLAY_MODE_POSITION_NAV:
+        default:
+
+            if (operation_state != OPERATION_STATE_NORMAL) {
+                operation_state = OPERATION_STATE_NORMAL;
+                LOG_INFO(LOG_EVENT_DISPLAY_MODE, OPERATION_STATE_NORMAL, nav_display_mode_pulse_width_in_micro_seconds);
+
+                turn_off_nav_lights();
+
+                initialize_nav_lights();
+            }
+
+            break;
+    }
+}
+
+void set_nav_lights_to_rainbow()
+{
+    port_nav_strip.RainbowCycle(3);
+    starboard_nav_strip.RainbowCycle(3);
+    beacon_strip.RainbowCycle(3);
+    landing_strip.RainbowCycle(3);
+}
+
+void set_nav_lights_to_theater_chase()
+{
+    uint8_t random_color = random(255);
+    uint8_t anti_random_color = random_color + 128;
+
+    port_nav_strip.TheaterChase(port_nav_strip.Wheel(random_color), port_nav_strip.Wheel(anti_random_color), 100);
+    starboard_nav_strip.TheaterChase(starboard_nav_strip.Wheel(random_color), starboard_nav_strip.Wheel(anti_random_color), 100);
+    beacon_strip.TheaterChase(beacon_strip.Wheel(random_color), beacon_strip.Wheel(anti_random_color), 100);
+    landing_strip.TheaterChase(landing_strip.Wheel(random_color), landing_strip.Wheel(anti_random_color), 100);
+}
+
+// Step every strip's pattern against the same frame time
+void update_color_mode_for_nav_lights()
+{
+    unsigned long frame_time_in_milliseconds = millis();
+
+    port_nav_strip.Update(frame_time_in_milliseconds);
+    starboard_nav_strip.Update(frame_time_in_milliseconds);
+    beacon_strip.Update(frame_time_in_milliseconds);
+    landing_strip.Update(frame_time_in_milliseconds);
+}
+
+// Compositor render callback
+void render_frame()
+{
+    check_rc_signal();
+    LOOP_PROFILE(LOOP_STAGE_FRAME_TICK);
+    manage_running_states();
+    LOOP_PROFILE(LOOP_STAGE_RUNNING_STATES);
+}
+
+void manage_running_states()
+{
+    switch (operation_state)
+    {
+        case OPERATION_STATE_NORMAL:
+
+            render_segments();
+
+            break;
+        
+        case OPERATION_STATE_RAINBOW:
+
+            update_color_mode_for_nav_lights();
+
+            break;
+
+        case OPERATION_STATE_CHASE:
+
+            update_color_mode_for_nav_lights();
+
+            break;
+
+        case OPERATION_STATE_FAILSAFE:
+
+            if (failsafe_pattern == FAILSAFE_PATTERN_NAV)
+            {
+                render_segments();
+            }
+            else
+            {
+                render_failsafe();
+            }
+
+            break;
 
         default:
             break;
@@ -724,20 +2192,68 @@ bool turn_off_first_nav_led_no_repeat(void *)
     return false;
 }
 
+// One repeating task however long the segment, so the blinks never run
+// the timer out of slots
 void blink_nav_for_number_of_segments(int num_of_blinks)
 {
     const int PERIOD_IN_MSECS = 200;
-    int time_to_fire_function_in_msecs = 0;
 
-    timer.in(time_to_fire_function_in_msecs, turn_off_first_nav_led_no_repeat);
-    time_to_fire_function_in_msecs = PERIOD_IN_MSECS * 2;
+    timer.cancel(segment_blink_task);
+    turn_off_first_nav_led_no_repeat(NULL);
+
+    // The first tick is the pause before the count, then on and off
+    segment_blink_ticks_remaining = 2 * num_of_blinks + 1;
+    segment_blink_task = timer.every(PERIOD_IN_MSECS, blink_nav_segment_count_tick);
+}
+
+bool blink_nav_segment_count_tick(void *)
+{
+    segment_blink_ticks_remaining--;
 
-    for (int i = 0; i < num_of_blinks; i++)
+    if (segment_blink_ticks_remaining & 1)
     {
-        timer.in(time_to_fire_function_in_msecs, turn_on_first_nav_led_no_repeat);
-        time_to_fire_function_in_msecs += PERIOD_IN_MSECS;
-        timer.in(time_to_fire_function_in_msecs, turn_off_first_nav_led_no_repeat);
-        time_to_fire_function_in_msecs += PERIOD_IN_MSECS;
+        turn_on_first_nav_led_no_repeat(NULL);
+    }
+    else
+    {
+        turn_off_first_nav_led_no_repeat(NULL);
+    }
+
+    if (segment_blink_ticks_remaining == 0)
+    {
+        segment_blink_task = 0;  // the timer drops the task, don't cancel it later
+        return false;
+    }
+
+    return true;
+}
+
+// Config menu: one more LED in the role's segment, back to 1 past its
+// max or the pixel pool.  The strobe segment follows the nav one.
+void step_segment_count(uint8_t role)
+{
+    static const uint8_t max_counts[SEGMENT_ROLE_COUNT] = {
+        MAX_NAV_LED_SEGMENT_COUNT,
+        MAX_STROBE_LED_SEGMENT_COUNT,
+        MAX_BEACON_LED_SEGMENT_COUNT,
+        MAX_LANDING_LED_SEGMENT_COUNT
+    };
+    uint8_t max_count = max_counts[role];
+    sSegment *segment = &segment_table[role];
+
+    segment->count = (segment->count < max_count) ? segment->count + 1 : 1;
+    if (role == SEGMENT_ROLE_NAV)
+    {
+        segment_table[SEGMENT_ROLE_STROBE].start = segment->count;
+    }
+
+    if (!segments_fit_pixel_pool())
+    {
+        segment->count = 1;
+        if (role == SEGMENT_ROLE_NAV)
+        {
+            segment_table[SEGMENT_ROLE_STROBE].start = segment->count;
+        }
     }
 }
 
@@ -810,530 +2326,192 @@ void rapid_blink_nav_led_with_color(uint32_t color)
 // Configuration Button functions
 void long_click_start()
 {
-    long_button_press_start_time_in_milliseconds 
-            = current_time_in_milliseconds = millis();
-
-    switch (operation_state)
-    {
-        case OPERATION_STATE_NORMAL:
-        case OPERATION_STATE_RAINBOW:
-        case OPERATION_STATE_CHASE:
-
-            config_state_start_time_in_milliseconds
-                    = current_time_in_milliseconds;
-
-            operation_state = OPERATION_STATE_CONFIG_MAIN_ON_NAV;
-
-            current_config_state_timer_in_milliseconds = 0;
-
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_NAV");
-            #endif // DEBUG
-
-            turn_off_nav_lights();
-
-            port_nav_strip.fill(green, 0, 1);
-            port_nav_strip.show();
-
-            break;
-
-        case OPERATION_STATE_CONFIG_MAIN_ON_NAV:
-        case OPERATION_STATE_CONFIG_MAIN_ON_STROBE:
-        case OPERATION_STATE_CONFIG_MAIN_ON_BEACON:
-        case OPERATION_STATE_CONFIG_MAIN_ON_LANDING:
-        case OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET:
-
-            operation_state = OPERATION_STATE_NORMAL;
-
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_NORMAL");
-            #endif // DEBUG
+    current_time_in_milliseconds = millis();
 
-            update_eeprom();
-
-            initialize_nav_lights();
-
-            break;
-
-        case OPERATION_STATE_CONFIG_IN_FACTORY_RESET:
+    dispatch_menu_event(MENU_EVENT_LONG_CLICK);
+}
 
-            #ifdef DEBUG
-            Serial.println("Doing Factory Reset");
-            #endif // DEBUG
+void single_click()
+{
+    dispatch_menu_event(MENU_EVENT_CLICK);
+}
 
-            is_config_setting_modified = true;
+// Configuration State Management
+// Raise MENU_EVENT_TIMEOUT once a config menu item has run its time
+void manage_config_states()
+{
+    unsigned long now_in_milliseconds = millis();
 
-            current_config_state_timer_in_milliseconds = 0;
+    if (operation_state == OPERATION_STATE_INIT || operation_state == OPERATION_STATE_FAILSAFE
+            || is_running_state())
+    {
+        return;
+    }
 
-            // Reset all segment counts to defaults and update lengths
-            nav_led_segment_count = DEFAULT_NAV_LED_SEGMENT_COUNT;
-            nav_led_segment_start_index = DEFAULT_NAV_LED_SEGMENT_START_INDEX;
-            strobe_led_segment_count = DEFAULT_STROBE_LED_SEGMENT_COUNT;
-            strobe_led_segment_start_index = nav_led_segment_count;
-            nav_and_strobe_led_string_count = nav_led_segment_count + strobe_led_segment_count;
+    current_config_state_timer_in_milliseconds += now_in_milliseconds - current_time_in_milliseconds;
 
-            beacon_led_segment_count = DEFAULT_BEACON_LED_SEGMENT_COUNT;
-            beacon_led_segment_start_index = DEFAULT_BEACON_LED_SEGMENT_START_INDEX;
+    current_time_in_milliseconds = now_in_milliseconds;
 
-            landing_led_segment_count = DEFAULT_LANDING_LED_SEGMENT_COUNT;
-            landing_led_segment_start_index = DEFAULT_LANDING_LED_SEGMENT_START_INDEX;
+    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
+    {
+        dispatch_menu_event(MENU_EVENT_TIMEOUT);
+    }
+}
 
-            port_nav_strip.updateLength(nav_and_strobe_led_string_count);
-            starboard_nav_strip.updateLength(nav_and_strobe_led_string_count);
-            beacon_strip.updateLength(beacon_led_segment_count);
-            landing_strip.updateLength(landing_led_segment_count);
+// Take the menu_transitions row for event in the current state, if any:
+// move to its next state, restart the menu item time, run its action and
+// show its indicator
+bool dispatch_menu_event(eMenuEvent event)
+{
+    sMenuTransition transition;
 
-            color_timer.cancel();
-            rapid_blink_nav_led_with_color(purple);
+    if (!menu_transition_find(menu_transitions, menu_transition_count, operation_state, event, &transition))
+    {
+        return false;
+    }
 
-            break;
+    if (transition.next_state != operation_state)
+    {
+        operation_state = (eOperationState)transition.next_state;
+        LOG_INFO(LOG_EVENT_STATE_TRANSITION, transition.next_state, 0);
+    }
 
-        default:
+    current_config_state_timer_in_milliseconds = 0;
 
-            break;
+    if ((transition.action == NULL || transition.action(&transition))
+            && transition.indicator != MENU_INDICATOR_NONE)
+    {
+        port_nav_strip.fill(transition.indicator, 0, 1);
+        port_nav_strip.show();
     }
+
+    return true;
 }
 
-void single_click()
+// Menu actions (see sMenuTransition)
+bool menu_start_display_mode(const sMenuTransition *transition)
 {
-    switch (operation_state)
-    {
-        case OPERATION_STATE_NORMAL:
-
-            operation_state = OPERATION_STATE_RAINBOW;
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_RAINBOW");
-            #endif // DEBUG
+    turn_off_nav_lights();
 
-            turn_off_nav_lights();
+    switch (transition->next_state)
+    {
+        case OPERATION_STATE_RAINBOW:
 
             set_nav_lights_to_rainbow();
 
             break;
 
-        case OPERATION_STATE_RAINBOW:
-
-            operation_state = OPERATION_STATE_CHASE;
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_CHASE");
-            #endif // DEBUG
-
-            turn_off_nav_lights();
+        case OPERATION_STATE_CHASE:
 
             set_nav_lights_to_theater_chase();
 
             break;
 
-        case OPERATION_STATE_CHASE:
-
-            operation_state = OPERATION_STATE_NORMAL;
-
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_NORMAL");
-            # endif // DEBUG
-
-            turn_off_nav_lights();
+        default:
 
             initialize_nav_lights();
 
             break;
+    }
 
-        case OPERATION_STATE_CONFIG_MAIN_ON_NAV:
-
-            operation_state = OPERATION_STATE_CONFIG_IN_NAV;
-
-            current_config_state_timer_in_milliseconds = 0;
-
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_CONFIG_IN_NAV");
-            #endif // DEBUG
-
-            blink_nav_for_number_of_segments(nav_led_segment_count);
-
-            break;
-
-        case OPERATION_STATE_CONFIG_IN_NAV:
-
-            #ifdef DEBUG
-            Serial.println("Modifying NAV");
-            #endif // DEBUG
-
-            is_config_setting_modified = true;
-
-            current_config_state_timer_in_milliseconds = 0;
-
-            nav_led_segment_count++;
-
-            if (nav_led_segment_count > MAX_NAV_LED_SEGMENT_COUNT)
-            {
-                nav_led_segment_count = 1;
-            }
-
-            strobe_led_segment_start_index = nav_led_segment_count;
-
-            nav_and_strobe_led_string_count = nav_led_segment_count + strobe_led_segment_count;
-
-            port_nav_strip.updateLength(nav_and_strobe_led_string_count);
-            starboard_nav_strip.updateLength(nav_and_strobe_led_string_count);
-
-            blink_nav_for_number_of_segments(nav_led_segment_count);
-
-            break;
-
-        case OPERATION_STATE_CONFIG_MAIN_ON_STROBE:
-
-            operation_state = OPERATION_STATE_CONFIG_IN_STROBE;
-
-            current_config_state_timer_in_milliseconds = 0;
-
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_CONFIG_IN_STROBE");
-            #endif // DEBUG
-
-            blink_nav_for_number_of_segments(strobe_led_segment_count);
-
-            break;
-
-        case OPERATION_STATE_CONFIG_IN_STROBE:
-
-            #ifdef DEBUG
-            Serial.println("Modifying STROBE");
-            #endif // DEBUG
-
-            is_config_setting_modified = true;
-
-            current_config_state_timer_in_milliseconds = 0;
-
-            strobe_led_segment_count++;
-
-            if (strobe_led_segment_count > MAX_STROBE_LED_SEGMENT_COUNT)
-            {
-                strobe_led_segment_count = 1;
-            }
-
-            nav_and_strobe_led_string_count = nav_led_segment_count + strobe_led_segment_count;
-
-            port_nav_strip.updateLength(nav_and_strobe_led_string_count);
-            starboard_nav_strip.updateLength(nav_and_strobe_led_string_count);
-
-            blink_nav_for_number_of_segments(strobe_led_segment_count);
-
-            break;
-
-        case OPERATION_STATE_CONFIG_MAIN_ON_BEACON:
-
-            operation_state = OPERATION_STATE_CONFIG_IN_BEACON;
-
-            current_config_state_timer_in_milliseconds = 0;
-
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_CONFIG_IN_BEACON");
-            #endif // DEBUG
-
-            blink_nav_for_number_of_segments(beacon_led_segment_count);
-
-            break;
-
-        case OPERATION_STATE_CONFIG_IN_BEACON:
-
-            #ifdef DEBUG
-            Serial.println("Modifying BEACON");
-            #endif // DEBUG
-
-            is_config_setting_modified = true;
-
-            current_config_state_timer_in_milliseconds = 0;
-
-            beacon_led_segment_count++;
-
-            if (beacon_led_segment_count > MAX_BEACON_LED_SEGMENT_COUNT)
-            {
-                beacon_led_segment_count = 1;
-            }
+    return true;
+}
 
-            beacon_strip.updateLength(beacon_led_segment_count);
+bool menu_enter_config(const sMenuTransition *)
+{
+    turn_off_nav_lights();
 
-            blink_nav_for_number_of_segments(beacon_led_segment_count);
+    return true;
+}
 
-            break;
+bool menu_exit_config(const sMenuTransition *)
+{
+    update_eeprom();
 
-        case OPERATION_STATE_CONFIG_MAIN_ON_LANDING:
+    initialize_nav_lights();
 
-            operation_state = OPERATION_STATE_CONFIG_IN_LANDING;
+    return true;
+}
 
-            current_config_state_timer_in_milliseconds = 0;
+bool menu_show_segment_count(const sMenuTransition *transition)
+{
+    blink_nav_for_number_of_segments(segment_table[transition->arg].count);
 
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_CONFIG_IN_LANDING");
-            #endif // DEBUG
+    return true;
+}
 
-            blink_nav_for_number_of_segments(landing_led_segment_count);
+bool menu_step_segment_count(const sMenuTransition *transition)
+{
+    LOG_INFO(LOG_EVENT_MODIFYING_SEGMENT, transition->state, 0);
 
-            break;
+    is_config_setting_modified = true;
 
-        case OPERATION_STATE_CONFIG_IN_LANDING:
+    step_segment_count(transition->arg);
 
-            #ifdef DEBUG
-            Serial.println("Modifying LANDING");
-            #endif // DEBUG
+    resize_strips();
 
-            is_config_setting_modified = true;
+    blink_nav_for_number_of_segments(segment_table[transition->arg].count);
 
-            current_config_state_timer_in_milliseconds = 0;
+    return true;
+}
 
-            landing_led_segment_count++;
+// A changed setting is acknowledged with a rapid blink before the next
+// item's color
+bool menu_leave_segment_count(const sMenuTransition *transition)
+{
+    if (!is_config_setting_modified)
+    {
+        return true;
+    }
 
-            if (landing_led_segment_count > MAX_LANDING_LED_SEGMENT_COUNT)
-            {
-                landing_led_segment_count = 1;
-            }
+    is_config_setting_modified = false;
+    rapid_blink_nav_then_set_config_main(transition->indicator);
 
-            landing_strip.updateLength(landing_led_segment_count);
+    return false;
+}
 
-            blink_nav_for_number_of_segments(landing_led_segment_count);
+bool menu_prompt_factory_reset(const sMenuTransition *transition)
+{
+    blink_nav_led_with_color(transition->indicator);
 
-            break;
+    return false;
+}
 
-        case OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET:
+bool menu_factory_reset(const sMenuTransition *transition)
+{
+    sConfigRecord config;
 
-            operation_state = OPERATION_STATE_CONFIG_IN_FACTORY_RESET;
+    LOG_INFO(LOG_EVENT_FACTORY_RESET, 0, 0);
 
-            current_config_state_timer_in_milliseconds = 0;
+    is_config_setting_modified = true;
 
-            #ifdef DEBUG
-            Serial.println("State Transition TO: OPERATION_STATE_CONFIG_IN_FACTORY_RESET");
-            #endif // DEBUG
+    // Reset the segment table to defaults and update lengths
+    default_config(&config);
+    apply_config(&config);
 
-            blink_nav_led_with_color(purple);
+    resize_strips();
 
-            break;
+    color_timer.cancel();
+    rapid_blink_nav_led_with_color(transition->indicator);
 
-        default:
-            break;
-    }
+    return false;
 }
 
-// Configuration State Management
-void manage_config_states()
+bool menu_leave_factory_reset(const sMenuTransition *)
 {
-    unsigned long now_in_milliseconds = millis();
-
-    switch (operation_state)
-    {
-        case OPERATION_STATE_CONFIG_MAIN_ON_NAV:
-        case OPERATION_STATE_CONFIG_MAIN_ON_STROBE:
-        case OPERATION_STATE_CONFIG_MAIN_ON_BEACON:
-        case OPERATION_STATE_CONFIG_MAIN_ON_LANDING:
-        case OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET:
-
-        case OPERATION_STATE_CONFIG_IN_NAV:
-        case OPERATION_STATE_CONFIG_IN_STROBE:
-        case OPERATION_STATE_CONFIG_IN_BEACON:
-        case OPERATION_STATE_CONFIG_IN_LANDING:
-        case OPERATION_STATE_CONFIG_IN_FACTORY_RESET:
-
-            current_config_state_timer_in_milliseconds += now_in_milliseconds - current_time_in_milliseconds;
+    color_timer.cancel();
+    is_config_setting_modified = false;
 
-            current_time_in_milliseconds = now_in_milliseconds;
+    return true;
+}
 
-            switch (operation_state)
-            {
-                // Main Menu States
-                case OPERATION_STATE_CONFIG_MAIN_ON_NAV:
-                    
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_STROBE;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_STROBE");
-                        #endif // DEBUG
-
-                        port_nav_strip.fill(blue, 0, 1);
-                        port_nav_strip.show();
-                    }
-
-                    break;
-                
-                case OPERATION_STATE_CONFIG_MAIN_ON_STROBE:
-
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_BEACON;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_BEACON");
-                        #endif // DEBU
-
-                        port_nav_strip.fill(red, 0, 1);
-                        port_nav_strip.show();
-                    }
-
-                    break;
-
-                case OPERATION_STATE_CONFIG_MAIN_ON_BEACON:
-
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_LANDING;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_LANDING");
-                        #endif // DEBUG
-
-                        port_nav_strip.fill(yellow, 0, 1);
-                        port_nav_strip.show();
-                    }
-
-                    break;
-
-                case OPERATION_STATE_CONFIG_MAIN_ON_LANDING:
-
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET");
-                        #endif // DEBUG
-
-                        port_nav_strip.fill(purple, 0, 1);
-                        port_nav_strip.show();
-                    }
-
-                    break;
-
-                case OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET:
-
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_NAV;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_NAV");
-                        #endif // DEBUG
-
-                        port_nav_strip.fill(green, 0, 1);
-                        port_nav_strip.show();
-                    }
-
-                    break;
-
-                case OPERATION_STATE_CONFIG_IN_NAV:
-
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_STROBE;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_STROBE");
-                        #endif // DEBUG
-
-                        if (is_config_setting_modified) {
-                            is_config_setting_modified = false;
-                            rapid_blink_nav_then_set_config_main(blue);
-                        } else {
-                            port_nav_strip.fill(blue, 0, 1);
-                            port_nav_strip.show();
-                        }
-                    }
-
-                    break;
-                
-                case OPERATION_STATE_CONFIG_IN_STROBE:
-
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_BEACON;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_BEACON");
-                        #endif // DEBUG
-
-                        if (is_config_setting_modified) {
-                            is_config_setting_modified = false;
-                            rapid_blink_nav_then_set_config_main(red);
-                        } else {
-                            port_nav_strip.fill(red, 0, 1);
-                            port_nav_strip.show();
-                        }
-                   }
-
-                   break;
-
-                case OPERATION_STATE_CONFIG_IN_BEACON:
-
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_LANDING;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_LANDING");
-                        #endif // DEBUG
-
-                        if (is_config_setting_modified) {
-                            is_config_setting_modified = false;
-                            rapid_blink_nav_then_set_config_main(yellow);
-                        } else {
-                            port_nav_strip.fill(yellow, 0, 1);
-                            port_nav_strip.show();
-                        }
-                   }
-
-                   break;
-
-                case OPERATION_STATE_CONFIG_IN_LANDING:
-
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_FACTORY_RESET");
-                        #endif // DEBUG
-
-                        if (is_config_setting_modified) {
-                            is_config_setting_modified = false;
-                            rapid_blink_nav_then_set_config_main(purple);
-                        } else {
-                            port_nav_strip.fill(purple, 0, 1);
-                            port_nav_strip.show();
-                        }
-                   }
-
-                   break;
-
-                case OPERATION_STATE_CONFIG_IN_FACTORY_RESET:
-
-                    if (current_config_state_timer_in_milliseconds > CONFIG_MENU_ITEM_DURATION_IN_MSECS)
-                    {
-                        color_timer.cancel();
-                        current_config_state_timer_in_milliseconds = 0;
-                        operation_state = OPERATION_STATE_CONFIG_MAIN_ON_NAV;
-                        #ifdef DEBUG
-                        Serial.println("State Transition TO: OPERATION_STATE_CONFIG_MAIN_ON_NAV");
-                        #endif // DEBUG
-
-                        if (is_config_setting_modified) {
-                            is_config_setting_modified = false;
-                            port_nav_strip.fill(green, 0, 1);
-                            port_nav_strip.show();
-                        } else {
-                            port_nav_strip.fill(green, 0, 1);
-                            port_nav_strip.show();
-                        }
-                    }
-
-                    break;
-
-                default:
-                    break;
-            }
+// Stop waiting for the lost channels and go back to nav lights
+bool menu_clear_failsafe(const sMenuTransition *)
+{
+    rc_signal_monitor.Reset();
 
-            break;
-            
-        default:
+    turn_off_nav_lights();
+    initialize_nav_lights();
 
-            break;
-    }
-}
\ No newline at end of file
+    return true;
+}
@@ -0,0 +1,1846 @@
+// Native loop() throughput benchmark
+//
+// Runs the firmware's setup()/loop() on the simulated clock of the
+// NativeArduino stand-ins and reports, for every eOperationState that was
+// visited, loop iterations per second, show() transfers per second, bytes
+// clocked out per strip and the share of time spent with interrupts masked,
+// followed by the frame compositor's render and flush times, the loop
+// profiler's per-stage times (LOOP_PROFILER builds), a loopback check of
+// the serial protocol, checks of the config record store, RC signal loss
+// detection latency and failsafe, the RC PWM decoder on synthetic edge
+// trains, the PPM/SBUS/iBUS decoders on recorded streams, the pin change
+// input capture against a model of its ISR timing, frame costs against
+// strip length, a check of the pattern animation speed and a walk through
+// the config menu transitions.
+// All rates are per simulated second, i.e. what a 16 MHz Nano would see with
+// BENCH_LOOP_OVERHEAD_MICROS of non-show() work per loop() pass.
+//
+// Usage: bench [seconds per scenario]
+// Exits with 1 if a serial protocol, config store, failsafe, receiver
+// input, animation speed or menu check fails.
+
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <Arduino.h>
+#include <NativeSim.h>
+#include "NeoPatterns.h"
+#include <arduino-timer.h>
+#include "OperationState.h"
+#include "ConfigMenu.h"
+#include "FrameCompositor.h"
+#include "RcFrameScheduler.h"
+#include "RcSignalMonitor.h"
+#include "RcPwmDecoder.h"
+#include "RcBusDecoder.h"
+#include "EventQueue.h"
+#include "PinChangeDecoder.h"
+#include "SerialProtocol.h"
+#include "LoopProfiler.h"
+#include "MemoryWatermark.h"
+#include "EepromRecordStore.h"
+
+// Modelled cost of one loop() pass excluding show() transfers
+#ifndef BENCH_LOOP_OVERHEAD_MICROS
+#define BENCH_LOOP_OVERHEAD_MICROS 20
+#endif
+
+// Must match the pin assignments in main.cpp
+#define BENCH_LANDING_LED_TOGGLE_PIN 2
+#define BENCH_NAV_DISPLAY_MODE_PIN 3
+#define BENCH_BUTTON_PIN A0
+
+// Must match eRcChannel in main.cpp
+#define BENCH_RC_CHANNEL_COUNT 2
+
+// RC frame period of the simulated receiver.  Not a multiple of the frame
+// clock, so strip flushes sweep across the pulse edges over time.
+#define BENCH_RC_FRAME_MICROS 22013
+
+// Time allowed for a mode change to take effect before measuring
+#define BENCH_SETTLE_MICROS 200000
+
+#define BENCH_STRIP_COUNT 4
+
+// Must match eSerialMessage, eSerialNakReason and sConfigRecord in main.cpp
+#define BENCH_SERIAL_GET_CONFIG 0x01
+#define BENCH_SERIAL_SET_CONFIG 0x02
+#define BENCH_SERIAL_SET_MODE 0x03
+#define BENCH_SERIAL_STREAM_STATUS 0x04
+#define BENCH_SERIAL_GET_STATUS 0x05
+#define BENCH_SERIAL_GET_PROFILE 0x07
+#define BENCH_SERIAL_PROFILE 0x87
+#define BENCH_SERIAL_GET_MEMORY 0x09
+#define BENCH_SERIAL_MEMORY 0x89
+#define BENCH_SERIAL_CONFIG 0x81
+#define BENCH_SERIAL_STATUS 0x85
+#define BENCH_SERIAL_ACK 0xF0
+#define BENCH_SERIAL_NAK 0xF1
+#define BENCH_SERIAL_NAK_BAD_VALUE 2
+#define BENCH_SERIAL_NAK_BUSY 3
+#define BENCH_SERIAL_NAK_RC_OVERRIDE 4
+#define BENCH_CONFIG_RECORD_SIZE 19
+#define BENCH_CONFIG_NAV_LED_SEGMENT_COUNT 0
+#define BENCH_CONFIG_STROBE_LED_SEGMENT_COUNT 1
+#define BENCH_CONFIG_BEACON_LED_SEGMENT_COUNT 2
+#define BENCH_CONFIG_LANDING_LED_SEGMENT_COUNT 3
+#define BENCH_CONFIG_STROBE_LED_SEGMENT_START_INDEX 5
+#define BENCH_CONFIG_EXTRA_SEGMENT 8            // strips, start, count, role
+#define BENCH_CONFIG_RC_BUS_CHANNELS 17         // landing, display mode
+#define BENCH_STRIP_MASK_LANDING 0x08
+#define BENCH_SEGMENT_ROLE_NAV 0
+#define BENCH_STATUS_REPORT_SIZE 12
+
+// Must match eRcChannel in main.cpp
+#define BENCH_RC_CHANNEL_LANDING_LED 0
+#define BENCH_RC_CHANNEL_NAV_DISPLAY_MODE 1
+
+// Config record store: the firmware's slots, record version and default
+// bus channels (must match main.cpp), and a scratch store of the same kind
+// in EEPROM the firmware does not use
+#define BENCH_CONFIG_STORE_BASE_ADDRESS 16
+#define BENCH_CONFIG_STORE_SLOT_COUNT 8
+#define BENCH_CONFIG_STORE_SLOT_SIZE 32
+#define BENCH_CONFIG_RECORD_VERSION 4
+#define BENCH_CONFIG_RECORD_V3_SIZE 17          // up to failsafe_pattern
+#define BENCH_CONFIG_FAILSAFE_PATTERN 16
+#define BENCH_FAILSAFE_PATTERN_NAV 1
+#define BENCH_DEFAULT_LANDING_LED_BUS_CHANNEL 4
+#define BENCH_DEFAULT_NAV_DISPLAY_MODE_BUS_CHANNEL 5
+#define BENCH_STORE_BASE_ADDRESS 512
+#define BENCH_STORE_SLOT_COUNT 4
+#define BENCH_STORE_SLOT_SIZE 16
+#define BENCH_STORE_SAVES 10
+
+// PWM decoder trains: the firmware's pulse limits, filter and display
+// mode detents (must match main.cpp)
+#define BENCH_RC_MIN_PULSE_WIDTH 800
+#define BENCH_RC_MAX_PULSE_WIDTH 2200
+#define BENCH_RC_PULSE_FILTER_SHIFT 2
+#define BENCH_RC_DETENT_HYSTERESIS 100
+#define BENCH_RC_PWM_PERIOD_MICROS 20000
+#define BENCH_RC_PWM_TRAIN_PULSES 40
+
+// Bus frames fed straight to the firmware: period and time on the wire
+#define BENCH_RC_BUS_FRAME_MICROS 14000
+#define BENCH_RC_BUS_FRAME_DURATION_MICROS 3000
+
+// Pin change capture model: six receiver channels on one port, the pin
+// change ISR's entry latency and run time on a 16 MHz AVR, the AVR's
+// micros() resolution and how often loop() drains the samples.  A width is
+// off by at most one ISR run plus latency (an edge arriving during an ISR
+// waits for the next) and one micros() step.
+#define BENCH_PCINT_CHANNELS 6
+#define BENCH_PCINT_FRAMES 500
+#define BENCH_PCINT_FRAME_MICROS 20000
+#define BENCH_PCINT_ISR_LATENCY_MICROS 3
+#define BENCH_PCINT_ISR_MICROS 8
+#define BENCH_PCINT_MICROS_RESOLUTION 4
+#define BENCH_PCINT_DRAIN_MICROS 1000
+#define BENCH_PCINT_QUEUE_SIZE 16
+#define BENCH_PCINT_MAX_ERROR_MICROS (BENCH_PCINT_ISR_LATENCY_MICROS + BENCH_PCINT_ISR_MICROS \
+        + BENCH_PCINT_MICROS_RESOLUTION)
+
+// Signal loss trials: each stops the landing channel at a different phase
+// of the RC frame
+#define BENCH_FAILSAFE_TRIALS 16
+#define BENCH_FAILSAFE_TIMEOUT_MICROS 500000
+
+// Must match eLoopStage in main.cpp
+#define BENCH_LOOP_STAGE_COUNT 12
+
+// Longest wait for a reply (simulated), and attempts per command.  Replies
+// that find the TX buffer full are dropped, so like any host the bench
+// retries (every command is idempotent).
+#define BENCH_SERIAL_TIMEOUT_MICROS 100000
+#define BENCH_SERIAL_ATTEMPTS 3
+
+// Render cost micro benchmark: strip length and frames per measurement
+#define BENCH_RENDER_PIXELS 60
+#define BENCH_RENDER_FRAMES 20000
+#define BENCH_RENDER_PIN 8
+
+// Must match NEO_PIXEL_BRIGHTNESS and PIXEL_POOL_BYTES / PIXEL_BYTES_PER_LED
+// in main.cpp
+#define BENCH_NEO_PIXEL_BRIGHTNESS 12
+#define BENCH_PIXEL_POOL_LEDS (384 / 6)
+
+// Output table at the firmware's brightness (in flash, as the firmware's)
+static const uint16_t bench_lut_table[256] PROGMEM = GAMMA_LUT_TABLE(BENCH_NEO_PIXEL_BRIGHTNESS);
+
+// Strip lengths of the scaling table
+static const uint16_t scaling_pixels[] = { 8, 32, 64, 128, 256, 512, 1024 };
+
+// Animation timebase check: Update() is called on a 100 fps frame clock
+// that stalls (e.g. an EEPROM write) every BENCH_TIMEBASE_STALL_EVERY frames
+#define BENCH_TIMEBASE_MILLIS 10000
+#define BENCH_TIMEBASE_FRAME_MILLIS 10
+#define BENCH_TIMEBASE_STALL_MILLIS 37
+#define BENCH_TIMEBASE_STALL_EVERY 50
+
+// Firmware entry points and state
+void setup();
+void loop();
+void read_eeprom();
+
+bool dispatch_menu_event(eMenuEvent event);
+void handle_rc_bus_frame(const sRcBusFrame *frame, unsigned long frame_end_in_micro_seconds,
+        uint16_t frame_duration_in_micro_seconds);
+
+extern eOperationState operation_state;
+extern Timer<12> timer;
+extern Timer<2, millis, uint32_t> color_timer;
+extern NeoPatterns *all_strips[];
+extern FrameCompositor compositor;
+extern RcFrameScheduler<BENCH_RC_CHANNEL_COUNT> rc_frame_scheduler;
+extern RcSignalMonitor<BENCH_RC_CHANNEL_COUNT> rc_signal_monitor;
+extern SerialFrameParser serial_parser;
+extern uint16_t serial_frames_dropped;
+extern MemoryWatermark memory_watermark;
+extern EepromRecordStore<BENCH_CONFIG_STORE_BASE_ADDRESS, BENCH_CONFIG_STORE_SLOT_COUNT,
+        BENCH_CONFIG_STORE_SLOT_SIZE> config_store;
+#ifdef LOOP_PROFILER
+extern LoopProfiler<BENCH_LOOP_STAGE_COUNT> loop_profiler;
+#endif
+
+static NeoPatterns **strips = all_strips;
+
+static const char *strip_names[BENCH_STRIP_COUNT] = {
+    "port", "stbd", "beacon", "landing"
+};
+
+static const char *state_names[OPERATION_STATE_COUNT] = {
+    "INIT",
+    "CONFIG_MAIN_ON_NAV",
+    "CONFIG_MAIN_ON_STROBE",
+    "CONFIG_MAIN_ON_BEACON",
+    "CONFIG_MAIN_ON_LANDING",
+    "CONFIG_MAIN_ON_FACTORY_RESET",
+    "CONFIG_IN_NAV",
+    "CONFIG_IN_STROBE",
+    "CONFIG_IN_BEACON",
+    "CONFIG_IN_LANDING",
+    "CONFIG_IN_FACTORY_RESET",
+    "NORMAL",
+    "RAINBOW",
+    "CHASE",
+    "FAILSAFE"
+};
+
+#ifdef LOOP_PROFILER
+static const char *loop_stage_names[BENCH_LOOP_STAGE_COUNT] = {
+    "timer",
+    "color_timer",
+    "button",
+    "rc events",
+    "serial",
+    "config states",
+    "frame tick",
+    "running states (render)",
+    "flush",
+    "log",
+    "memory scan",
+    "loop"
+};
+#endif
+
+typedef struct s_state_stats {
+    uint32_t loops;
+    uint64_t micros;
+    uint64_t masked_micros;
+    uint32_t shows_issued;
+    uint32_t shows_skipped;
+    uint32_t bytes[BENCH_STRIP_COUNT];
+} sStateStats;
+
+static sStateStats stats[OPERATION_STATE_COUNT];
+static uint32_t start_late_interrupts;
+
+static void reset_stats()
+{
+    memset(stats, 0, sizeof(stats));
+    compositor.ResetTiming();
+    rc_frame_scheduler.ResetCounters();
+    start_late_interrupts = sim_late_interrupts();
+    #ifdef LOOP_PROFILER
+    loop_profiler.Reset();
+    #endif
+}
+
+// One loop() pass, attributed to the state it started in
+static void run_one_loop()
+{
+    eOperationState state = operation_state;
+    uint64_t start_us = sim_now_micros();
+    uint64_t start_masked_us = sim_masked_micros();
+    uint32_t start_shows = 0;
+    uint32_t start_skipped = 0;
+    uint32_t start_bytes[BENCH_STRIP_COUNT];
+
+    for (int i = 0; i < BENCH_STRIP_COUNT; i++)
+    {
+        start_shows += strips[i]->simShowCount;
+        start_skipped += strips[i]->ShowsSkipped;
+        start_bytes[i] = strips[i]->simBytesPushed;
+    }
+
+    loop();
+    sim_advance_micros(BENCH_LOOP_OVERHEAD_MICROS);
+
+    sStateStats *s = &stats[state];
+    s->loops++;
+    s->micros += sim_now_micros() - start_us;
+    s->masked_micros += sim_masked_micros() - start_masked_us;
+
+    for (int i = 0; i < BENCH_STRIP_COUNT; i++)
+    {
+        s->shows_issued += strips[i]->simShowCount;
+        s->shows_skipped += strips[i]->ShowsSkipped;
+        s->bytes[i] += strips[i]->simBytesPushed - start_bytes[i];
+    }
+    s->shows_issued -= start_shows;
+    s->shows_skipped -= start_skipped;
+}
+
+static void run_for_micros(uint64_t duration_us)
+{
+    uint64_t end_us = sim_now_micros() + duration_us;
+
+    while (sim_now_micros() < end_us)
+    {
+        run_one_loop();
+    }
+}
+
+// Per-stage loop() times in host microseconds (LOOP_PROFILER_CLOCK() is the
+// host's steady clock here): the CPU cost of each stage's code on this
+// machine, without the modelled show() and serial TX blocking, which the
+// rates above account for.  Stages that never ran are left out.
+static void print_loop_profile()
+{
+    #ifdef LOOP_PROFILER
+    printf("  %-26s %9s %6s %8s %6s  histogram <8 <16 <32 <64 <128 <256 <512 more (host us)\n",
+            "stage", "count", "min", "avg", "max");
+
+    for (int i = 0; i < BENCH_LOOP_STAGE_COUNT; i++)
+    {
+        const sLoopStageStats *stage = &loop_profiler.Stage[i];
+
+        if (stage->count == 0)
+        {
+            continue;
+        }
+
+        printf("  %-26s %9u %6u %8.2f %6u ", loop_stage_names[i], stage->count,
+                stage->min_micro_seconds, (double)stage->total_micro_seconds / stage->count,
+                stage->max_micro_seconds);
+        for (int bucket = 0; bucket < LOOP_PROFILER_BUCKETS; bucket++)
+        {
+            printf(" %u", stage->histogram[bucket]);
+        }
+        printf("\n");
+    }
+    #endif // LOOP_PROFILER
+}
+
+static void print_stats(const char *scenario)
+{
+    printf("\n%s\n", scenario);
+    printf("  %-28s %7s %9s %8s %8s", "state", "time s", "loops/s", "show/s", "skip/s");
+    for (int i = 0; i < BENCH_STRIP_COUNT; i++)
+    {
+        printf(" %7s B/s", strip_names[i]);
+    }
+    printf(" %8s\n", "irq-off%");
+
+    for (int state = 0; state < OPERATION_STATE_COUNT; state++)
+    {
+        const sStateStats *s = &stats[state];
+
+        if (s->loops == 0 || s->micros == 0)
+        {
+            continue;
+        }
+
+        double seconds = s->micros / 1e6;
+
+        printf("  %-28s %7.2f %9.0f %8.1f %8.1f", state_names[state],
+                seconds, s->loops / seconds, s->shows_issued / seconds, s->shows_skipped / seconds);
+        for (int i = 0; i < BENCH_STRIP_COUNT; i++)
+        {
+            printf(" %11.0f", s->bytes[i] / seconds);
+        }
+        printf(" %8.2f\n", 100.0 * s->masked_micros / s->micros);
+    }
+
+    const sFrameTiming *t = &compositor.Timing;
+
+    if (t->frames > 0)
+    {
+        printf("  frames %u (dropped %u), render avg/max %.2f/%u host us, flush avg/max %u/%u us\n",
+                t->frames, t->frames_dropped,
+                (double)t->render_total_micro_seconds / t->frames, t->render_max_micro_seconds,
+                t->flush_total_micro_seconds / t->frames, t->flush_max_micro_seconds);
+    }
+
+    printf("  shows deferred %u, collisions avoided %u, forced %u, unscheduled %u, late interrupts %u\n",
+            rc_frame_scheduler.ShowsDeferred, rc_frame_scheduler.CollisionsAvoided,
+            rc_frame_scheduler.ShowsForced, rc_frame_scheduler.ShowsUnscheduled,
+            sim_late_interrupts() - start_late_interrupts);
+
+    print_loop_profile();
+}
+
+// RainbowCycleUpdate() as it was before the PROGMEM wheel table: a 16-bit
+// division per pixel plus the branching Wheel().  Kept for comparison only.
+static uint32_t legacy_wheel(byte WheelPos)
+{
+    WheelPos = 255 - WheelPos;
+    if (WheelPos < 85)
+    {
+        return Adafruit_NeoPixel::Color(255 - WheelPos * 3, 0, WheelPos * 3);
+    }
+    else if (WheelPos < 170)
+    {
+        WheelPos -= 85;
+        return Adafruit_NeoPixel::Color(0, WheelPos * 3, 255 - WheelPos * 3);
+    }
+    WheelPos -= 170;
+    return Adafruit_NeoPixel::Color(WheelPos * 3, 255 - WheelPos * 3, 0);
+}
+
+static void legacy_rainbow_cycle_update(NeoPatterns *strip)
+{
+    for (int i = 0; i < (int)strip->numPixels(); i++)
+    {
+        strip->setPixelColor(i, legacy_wheel(((i * 256 / strip->numPixels()) + strip->Index) & 255));
+    }
+    strip->show();
+    strip->Increment();
+}
+
+// ScannerUpdate() as it was before DimPixel(): the tail is read back
+// through getPixelColor(), which undoes the strip's brightness scaling on
+// already quantized bytes.  Kept for comparison only.
+static void legacy_scanner_update(NeoPatterns *strip)
+{
+    for (int i = 0; i < (int)strip->numPixels(); i++)
+    {
+        if (i == (int)strip->Index || i == (int)(strip->TotalSteps - strip->Index))
+        {
+            strip->setPixelColor(i, strip->Color1);
+        }
+        else
+        {
+            strip->setPixelColor(i, strip->DimColor(strip->getPixelColor(i)));
+        }
+    }
+    strip->show();
+    strip->Increment();
+}
+
+static void scanner_update(NeoPatterns *strip)
+{
+    strip->ScannerUpdate();
+}
+
+// Pixels lit in what a strip sends: the wire buffer of a strip with an
+// output stage, else the (brightness scaled) pixel buffer
+static uint16_t lit_pixels(NeoPatterns *strip)
+{
+    const uint8_t *frame = (strip->WireBuffer != NULL) ? strip->WireBuffer : strip->getPixels();
+    uint16_t lit = 0;
+
+    for (uint16_t i = 0; i < strip->numPixels(); i++)
+    {
+        if (frame[3 * i] != 0 || frame[3 * i + 1] != 0 || frame[3 * i + 2] != 0)
+        {
+            lit++;
+        }
+    }
+
+    return lit;
+}
+
+// Host time per pixel for one frame of a pattern update
+static double render_nanos_per_pixel(NeoPatterns *strip, void (*update)(NeoPatterns *))
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < BENCH_RENDER_FRAMES; frame++)
+    {
+        update(strip);
+    }
+
+    double nanos = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+
+    return nanos / ((double)BENCH_RENDER_FRAMES * strip->numPixels());
+}
+
+static void rainbow_cycle_update(NeoPatterns *strip)
+{
+    strip->RainbowCycleUpdate();
+}
+
+// Host time per pixel of the gamma/brightness output stage alone
+static double output_nanos_per_pixel(NeoPatterns *strip)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < BENCH_RENDER_FRAMES; frame++)
+    {
+        strip->RenderOutput();
+    }
+
+    double nanos = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+
+    return nanos / ((double)BENCH_RENDER_FRAMES * strip->numPixels());
+}
+
+static void print_render_costs()
+{
+    NeoPatterns strip(BENCH_RENDER_PIXELS, BENCH_RENDER_PIN, NEO_GRB + NEO_KHZ800, NULL);
+
+    strip.begin();
+    strip.RainbowCycle(3);
+
+    double legacy_ns = render_nanos_per_pixel(&strip, legacy_rainbow_cycle_update);
+    double current_ns = render_nanos_per_pixel(&strip, rainbow_cycle_update);
+
+    printf("\nRender cost, %d pixel strip (host ns per pixel, includes show() bookkeeping)\n",
+            BENCH_RENDER_PIXELS);
+    printf("  %-28s %8.2f\n", "RainbowCycle (legacy div)", legacy_ns);
+    printf("  %-28s %8.2f  (%.2fx)\n", "RainbowCycle (wheel table)", current_ns, legacy_ns / current_ns);
+
+    // Render and wire buffers laid out by the caller, as the firmware does
+    static uint8_t output_render[BENCH_RENDER_PIXELS * 3];
+    static uint8_t output_wire[BENCH_RENDER_PIXELS * 3];
+    NeoPatterns output_strip(output_render, sizeof(output_render), BENCH_RENDER_PIXELS, BENCH_RENDER_PIN,
+            NEO_GRB + NEO_KHZ800, NULL);
+    GammaLut lut(bench_lut_table);
+
+    output_strip.SetBuffers(output_render, output_wire, sizeof(output_render));
+    output_strip.begin();
+    output_strip.SetOutputLut(&lut);
+    output_strip.RainbowCycle(3);
+    output_strip.RainbowCycleUpdate();
+
+    printf("  %-28s %8.2f\n", "Gamma LUT output", output_nanos_per_pixel(&output_strip));
+
+    strip.Scanner(0xFF0000, 10);
+    legacy_ns = render_nanos_per_pixel(&strip, legacy_scanner_update);
+    current_ns = render_nanos_per_pixel(&strip, scanner_update);
+    printf("  %-28s %8.2f\n", "Scanner (getPixelColor tail)", legacy_ns);
+    printf("  %-28s %8.2f  (%.2fx)\n", "Scanner (DimPixel tail)", current_ns, legacy_ns / current_ns);
+
+    // Scanner tail at the firmware's brightness, as sent to the LEDs: the
+    // output stage's wire buffer after the step's flush (and lit in any
+    // frame of the dither cycle that follows), against a strip scaled by
+    // setBrightness() whose tail dims in its own quantized buffer
+    uint16_t lit_cycle = 0;
+
+    output_strip.SetOutputLut(&lut);
+    output_strip.Scanner(0xFF0000, 10);
+    strip.setBrightness(BENCH_NEO_PIXEL_BRIGHTNESS);
+    strip.clear();
+    strip.Scanner(0xFF0000, 10);
+    for (int step = 0; step < BENCH_RENDER_PIXELS / 2; step++)
+    {
+        output_strip.ScannerUpdate();
+        legacy_scanner_update(&strip);
+    }
+
+    uint16_t lit_flushed = lit_pixels(&output_strip);
+    uint8_t tail[BENCH_RENDER_PIXELS * 3];
+
+    memset(tail, 0, sizeof(tail));
+    for (uint8_t frame = 0; frame < GAMMA_LUT_DITHER_STEPS; frame++)
+    {
+        for (uint16_t i = 0; i < sizeof(tail); i++)
+        {
+            tail[i] |= output_wire[i];
+        }
+        output_strip.Flush();
+    }
+    for (uint16_t i = 0; i < BENCH_RENDER_PIXELS; i++)
+    {
+        if (tail[3 * i] != 0 || tail[3 * i + 1] != 0 || tail[3 * i + 2] != 0)
+        {
+            lit_cycle++;
+        }
+    }
+    printf("  Scanner tail at brightness %d: %u lit pixels on the wire (%u over a dither cycle), "
+            "%u brightness scaled\n", BENCH_NEO_PIXEL_BRIGHTNESS, lit_flushed, lit_cycle, lit_pixels(&strip));
+
+    // Flash taken by the pattern table itself; the hooks it points at are
+    // listed by name with avr-nm --size-sort on the firmware
+    printf("\nPattern registry: %d patterns, %u byte descriptors, %u bytes of table (host pointers)\n",
+            PATTERN_COUNT - 1, (unsigned)sizeof(sPatternDescriptor), (unsigned)sizeof(NeoPatternsRegistry));
+}
+
+// Serial protocol loopback: frames go in through the simulated RX pin and
+// replies are picked out of the captured TX output (which also carries the
+// log frames) by the same parser the firmware uses
+static SerialFrameParser host_parser;
+static int check_failures = 0;
+
+static void serial_send(uint8_t type, const void *payload, uint8_t length)
+{
+    uint8_t buffer[SERIAL_FRAME_MAX_SIZE];
+
+    sim_serial_inject(buffer, serial_frame_encode(buffer, type, payload, length));
+}
+
+// Run loop() until a frame of the given type comes back.  Returns false on
+// timeout.
+static bool serial_wait_for(uint8_t type, sSerialFrame *reply)
+{
+    uint64_t end_us = sim_now_micros() + BENCH_SERIAL_TIMEOUT_MICROS;
+    uint8_t output[256];
+
+    while (sim_now_micros() < end_us)
+    {
+        run_one_loop();
+
+        size_t n = sim_serial_take_output(output, sizeof(output));
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (host_parser.Feed(output[i]) && host_parser.Frame.type == type)
+            {
+                *reply = host_parser.Frame;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Send a command until a frame of reply_type comes back
+static bool serial_request(uint8_t type, const void *payload, uint8_t length,
+        uint8_t reply_type, sSerialFrame *reply)
+{
+    for (int attempt = 0; attempt < BENCH_SERIAL_ATTEMPTS; attempt++)
+    {
+        serial_send(type, payload, length);
+        if (serial_wait_for(reply_type, reply))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void check(const char *name, bool ok)
+{
+    printf("  %-52s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok)
+    {
+        check_failures++;
+    }
+}
+
+static void run_serial_loopback()
+{
+    sSerialFrame reply;
+    uint8_t config[BENCH_CONFIG_RECORD_SIZE];
+    uint8_t original[BENCH_CONFIG_RECORD_SIZE];
+
+    printf("\nSerial protocol loopback\n");
+    sim_serial_capture(true);
+
+    check("GET_CONFIG returns the config record",
+            serial_request(BENCH_SERIAL_GET_CONFIG, NULL, 0, BENCH_SERIAL_CONFIG, &reply)
+            && reply.length == BENCH_CONFIG_RECORD_SIZE);
+    memcpy(original, reply.payload, sizeof(original));
+
+    // Change the nav segment count (strobe right after it) and read it back
+    memcpy(config, original, sizeof(config));
+    config[BENCH_CONFIG_NAV_LED_SEGMENT_COUNT] = (original[BENCH_CONFIG_NAV_LED_SEGMENT_COUNT] == 1) ? 2 : 1;
+    config[BENCH_CONFIG_STROBE_LED_SEGMENT_START_INDEX] = config[BENCH_CONFIG_NAV_LED_SEGMENT_COUNT];
+    check("SET_CONFIG is acknowledged",
+            serial_request(BENCH_SERIAL_SET_CONFIG, config, sizeof(config), BENCH_SERIAL_ACK, &reply)
+            && reply.payload[0] == BENCH_SERIAL_SET_CONFIG);
+    check("GET_CONFIG returns the new config",
+            serial_request(BENCH_SERIAL_GET_CONFIG, NULL, 0, BENCH_SERIAL_CONFIG, &reply)
+            && memcmp(reply.payload, config, sizeof(config)) == 0);
+    check("nav strips resized", strips[0]->numPixels() == (uint16_t)(config[0] + config[1]));
+
+    config[BENCH_CONFIG_NAV_LED_SEGMENT_COUNT] = 0;
+    check("SET_CONFIG with an invalid config is refused",
+            serial_request(BENCH_SERIAL_SET_CONFIG, config, sizeof(config), BENCH_SERIAL_NAK, &reply)
+            && reply.payload[1] == BENCH_SERIAL_NAK_BAD_VALUE);
+
+    // Long segments are fine while both nav strips, beacon and landing
+    // lights fit in the pixel pool
+    memcpy(config, original, sizeof(config));
+    config[BENCH_CONFIG_NAV_LED_SEGMENT_COUNT] = (BENCH_PIXEL_POOL_LEDS - config[BENCH_CONFIG_BEACON_LED_SEGMENT_COUNT]
+            - config[BENCH_CONFIG_LANDING_LED_SEGMENT_COUNT]) / 2 - config[BENCH_CONFIG_STROBE_LED_SEGMENT_COUNT];
+    config[BENCH_CONFIG_STROBE_LED_SEGMENT_START_INDEX] = config[BENCH_CONFIG_NAV_LED_SEGMENT_COUNT];
+    check("SET_CONFIG with the longest nav segment that fits",
+            serial_request(BENCH_SERIAL_SET_CONFIG, config, sizeof(config), BENCH_SERIAL_ACK, &reply)
+            && strips[0]->numPixels() == (uint16_t)(config[0] + config[1]));
+
+    config[BENCH_CONFIG_NAV_LED_SEGMENT_COUNT]++;
+    config[BENCH_CONFIG_STROBE_LED_SEGMENT_START_INDEX]++;
+    check("SET_CONFIG over the pixel pool is refused",
+            serial_request(BENCH_SERIAL_SET_CONFIG, config, sizeof(config), BENCH_SERIAL_NAK, &reply)
+            && reply.payload[1] == BENCH_SERIAL_NAK_BAD_VALUE);
+
+    // An extra segment two LEDs past the landing lights lengthens the strip
+    // and is drawn in its role's color
+    memcpy(config, original, sizeof(config));
+    config[BENCH_CONFIG_EXTRA_SEGMENT + 0] = BENCH_STRIP_MASK_LANDING;
+    config[BENCH_CONFIG_EXTRA_SEGMENT + 1] = config[BENCH_CONFIG_LANDING_LED_SEGMENT_COUNT] + 2;
+    config[BENCH_CONFIG_EXTRA_SEGMENT + 2] = 1;
+    config[BENCH_CONFIG_EXTRA_SEGMENT + 3] = BENCH_SEGMENT_ROLE_NAV;
+    check("SET_CONFIG with a non-contiguous extra segment",
+            serial_request(BENCH_SERIAL_SET_CONFIG, config, sizeof(config), BENCH_SERIAL_ACK, &reply)
+            && strips[3]->numPixels() == (uint16_t)(config[BENCH_CONFIG_LANDING_LED_SEGMENT_COUNT] + 3));
+    run_for_micros(50000);
+    check("extra segment drawn, gap left dark",
+            strips[3]->getPixelColor(config[BENCH_CONFIG_EXTRA_SEGMENT + 1]) == Adafruit_NeoPixel::Color(0, 255, 0)
+            && strips[3]->getPixelColor(config[BENCH_CONFIG_LANDING_LED_SEGMENT_COUNT]) == 0);
+
+    config[BENCH_CONFIG_EXTRA_SEGMENT + 3] = 0xFF;
+    check("SET_CONFIG with an unknown segment role is refused",
+            serial_request(BENCH_SERIAL_SET_CONFIG, config, sizeof(config), BENCH_SERIAL_NAK, &reply)
+            && reply.payload[1] == BENCH_SERIAL_NAK_BAD_VALUE);
+
+    check("original config restored",
+            serial_request(BENCH_SERIAL_SET_CONFIG, original, sizeof(original), BENCH_SERIAL_ACK, &reply));
+
+    // Corrupted frame: dropped by the firmware, then a good one goes through
+    uint8_t buffer[SERIAL_FRAME_MAX_SIZE];
+    uint8_t size = serial_frame_encode(buffer, BENCH_SERIAL_GET_STATUS, NULL, 0);
+    uint16_t crc_errors = serial_parser.CrcErrors;
+
+    buffer[size - 1] ^= 0xFF;
+    sim_serial_inject(buffer, size);
+    check("corrupted frame dropped, next one answered",
+            serial_request(BENCH_SERIAL_GET_STATUS, NULL, 0, BENCH_SERIAL_STATUS, &reply)
+            && reply.length == BENCH_STATUS_REPORT_SIZE
+            && serial_parser.CrcErrors == crc_errors + 1);
+
+    // Mode switching without a receiver
+    uint8_t mode = 1;
+    check("SET_MODE RAINBOW",
+            serial_request(BENCH_SERIAL_SET_MODE, &mode, 1, BENCH_SERIAL_ACK, &reply)
+            && operation_state == OPERATION_STATE_RAINBOW);
+    mode = 0;
+    check("SET_MODE NAV",
+            serial_request(BENCH_SERIAL_SET_MODE, &mode, 1, BENCH_SERIAL_ACK, &reply)
+            && operation_state == OPERATION_STATE_NORMAL);
+
+    // With the receiver's mode switch connected it stays in control
+    sim_set_pwm_input(BENCH_NAV_DISPLAY_MODE_PIN, 1000, BENCH_RC_FRAME_MICROS);
+    run_for_micros(BENCH_SETTLE_MICROS);
+    mode = 2;
+    check("SET_MODE refused while the RC switch is live",
+            serial_request(BENCH_SERIAL_SET_MODE, &mode, 1, BENCH_SERIAL_NAK, &reply)
+            && reply.payload[1] == BENCH_SERIAL_NAK_RC_OVERRIDE);
+    sim_set_pwm_input(BENCH_NAV_DISPLAY_MODE_PIN, 0);
+    run_for_micros(BENCH_SETTLE_MICROS);
+
+    // Disconnecting it is a signal loss, given up on with a long click
+    check("SET_MODE refused in failsafe",
+            serial_request(BENCH_SERIAL_SET_MODE, &mode, 1, BENCH_SERIAL_NAK, &reply)
+            && reply.payload[1] == BENCH_SERIAL_NAK_BUSY);
+    dispatch_menu_event(MENU_EVENT_LONG_CLICK);
+
+    // Status stream at 10 Hz: ten reports, none more than one interval late
+    uint16_t interval = 100;
+    int reports = 0;
+
+    serial_request(BENCH_SERIAL_STREAM_STATUS, &interval, sizeof(interval), BENCH_SERIAL_ACK, &reply);
+    for (int i = 0; i < 10; i++)
+    {
+        if (serial_wait_for(BENCH_SERIAL_STATUS, &reply) || serial_wait_for(BENCH_SERIAL_STATUS, &reply))
+        {
+            reports++;
+        }
+    }
+    interval = 0;
+    serial_request(BENCH_SERIAL_STREAM_STATUS, &interval, sizeof(interval), BENCH_SERIAL_ACK, &reply);
+    check("STREAM_STATUS sends a report every 100ms", reports == 10);
+
+    #ifdef LOOP_PROFILER
+    uint8_t stage = BENCH_LOOP_STAGE_COUNT - 1;
+    check("GET_PROFILE returns the stage's stats",
+            serial_request(BENCH_SERIAL_GET_PROFILE, &stage, 1, BENCH_SERIAL_PROFILE, &reply)
+            && reply.length == 1 + sizeof(sLoopStageStats) && reply.payload[0] == stage);
+    #endif
+
+    check("GET_MEMORY returns the memory status",
+            serial_request(BENCH_SERIAL_GET_MEMORY, NULL, 0, BENCH_SERIAL_MEMORY, &reply)
+            && reply.length == sizeof(sMemoryStatus));
+
+    printf("  firmware: frames %u, crc errors %u, length errors %u, replies dropped %u, rx overruns %u\n",
+            serial_parser.FramesReceived, serial_parser.CrcErrors, serial_parser.LengthErrors,
+            serial_frames_dropped, sim_serial_rx_overruns());
+
+    sim_serial_capture(false);
+}
+
+typedef EepromRecordStore<BENCH_STORE_BASE_ADDRESS, BENCH_STORE_SLOT_COUNT,
+        BENCH_STORE_SLOT_SIZE> BenchRecordStore;
+
+// Rotation and brown-out recovery on a scratch store, then an older
+// version of the firmware's config record read back through read_eeprom()
+static void run_config_store_check()
+{
+    BenchRecordStore store;
+    BenchRecordStore loader;
+    uint32_t record = 0;
+    uint8_t version = 0;
+    uint8_t length;
+    bool in_order = true;
+
+    printf("\nConfig record store\n");
+
+    // More saves than slots: every slot is overwritten at least once
+    store.Erase();
+    for (uint32_t i = 1; i <= BENCH_STORE_SAVES; i++)
+    {
+        store.Save(&i, sizeof(i), 1);
+    }
+
+    length = loader.Load(&record, sizeof(record), &version);
+    check("load after wrapping the slots returns the newest",
+            length == sizeof(record) && record == BENCH_STORE_SAVES && version == 1
+            && loader.Slot == store.Slot);
+
+    // A brown-out in the middle of the newest save: its CRC no longer matches
+    uint16_t crc_address = BENCH_STORE_BASE_ADDRESS + (uint16_t)store.Slot * BENCH_STORE_SLOT_SIZE
+            + sizeof(BenchRecordStore::sSlot) - sizeof(uint16_t);
+
+    EEPROM.write(crc_address, EEPROM.read(crc_address) ^ 0xFF);
+    record = 0;
+    length = loader.Load(&record, sizeof(record), &version);
+    check("corrupt newest slot falls back to the previous one",
+            length == sizeof(record) && record == BENCH_STORE_SAVES - 1);
+
+    // The next save goes over the bad slot, and the records stay in order
+    record = BENCH_STORE_SAVES + 1;
+    loader.Save(&record, sizeof(record), 1);
+    for (uint32_t i = BENCH_STORE_SAVES + 2; i < BENCH_STORE_SAVES + 2 + BENCH_STORE_SLOT_COUNT; i++)
+    {
+        BenchRecordStore reader;
+
+        loader.Save(&i, sizeof(i), 1);
+        in_order &= (reader.Load(&record, sizeof(record), &version) == sizeof(record) && record == i);
+    }
+    check("saves after the fallback replace the bad slot", in_order);
+
+    // A version 3 record (no bus channels) saved over a current one whose
+    // bus channels differ from the defaults
+    uint8_t original[BENCH_CONFIG_RECORD_SIZE];
+    uint8_t current[BENCH_CONFIG_RECORD_SIZE];
+    uint8_t migrated[BENCH_CONFIG_RECORD_SIZE];
+
+    check("firmware config record loads",
+            config_store.Load(original, sizeof(original), &version) == sizeof(original)
+            && version == BENCH_CONFIG_RECORD_VERSION);
+
+    memcpy(current, original, sizeof(current));
+    current[BENCH_CONFIG_RC_BUS_CHANNELS + BENCH_RC_CHANNEL_LANDING_LED] = BENCH_DEFAULT_NAV_DISPLAY_MODE_BUS_CHANNEL;
+    current[BENCH_CONFIG_RC_BUS_CHANNELS + BENCH_RC_CHANNEL_NAV_DISPLAY_MODE] = BENCH_DEFAULT_LANDING_LED_BUS_CHANNEL;
+    config_store.Save(current, sizeof(current), BENCH_CONFIG_RECORD_VERSION);
+
+    current[BENCH_CONFIG_FAILSAFE_PATTERN] = BENCH_FAILSAFE_PATTERN_NAV;
+    config_store.Save(current, BENCH_CONFIG_RECORD_V3_SIZE, BENCH_CONFIG_RECORD_VERSION - 1);
+
+    read_eeprom();
+
+    memset(migrated, 0, sizeof(migrated));
+    length = config_store.Load(migrated, sizeof(migrated), &version);
+    check("older record is saved again in the current layout",
+            length == BENCH_CONFIG_RECORD_SIZE && version == BENCH_CONFIG_RECORD_VERSION);
+    check("migrated record keeps the stored fields",
+            memcmp(migrated, current, BENCH_CONFIG_RECORD_V3_SIZE) == 0);
+    check("migrated record has the default bus channels",
+            migrated[BENCH_CONFIG_RC_BUS_CHANNELS + BENCH_RC_CHANNEL_LANDING_LED] == BENCH_DEFAULT_LANDING_LED_BUS_CHANNEL
+            && migrated[BENCH_CONFIG_RC_BUS_CHANNELS + BENCH_RC_CHANNEL_NAV_DISPLAY_MODE]
+                    == BENCH_DEFAULT_NAV_DISPLAY_MODE_BUS_CHANNEL);
+
+    // Back to the config the run started with
+    config_store.Save(original, sizeof(original), BENCH_CONFIG_RECORD_VERSION);
+    read_eeprom();
+}
+
+// Run loop() until operation_state is state.  Returns false on timeout.
+static bool run_until_state(eOperationState state, uint64_t timeout_us)
+{
+    uint64_t end_us = sim_now_micros() + timeout_us;
+
+    while (operation_state != state)
+    {
+        if (sim_now_micros() >= end_us)
+        {
+            return false;
+        }
+        run_one_loop();
+    }
+
+    return true;
+}
+
+// Signal loss: with the receiver on in nav mode, stop the landing channel
+// at a different point of the RC frame in each trial and time how long the
+// firmware takes to switch to failsafe, from the last pulse it saw and from
+// the first pulse that did not come.  Expects the default failsafe pattern
+// (strobe).  Leaves the receiver off and the lost channels forgotten.
+static void run_failsafe_check()
+{
+    uint32_t min_us = UINT32_MAX;
+    uint32_t max_us = 0;
+    uint64_t total_us = 0;
+    uint32_t max_after_missing_us = 0;
+    uint8_t detected = 0;
+    uint8_t restored = 0;
+    bool strobing = false;
+
+    printf("\nRC signal loss, %u us RC frames (%d trials)\n", BENCH_RC_FRAME_MICROS, BENCH_FAILSAFE_TRIALS);
+
+    sim_set_pwm_input(BENCH_NAV_DISPLAY_MODE_PIN, 1000, BENCH_RC_FRAME_MICROS);
+    sim_set_pwm_input(BENCH_LANDING_LED_TOGGLE_PIN, 2000, BENCH_RC_FRAME_MICROS, 2500);
+    run_for_micros(BENCH_SETTLE_MICROS);
+
+    for (int trial = 0; trial < BENCH_FAILSAFE_TRIALS; trial++)
+    {
+        run_for_micros(BENCH_RC_FRAME_MICROS * trial / BENCH_FAILSAFE_TRIALS);
+        sim_set_pwm_input(BENCH_LANDING_LED_TOGGLE_PIN, 0);
+
+        if (!run_until_state(OPERATION_STATE_FAILSAFE, BENCH_FAILSAFE_TIMEOUT_MICROS))
+        {
+            continue;
+        }
+
+        uint32_t latency_us = micros()
+                - rc_signal_monitor.Channel[BENCH_RC_CHANNEL_LANDING_LED].last_pulse_in_micro_seconds;
+
+        detected++;
+        total_us += latency_us;
+        min_us = (latency_us < min_us) ? latency_us : min_us;
+        max_us = (latency_us > max_us) ? latency_us : max_us;
+        if (latency_us - BENCH_RC_FRAME_MICROS > max_after_missing_us)
+        {
+            max_after_missing_us = latency_us - BENCH_RC_FRAME_MICROS;
+        }
+
+        // Every strip flashes white
+        for (uint64_t end_us = sim_now_micros() + 300000; sim_now_micros() < end_us && !strobing; )
+        {
+            run_one_loop();
+            strobing = true;
+            for (int i = 0; i < BENCH_STRIP_COUNT; i++)
+            {
+                strobing = strobing && strips[i]->getPixelColor(strips[i]->numPixels() - 1) == 0xFFFFFF;
+            }
+        }
+
+        sim_set_pwm_input(BENCH_LANDING_LED_TOGGLE_PIN, 2000, BENCH_RC_FRAME_MICROS, 2500);
+        if (run_until_state(OPERATION_STATE_NORMAL, BENCH_FAILSAFE_TIMEOUT_MICROS))
+        {
+            restored++;
+        }
+    }
+
+    if (detected > 0)
+    {
+        printf("  detected after the last pulse: min %u us, avg %u us, max %u us (%.2f RC frames)\n",
+                min_us, (uint32_t)(total_us / detected), max_us, (double)max_us / BENCH_RC_FRAME_MICROS);
+        printf("  detected after the first missing pulse: max %u us (%.2f RC frames)\n",
+                max_after_missing_us, (double)max_after_missing_us / BENCH_RC_FRAME_MICROS);
+    }
+
+    check("every loss detected", detected == BENCH_FAILSAFE_TRIALS);
+    check("within 2 RC frames of the first missing pulse",
+            detected > 0 && max_after_missing_us <= 2 * BENCH_RC_FRAME_MICROS);
+    check("failsafe strobes every strip white", strobing);
+    check("back to nav lights when the signal returns", restored == BENCH_FAILSAFE_TRIALS);
+
+    // Receiver off: failsafe until a long click gives up on the channels
+    sim_set_pwm_input(BENCH_NAV_DISPLAY_MODE_PIN, 0);
+    sim_set_pwm_input(BENCH_LANDING_LED_TOGGLE_PIN, 0);
+    check("receiver off enters failsafe", run_until_state(OPERATION_STATE_FAILSAFE, BENCH_FAILSAFE_TIMEOUT_MICROS));
+    dispatch_menu_event(MENU_EVENT_LONG_CLICK);
+    run_for_micros(BENCH_FAILSAFE_TIMEOUT_MICROS);
+    check("long click leaves failsafe for good", operation_state == OPERATION_STATE_NORMAL);
+    printf("  channels lost so far %u\n", rc_signal_monitor.LossCount);
+}
+
+static const uint16_t bench_detent_boundaries[] = { 1250, 1750 };
+static const sRcDetentMap bench_detents = {
+    bench_detent_boundaries, 2, BENCH_RC_DETENT_HYSTERESIS
+};
+
+typedef RcPwmDecoder<1> BenchPwmDecoder;
+
+// One servo pulse: a rising edge at *t, a falling edge width later.
+// Moves *t on a frame.  Returns what the falling edge returned.
+static bool pwm_pulse(BenchPwmDecoder *decoder, uint32_t *t, uint16_t width)
+{
+    bool accepted;
+
+    decoder->AddEdge(0, *t);
+    accepted = decoder->AddEdge(0, *t + width);
+    *t += BENCH_RC_PWM_PERIOD_MICROS;
+
+    return accepted;
+}
+
+// RcPwmDecoder on synthetic edge trains: validation, the median filter,
+// glitch runs, hysteresis at a detent boundary and micros() wraparound
+static void run_rc_decoder_check()
+{
+    BenchPwmDecoder clean(BENCH_RC_MIN_PULSE_WIDTH, BENCH_RC_MAX_PULSE_WIDTH, BENCH_RC_PULSE_FILTER_SHIFT);
+    BenchPwmDecoder chatter(BENCH_RC_MIN_PULSE_WIDTH, BENCH_RC_MAX_PULSE_WIDTH, BENCH_RC_PULSE_FILTER_SHIFT);
+    BenchPwmDecoder wrap(BENCH_RC_MIN_PULSE_WIDTH, BENCH_RC_MAX_PULSE_WIDTH, BENCH_RC_PULSE_FILTER_SHIFT);
+    uint32_t t = 1000;
+    bool ok;
+
+    printf("\nRC PWM decoder (synthetic edge trains)\n");
+
+    clean.SetDetentMap(0, &bench_detents);
+    chatter.SetDetentMap(0, &bench_detents);
+    wrap.SetDetentMap(0, &bench_detents);
+
+    // Clean train: valid on the RC_PWM_VALID_PULSE_COUNT'th pulse
+    ok = true;
+    for (uint8_t i = 1; i < RC_PWM_VALID_PULSE_COUNT; i++)
+    {
+        ok = ok && pwm_pulse(&clean, &t, 1000) && !clean.IsValid(0);
+    }
+    ok = ok && pwm_pulse(&clean, &t, 1000) && clean.IsValid(0);
+    check("clean train valid after RC_PWM_VALID_PULSE_COUNT", ok);
+    check("clean train decodes width and position", clean.PulseWidth(0) == 1000 && clean.Position(0) == 0);
+
+    // Single in-range spikes to 2000 every third pulse: the median of three
+    // never lets one through
+    uint16_t min_width = 0xFFFF;
+    uint16_t max_width = 0;
+
+    ok = true;
+    for (uint8_t i = 0; i < BENCH_RC_PWM_TRAIN_PULSES; i++)
+    {
+        pwm_pulse(&clean, &t, (i % 3 == 2) ? 2000 : 1000);
+        ok = ok && clean.IsValid(0) && clean.Position(0) == 0;
+        min_width = (clean.PulseWidth(0) < min_width) ? clean.PulseWidth(0) : min_width;
+        max_width = (clean.PulseWidth(0) > max_width) ? clean.PulseWidth(0) : max_width;
+    }
+    printf("  width with single-sample spikes: %u..%u us\n", min_width, max_width);
+    check("median filter rejects single-sample glitches", ok && min_width == 1000 && max_width == 1000);
+
+    // Runs of pulses too short to be servo pulses
+    ok = true;
+    for (uint8_t i = 1; i < RC_PWM_INVALID_PULSE_COUNT; i++)
+    {
+        ok = ok && !pwm_pulse(&clean, &t, 300) && clean.IsValid(0);
+    }
+    check("short pulses below RC_PWM_INVALID_PULSE_COUNT tolerated", ok);
+    check("run of short pulses invalidates the channel", !pwm_pulse(&clean, &t, 300) && !clean.IsValid(0));
+    for (uint8_t i = 0; i < RC_PWM_VALID_PULSE_COUNT; i++)
+    {
+        pwm_pulse(&clean, &t, 1000);
+    }
+    check("channel valid again after good pulses", clean.IsValid(0) && clean.PulseWidth(0) == 1000);
+
+    // Chatter either side of the 1750 boundary, inside the hysteresis band:
+    // the position holds whichever side it came from
+    uint8_t changes = 0;
+    uint8_t position;
+
+    for (uint8_t i = 0; i < RC_PWM_VALID_PULSE_COUNT; i++)
+    {
+        pwm_pulse(&chatter, &t, 1500);
+    }
+    position = chatter.Position(0);
+    for (uint8_t i = 0; i < BENCH_RC_PWM_TRAIN_PULSES; i++)
+    {
+        pwm_pulse(&chatter, &t, (i & 1) ? 1830 : 1670);
+        changes += (chatter.Position(0) != position) ? 1 : 0;
+    }
+    check("chatter below the band keeps position 1", position == 1 && changes == 0);
+
+    for (uint8_t i = 0; i < BENCH_RC_PWM_TRAIN_PULSES; i++)
+    {
+        pwm_pulse(&chatter, &t, 1950);
+    }
+    position = chatter.Position(0);
+    for (uint8_t i = 0; i < BENCH_RC_PWM_TRAIN_PULSES; i++)
+    {
+        pwm_pulse(&chatter, &t, (i & 1) ? 1830 : 1670);
+        changes += (chatter.Position(0) != position) ? 1 : 0;
+    }
+    check("chatter above the band keeps position 2", position == 2 && changes == 0);
+
+    for (uint8_t i = 0; i < BENCH_RC_PWM_TRAIN_PULSES; i++)
+    {
+        pwm_pulse(&chatter, &t, 1550);
+    }
+    check("leaving the band moves the position", chatter.Position(0) == 1);
+
+    // A pulse whose edges straddle 0xFFFFFFFF
+    bool straddled = false;
+
+    t = 0xFFFFFFFFUL - 699 - RC_PWM_VALID_PULSE_COUNT * BENCH_RC_PWM_PERIOD_MICROS;
+    for (uint8_t i = 0; i < 2 * RC_PWM_VALID_PULSE_COUNT; i++)
+    {
+        uint32_t rise = t;
+
+        ok = pwm_pulse(&wrap, &t, 1500);
+        if (rise > 0xFFFFFFFFUL - 1500)
+        {
+            straddled = ok && wrap.RawPulseWidth(0) == 1500;
+        }
+    }
+    check("pulse straddling micros() wraparound decodes", straddled);
+    check("train across wraparound stays valid", wrap.IsValid(0) && wrap.PulseWidth(0) == 1500
+            && wrap.Position(0) == 1);
+}
+
+// Receiver recordings.  SBUS: the second half of a frame (the parser must
+// not take the 0x0F in it for a start), a frame, a frame flagged failsafe
+// and frame lost, a frame with a bad end byte, a frame lost while the
+// parser finds its feet again, and a last frame.
+static const uint8_t sbus_recording[] = {
+    0xC4, 0xC1, 0x37, 0x71, 0xBC, 0x82, 0x0F, 0x7C, 0xAC, 0xA0, 0x0F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0,
+    0x81, 0x6F, 0xE2, 0x00, 0x00,
+    0x0F, 0xE0, 0x63, 0xC5, 0xC4, 0xC1, 0x37, 0x71, 0xBC, 0x82, 0x0F, 0x7C, 0xAC, 0xA0, 0x0F, 0xF8,
+    0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x6F, 0xE2, 0x00, 0x00,
+    0x0F, 0xE0, 0x63, 0xC5, 0xC4, 0xC1, 0x37, 0x71, 0xBC, 0x82, 0x0F, 0x7C, 0xAC, 0xA0, 0x0F, 0xF8,
+    0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x6F, 0xE2, 0x0C, 0x00,
+    0x0F, 0xE0, 0x63, 0xC5, 0xC4, 0xC1, 0x37, 0x71, 0xBC, 0x82, 0x0F, 0x7C, 0xAC, 0xA0, 0x0F, 0xF8,
+    0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x6F, 0xE2, 0x00, 0x55,
+    0x0F, 0xE0, 0x63, 0xC5, 0xC4, 0xC1, 0x37, 0x71, 0xBC, 0x82, 0x0F, 0x7C, 0xAC, 0xA0, 0x0F, 0xF8,
+    0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x6F, 0xE2, 0x00, 0x00,
+    0x0F, 0xE0, 0x63, 0xC5, 0xC4, 0xC1, 0x37, 0x71, 0xBC, 0x82, 0x0F, 0x7C, 0xAC, 0xA0, 0x0F, 0xF8,
+    0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x6F, 0xE2, 0x00, 0x00
+};
+
+// What every good SBUS frame above carries (raw 992, 172, 1811, ...)
+static const uint16_t sbus_channels[RC_BUS_MAX_CHANNELS] = {
+    1500, 987, 2011, 1500, 2011, 1755, 1500, 1500, 987, 1192, 1500, 1500, 1500, 1500, 1500, 2011
+};
+
+// iBUS: noise, a frame, the same frame with a bad checksum, the frame again
+static const uint8_t ibus_recording[] = {
+    0x40, 0x20, 0x20, 0x41,
+    0x20, 0x40, 0xDC, 0x05, 0xE8, 0x03, 0xD0, 0x07, 0xDC, 0x05, 0xD0, 0x07, 0xD6, 0x06, 0xDC, 0x05,
+    0xDC, 0x05, 0xE8, 0x03, 0xB0, 0x04, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0xD0, 0x07, 0x8D, 0xF3,
+    0x20, 0x40, 0xDC, 0x05, 0xE8, 0x03, 0xD0, 0x07, 0xDC, 0x05, 0xD0, 0x07, 0xD6, 0x06, 0xDC, 0x05,
+    0xDC, 0x05, 0xE8, 0x03, 0xB0, 0x04, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0xD0, 0x07, 0x8D, 0xF4,
+    0x20, 0x40, 0xDC, 0x05, 0xE8, 0x03, 0xD0, 0x07, 0xDC, 0x05, 0xD0, 0x07, 0xD6, 0x06, 0xDC, 0x05,
+    0xDC, 0x05, 0xE8, 0x03, 0xB0, 0x04, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0xD0, 0x07, 0x8D, 0xF3
+};
+
+static const uint16_t ibus_channels[RC_IBUS_CHANNELS] = {
+    1500, 1000, 2000, 1500, 2000, 1750, 1500, 1500, 1000, 1200, 1500, 1500, 1500, 2000
+};
+
+// PPM: micro seconds between rising edges of an 8 channel, 22.5ms frame
+// signal, starting mid frame (skipped up to the first sync gap).  The
+// fourth frame has a 150 us glitch in its second channel.
+static const uint16_t ppm_recording[] = {
+    1100, 1900, 1500, 1500, 10000,
+    1500, 1000, 2000, 1500, 1100, 1900, 1500, 1500, 10000,
+    1500, 1000, 2000, 1500, 1100, 1900, 1500, 1500, 10000,
+    1500, 150, 850, 2000, 1500, 1100, 1900, 1500, 1500, 10000,
+    1500, 1000, 2000, 1500, 1100, 1900, 1500, 1500, 10000
+};
+
+static const uint16_t ppm_channels[] = { 1500, 1000, 2000, 1500, 1100, 1900, 1500, 1500 };
+
+static bool bus_frame_matches(const sRcBusFrame *frame, const uint16_t *channels, uint8_t count)
+{
+    return frame->channel_count == count && memcmp(frame->channels, channels, count * sizeof(channels[0])) == 0;
+}
+
+// Feed the firmware count bus frames, one every BENCH_RC_BUS_FRAME_MICROS
+static void feed_bus_frames(const sRcBusFrame *frame, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        handle_rc_bus_frame(frame, micros(), BENCH_RC_BUS_FRAME_DURATION_MICROS);
+        run_for_micros(BENCH_RC_BUS_FRAME_MICROS);
+    }
+}
+
+// Single pin receiver input: the parsers on the recordings above (every
+// good frame decoded, every bad one dropped), then frames of channels fed
+// to the firmware, whose functions follow the channels rc_bus_channels
+// gives them.  Leaves the receiver off and the lost channels forgotten.
+static void run_rc_bus_check()
+{
+    SbusParser sbus;
+    IbusParser ibus;
+    PpmDecoder ppm;
+    uint8_t good = 0;
+    uint8_t failsafe = 0;
+    uint32_t edge_time = 0;
+
+    printf("\nReceiver bus decoders (recorded streams)\n");
+
+    for (size_t i = 0; i < sizeof(sbus_recording); i++)
+    {
+        if (sbus.Feed(sbus_recording[i]))
+        {
+            good += bus_frame_matches(&sbus.Frame, sbus_channels, RC_BUS_MAX_CHANNELS) ? 1 : 0;
+            failsafe += sbus.Frame.failsafe ? 1 : 0;
+        }
+    }
+    printf("  SBUS: %u frames, %u errors, %u reported lost\n", sbus.FramesReceived, sbus.FrameErrors, sbus.FramesLost);
+    check("SBUS frames decoded, bad end byte dropped",
+            sbus.FramesReceived == 3 && good == 3 && sbus.FrameErrors == 1);
+    check("SBUS failsafe flag", failsafe == 1 && sbus.FramesLost == 1);
+
+    good = 0;
+    for (size_t i = 0; i < sizeof(ibus_recording); i++)
+    {
+        if (ibus.Feed(ibus_recording[i]))
+        {
+            good += bus_frame_matches(&ibus.Frame, ibus_channels, RC_IBUS_CHANNELS) ? 1 : 0;
+        }
+    }
+    printf("  iBUS: %u frames, %u errors\n", ibus.FramesReceived, ibus.FrameErrors);
+    check("iBUS frames decoded, bad checksum dropped",
+            ibus.FramesReceived == 2 && good == 2 && ibus.FrameErrors == 1);
+
+    good = 0;
+    ppm.AddEdge(edge_time);
+    for (size_t i = 0; i < sizeof(ppm_recording) / sizeof(ppm_recording[0]); i++)
+    {
+        edge_time += ppm_recording[i];
+        if (ppm.AddEdge(edge_time))
+        {
+            good += bus_frame_matches(&ppm.Frame, ppm_channels, sizeof(ppm_channels) / sizeof(ppm_channels[0]))
+                    && ppm.FrameEnd - ppm.FrameStart == 12000 ? 1 : 0;
+        }
+    }
+    printf("  PPM: %u frames, %u errors\n", ppm.FramesReceived, ppm.FrameErrors);
+    check("PPM frames decoded, glitched frame dropped",
+            ppm.FramesReceived == 3 && good == 3 && ppm.FrameErrors == 1);
+
+    printf("  parser RAM: SBUS %u B, iBUS %u B, PPM %u B (host)\n",
+            (unsigned)sizeof(sbus), (unsigned)sizeof(ibus), (unsigned)sizeof(ppm));
+
+    // The functions follow their assigned channels: display mode on 6 by
+    // default, then on 3, then on none
+    sSerialFrame reply;
+    uint8_t config[BENCH_CONFIG_RECORD_SIZE];
+    uint8_t original[BENCH_CONFIG_RECORD_SIZE];
+    sRcBusFrame frame;
+
+    for (int i = 0; i < RC_BUS_MAX_CHANNELS; i++)
+    {
+        frame.channels[i] = 1500;
+    }
+    frame.channels[2] = 2000;
+    frame.channel_count = RC_BUS_MAX_CHANNELS;
+    frame.failsafe = false;
+
+    sim_serial_capture(true);
+    serial_request(BENCH_SERIAL_GET_CONFIG, NULL, 0, BENCH_SERIAL_CONFIG, &reply);
+    memcpy(original, reply.payload, sizeof(original));
+
+    feed_bus_frames(&frame, 5);
+    check("display mode from bus channel 6 (rainbow)", operation_state == OPERATION_STATE_RAINBOW);
+
+    memcpy(config, original, sizeof(config));
+    config[BENCH_CONFIG_RC_BUS_CHANNELS + BENCH_RC_CHANNEL_NAV_DISPLAY_MODE] = 2;
+    serial_request(BENCH_SERIAL_SET_CONFIG, config, sizeof(config), BENCH_SERIAL_ACK, &reply);
+    feed_bus_frames(&frame, 5);
+    check("display mode moved to bus channel 3 (chase)", operation_state == OPERATION_STATE_CHASE);
+
+    config[BENCH_CONFIG_RC_BUS_CHANNELS + BENCH_RC_CHANNEL_NAV_DISPLAY_MODE] = 0xFF;
+    serial_request(BENCH_SERIAL_SET_CONFIG, config, sizeof(config), BENCH_SERIAL_ACK, &reply);
+    feed_bus_frames(&frame, 20);
+    check("unassigned display mode left alone, not lost",
+            operation_state == OPERATION_STATE_NORMAL && rc_signal_monitor.LostMask == 0);
+
+    config[BENCH_CONFIG_RC_BUS_CHANNELS + BENCH_RC_CHANNEL_NAV_DISPLAY_MODE] = RC_BUS_MAX_CHANNELS;
+    check("SET_CONFIG with a channel past the frame is refused",
+            serial_request(BENCH_SERIAL_SET_CONFIG, config, sizeof(config), BENCH_SERIAL_NAK, &reply)
+            && reply.payload[1] == BENCH_SERIAL_NAK_BAD_VALUE);
+
+    // Frames flagged failsafe by the receiver count as no signal
+    frame.failsafe = true;
+    feed_bus_frames(&frame, 10);
+    check("receiver failsafe frames end in failsafe", operation_state == OPERATION_STATE_FAILSAFE);
+    dispatch_menu_event(MENU_EVENT_LONG_CLICK);
+
+    serial_request(BENCH_SERIAL_SET_CONFIG, original, sizeof(original), BENCH_SERIAL_ACK, &reply);
+    sim_serial_capture(false);
+}
+
+// Pin change frames: every channel rises at the start of the frame (some
+// frames a couple of us apart), and the widths make the falls land
+// together, in pairs, a few us apart or spread out
+static uint16_t pcint_width(uint32_t frame, uint8_t channel)
+{
+    switch (frame % 4)
+    {
+        case 0:
+            return 1500;
+        case 1:
+            return 1000 + (channel / 2) * 400 + frame % 7;
+        case 2:
+            return 1200 + channel * 3 + frame % 50;
+        default:
+            return 1000 + (frame * 37 + channel * 211) % 1001;
+    }
+}
+
+static uint8_t pcint_rise_offset(uint32_t frame, uint8_t channel)
+{
+    return (frame % 4 == 2) ? channel * 2 : 0;
+}
+
+static uint8_t pcint_levels(uint32_t t)
+{
+    uint32_t frame = t / BENCH_PCINT_FRAME_MICROS;
+    uint32_t phase = t % BENCH_PCINT_FRAME_MICROS;
+    uint8_t levels = 0;
+
+    for (uint8_t i = 0; i < BENCH_PCINT_CHANNELS; i++)
+    {
+        uint32_t rise = pcint_rise_offset(frame, i);
+
+        if (phase >= rise && phase < rise + pcint_width(frame, i))
+        {
+            levels |= (1 << i);
+        }
+    }
+
+    return levels;
+}
+
+// Pin change input capture: the port's levels go through a model of the
+// pin change interrupt (a change sets the flag, the ISR reads the port
+// after its entry latency and cannot run again until it has returned) into
+// the firmware's sample queue and decoder, and every decoded width is
+// checked against the width generated
+static void run_pin_change_check()
+{
+    EventQueue<BENCH_PCINT_QUEUE_SIZE> queue;
+    PinChangeDecoder decoder((1 << BENCH_PCINT_CHANNELS) - 1);
+    uint32_t end = BENCH_PCINT_FRAMES * BENCH_PCINT_FRAME_MICROS;
+    uint8_t levels = 0;
+    uint8_t isr_levels = 0;
+    bool flag = false;
+    bool isr_entered = false;
+    uint32_t isr_read = 0;
+    uint32_t isr_free = 0;
+    uint32_t edge_times = 0;
+    uint32_t edges = 0;
+    uint32_t isrs = 0;
+    uint32_t samples = 0;
+    uint32_t pulses = 0;
+    uint32_t bad_pulses = 0;
+    uint32_t max_error = 0;
+    uint64_t total_error = 0;
+    uint8_t max_depth = 0;
+
+    printf("\nPin change input capture (%u channels, ISR modelled: %u us latency, %u us run, %u us micros())\n",
+            BENCH_PCINT_CHANNELS, BENCH_PCINT_ISR_LATENCY_MICROS, BENCH_PCINT_ISR_MICROS,
+            BENCH_PCINT_MICROS_RESOLUTION);
+
+    decoder.Begin(levels);
+
+    for (uint32_t t = 0; t < end; t++)
+    {
+        uint8_t now_levels = pcint_levels(t);
+
+        if (now_levels != levels)
+        {
+            for (uint8_t changed = now_levels ^ levels; changed != 0; changed &= changed - 1)
+            {
+                edges++;
+            }
+            edge_times++;
+            levels = now_levels;
+            flag = true;
+        }
+
+        // The flag is cleared as the vector is taken; later edges set it again
+        if (flag && !isr_entered && t >= isr_free)
+        {
+            flag = false;
+            isr_entered = true;
+            isr_read = t + BENCH_PCINT_ISR_LATENCY_MICROS;
+        }
+
+        if (isr_entered && t == isr_read)
+        {
+            uint32_t timestamp = t - t % BENCH_PCINT_MICROS_RESOLUTION;
+
+            if (levels != isr_levels)
+            {
+                isr_levels = levels;
+                queue.Push(levels, timestamp);
+                samples++;
+            }
+            isrs++;
+            isr_entered = false;
+            isr_free = t + BENCH_PCINT_ISR_MICROS;
+        }
+
+        if (t % BENCH_PCINT_DRAIN_MICROS == BENCH_PCINT_DRAIN_MICROS - 1)
+        {
+            sEvent event;
+            uint8_t depth = (queue.Head - queue.Tail) & (BENCH_PCINT_QUEUE_SIZE - 1);
+
+            if (depth > max_depth)
+            {
+                max_depth = depth;
+            }
+
+            while (queue.Pop(&event))
+            {
+                uint8_t complete = decoder.AddSample(event.type, event.timestamp_in_micro_seconds);
+                uint32_t frame = event.timestamp_in_micro_seconds / BENCH_PCINT_FRAME_MICROS;
+
+                for (uint8_t i = 0; i < BENCH_PCINT_CHANNELS; i++)
+                {
+                    if ((complete & (1 << i)) == 0)
+                    {
+                        continue;
+                    }
+
+                    uint16_t expected = pcint_width(frame, i);
+                    uint32_t error = (decoder.Width[i] > expected)
+                            ? decoder.Width[i] - expected : expected - decoder.Width[i];
+
+                    pulses++;
+                    total_error += error;
+                    if (error > max_error)
+                    {
+                        max_error = error;
+                    }
+                    if (error > BENCH_PCINT_MAX_ERROR_MICROS)
+                    {
+                        bad_pulses++;
+                    }
+                }
+            }
+        }
+    }
+
+    printf("  %u frames: %u edges at %u distinct times, %u ISRs, %u samples (%.1f per frame), queue depth max %u\n",
+            BENCH_PCINT_FRAMES, edges, edge_times, isrs, samples, (double)samples / BENCH_PCINT_FRAMES, max_depth);
+    printf("  %u pulses decoded, width error mean %.2f us, max %u us (bound %u us)\n",
+            pulses, pulses ? (double)total_error / pulses : 0.0, max_error, BENCH_PCINT_MAX_ERROR_MICROS);
+
+    check("pin change: every pulse decoded", pulses == (uint32_t)BENCH_PCINT_FRAMES * BENCH_PCINT_CHANNELS);
+    check("pin change: widths within one ISR of the edges", bad_pulses == 0);
+    check("pin change: simultaneous edges share a sample", samples < edges);
+    check("pin change: no samples dropped", queue.Dropped == 0);
+}
+
+// Frame cost against strip length: host time to render a RainbowCycle
+// frame and run the output stage, and the modelled flush (interrupts masked
+// for the whole transfer), which bounds the frame rate a strip can reach
+static void print_strip_scaling()
+{
+    GammaLut lut(bench_lut_table);
+
+    printf("\nFrame cost against strip length (render/output host us, flush modelled on AVR)\n");
+    printf("  %8s %10s %10s %10s %8s %10s\n", "pixels", "render", "output", "flush", "max fps", "RAM bytes");
+
+    for (uint8_t i = 0; i < sizeof(scaling_pixels) / sizeof(scaling_pixels[0]); i++)
+    {
+        uint16_t pixels = scaling_pixels[i];
+        uint8_t *render = new uint8_t[pixels * 3];
+        uint8_t *wire = new uint8_t[pixels * 3];
+        NeoPatterns strip(render, pixels * 3, pixels, BENCH_RENDER_PIN, NEO_GRB + NEO_KHZ800, NULL);
+
+        strip.SetBuffers(render, wire, pixels * 3);
+        strip.begin();
+        strip.SetOutputLut(&lut);
+        strip.RainbowCycle(3);
+
+        double render_ns = render_nanos_per_pixel(&strip, rainbow_cycle_update) * pixels;
+        double output_ns = output_nanos_per_pixel(&strip) * pixels;
+
+        strip.MarkDirty();
+        uint16_t flush_micros = strip.FlushMicros();
+
+        printf("  %8u %10.2f %10.2f %10u %8.0f %10u\n", pixels, render_ns / 1000.0, output_ns / 1000.0,
+                flush_micros, 1e6 / flush_micros, strip.RenderBufferBytes() + strip.WireBufferBytes());
+
+        delete[] render;
+        delete[] wire;
+    }
+}
+
+// Output byte of a color byte through Adafruit_NeoPixel::setBrightness()
+// alone, the way the strips were driven before the output stage
+static uint8_t legacy_brightness_level(uint8_t value)
+{
+    return (value * (BENCH_NEO_PIXEL_BRIGHTNESS + 1)) >> 8;
+}
+
+// Set every byte of the strip to value, as a pattern redrawing it would
+static void fill_strip_bytes(NeoPatterns *strip, uint8_t value)
+{
+    for (uint16_t i = 0; i < strip->numPixels(); i++)
+    {
+        strip->setPixelColor(i, value, value, value);
+    }
+}
+
+// While a strip's pixels change the output stage dithers the fraction
+// below one output step, so the mean over a dither cycle tracks the gamma
+// level; once they stop it rounds them once and does not resend them
+static void run_output_stage_check()
+{
+    static uint8_t render[BENCH_RENDER_PIXELS * 3];
+    static uint8_t wire[BENCH_RENDER_PIXELS * 3];
+    static const uint8_t sample_values[] = { 31, 63, 100, 127 };
+    NeoPatterns strip(render, sizeof(render), BENCH_RENDER_PIXELS, BENCH_RENDER_PIN, NEO_GRB + NEO_KHZ800, NULL);
+    GammaLut lut(bench_lut_table);
+    double max_error = 0;
+    bool seen_legacy[256] = { false };
+    bool seen_dithered[4 * 256] = { false };
+    uint16_t legacy_levels = 0;
+    uint16_t dithered_levels = 0;
+
+    printf("\nOutput stage (brightness %d)\n", BENCH_NEO_PIXEL_BRIGHTNESS);
+
+    strip.SetBuffers(render, wire, sizeof(render));
+    strip.begin();
+    strip.SetOutputLut(&lut);
+
+    check("full scale maps to the brightness, black to 0",
+            lut.Apply(255) == BENCH_NEO_PIXEL_BRIGHTNESS && lut.Apply(0) == 0);
+
+    // Every color byte, redrawn for one dither cycle
+    printf("  %6s %8s %8s %8s %8s\n", "value", "legacy", "gamma", "rounded", "dithered");
+    for (uint16_t value = 0; value < 256; value++)
+    {
+        uint16_t sum = 0;
+
+        for (uint8_t frame = 0; frame < GAMMA_LUT_DITHER_STEPS; frame++)
+        {
+            fill_strip_bytes(&strip, value);
+            strip.Flush();
+            sum += wire[0];
+        }
+
+        double exact = lut.Level(value) / 256.0;
+        double dithered = (double)sum / GAMMA_LUT_DITHER_STEPS;
+
+        if (fabs(dithered - exact) > max_error)
+        {
+            max_error = fabs(dithered - exact);
+        }
+
+        if (!seen_legacy[legacy_brightness_level(value)])
+        {
+            seen_legacy[legacy_brightness_level(value)] = true;
+            legacy_levels++;
+        }
+        if (!seen_dithered[sum])
+        {
+            seen_dithered[sum] = true;
+            dithered_levels++;
+        }
+
+        for (uint8_t i = 0; i < sizeof(sample_values); i++)
+        {
+            if (value == sample_values[i])
+            {
+                printf("  %6u %8u %8.2f %8u %8.2f\n", value, legacy_brightness_level(value), exact,
+                        lut.Apply(value), dithered);
+            }
+        }
+    }
+    printf("  distinct levels: %u brightness scaled, %u dithered\n", legacy_levels, dithered_levels);
+
+    #if GAMMA_LUT_DITHER_FRAMES > 0
+    check("dithered mean within a quarter step of the level", max_error < 0.25);
+    check("dither gives more levels than brightness scaling", dithered_levels > legacy_levels);
+    #endif
+
+    // 0x40 is 84/256ths of a step at this brightness
+    uint32_t issued;
+
+    fill_strip_bytes(&strip, 0x40);
+    for (uint8_t frame = 0; frame <= GAMMA_LUT_DITHER_FRAMES; frame++)
+    {
+        strip.Flush();
+    }
+    issued = strip.ShowsIssued;
+    for (uint8_t i = 0; i < 100; i++)
+    {
+        strip.Flush();
+    }
+    check("static frame rounded once and then not resent",
+            strip.ShowsIssued == issued && strip.FlushMicros() == 0 && wire[0] == lut.Apply(0x40));
+
+    strip.setPixelColor(0, 0xFFFFFF);
+    strip.Flush();
+    check("changed frame resent", strip.ShowsIssued == issued + 1 && wire[0] == BENCH_NEO_PIXEL_BRIGHTNESS);
+}
+
+static uint32_t timebase_completions;
+
+static void timebase_on_complete()
+{
+    timebase_completions++;
+}
+
+// Steps the strip's pattern took over the timebase run, with Update() or
+// with the timebase it had before (lastUpdate = now, one step per call).
+// *last_millis is the run time of the last call.
+static uint32_t timebase_run(NeoPatterns *strip, bool legacy, unsigned long *last_millis)
+{
+    void (*update)(NeoPatterns *) = (void (*)(NeoPatterns *))pgm_read_ptr(&strip->ActivePattern->update);
+    unsigned long start = strip->lastUpdate + strip->Interval;
+    unsigned long legacy_last = strip->lastUpdate;
+    unsigned long t = 0;
+    uint16_t frames = 0;
+
+    timebase_completions = 0;
+    while (t <= BENCH_TIMEBASE_MILLIS)
+    {
+        unsigned long now = start + t;
+
+        if (!legacy)
+        {
+            strip->Update(now);
+        }
+        else if ((now - legacy_last) > strip->Interval)
+        {
+            legacy_last = now;
+            update(strip);
+        }
+
+        *last_millis = t;
+        t += BENCH_TIMEBASE_FRAME_MILLIS;
+        if (++frames % BENCH_TIMEBASE_STALL_EVERY == 0)
+        {
+            t += BENCH_TIMEBASE_STALL_MILLIS;
+        }
+    }
+
+    return timebase_completions * strip->TotalSteps + strip->Index;
+}
+
+static void check_timebase(const char *name, NeoPatterns *strip, pattern type, uint8_t interval, timebase policy)
+{
+    unsigned long last_millis = 0;
+
+    strip->Timebase = policy;
+    strip->Start(type, interval, 0x00FF00, 0x0000FF, 100);
+    uint32_t legacy_steps = timebase_run(strip, true, &last_millis);
+    strip->Start(type, interval, 0x00FF00, 0x0000FF, 100);
+    uint32_t steps = timebase_run(strip, false, &last_millis);
+    uint32_t expected = last_millis / interval + 1;  // the first step is due at Start()
+
+    printf("  %-28s %8u %8u %8u  %s\n", name, expected, legacy_steps, steps, (steps == expected) ? "ok" : "FAIL");
+    if (steps != expected)
+    {
+        check_failures++;
+    }
+}
+
+static void run_timebase_check()
+{
+    NeoPatterns strip(BENCH_RENDER_PIXELS, BENCH_RENDER_PIN, NEO_GRB + NEO_KHZ800, timebase_on_complete);
+
+    strip.begin();
+    printf("\nAnimation timebase, %d ms frames with a %d ms stall every %d (steps in %.1f s)\n",
+            BENCH_TIMEBASE_FRAME_MILLIS, BENCH_TIMEBASE_STALL_MILLIS, BENCH_TIMEBASE_STALL_EVERY,
+            BENCH_TIMEBASE_MILLIS / 1000.0);
+    printf("  %-28s %8s %8s %8s\n", "pattern", "expected", "legacy", "steps");
+    check_timebase("RainbowCycle 3 ms, skip", &strip, RAINBOW_CYCLE, 3, SKIP_STEPS);
+    check_timebase("TheaterChase 15 ms, skip", &strip, THEATER_CHASE, 15, SKIP_STEPS);
+    check_timebase("Fade 7 ms, catch up", &strip, FADE, 7, CATCH_UP);
+    check_timebase("ColorWipe 20 ms, draws all", &strip, COLOR_WIPE, 20, SKIP_STEPS);
+}
+
+// Take every row of menu_transitions from its state: the dispatcher must
+// land in the row's next state and show its indicator on the first port
+// nav LED, at once or (actions that blink it) within a second.  Changes
+// the config, so it runs last.
+static void run_menu_transition_check()
+{
+    static const char *event_names[MENU_EVENT_COUNT] = { "click", "long click", "timeout" };
+    uint8_t failures = 0;
+
+    printf("\nConfig menu transitions (%u rows, %u bytes on the host)\n",
+            menu_transition_count, (unsigned)(menu_transition_count * sizeof(sMenuTransition)));
+
+    for (uint8_t i = 0; i < menu_transition_count; i++)
+    {
+        sMenuTransition row;
+        bool ok;
+
+        memcpy_P(&row, &menu_transitions[i], sizeof(row));
+
+        timer.cancel();
+        color_timer.cancel();
+        operation_state = (eOperationState)row.state;
+
+        ok = dispatch_menu_event((eMenuEvent)row.event) && operation_state == row.next_state;
+
+        for (int ms = 0; ok && row.indicator != MENU_INDICATOR_NONE
+                && strips[0]->getPixelColor(0) != row.indicator; ms++)
+        {
+            if (ms == 1000)
+            {
+                ok = false;
+                break;
+            }
+            sim_advance_micros(1000);
+            timer.tick();
+            color_timer.tick();
+        }
+
+        if (!ok)
+        {
+            printf("  %s --%s--> %s  FAIL\n", state_names[row.state], event_names[row.event],
+                    state_names[row.next_state]);
+            failures++;
+        }
+    }
+
+    check("every transition reaches its state and indicator", failures == 0);
+
+    // Every config menu state must time out, or the menu could stick
+    // (failsafe ends with the signal or a long click)
+    failures = 0;
+    for (uint8_t state = 0; state < OPERATION_STATE_COUNT; state++)
+    {
+        sMenuTransition row;
+
+        if (state != OPERATION_STATE_INIT && state != OPERATION_STATE_NORMAL
+                && state != OPERATION_STATE_RAINBOW && state != OPERATION_STATE_CHASE
+                && state != OPERATION_STATE_FAILSAFE
+                && !menu_transition_find(menu_transitions, menu_transition_count, state, MENU_EVENT_TIMEOUT, &row))
+        {
+            printf("  %s has no timeout  FAIL\n", state_names[state]);
+            failures++;
+        }
+    }
+    check("every config menu state times out", failures == 0);
+
+    // No row, no change
+    operation_state = OPERATION_STATE_CONFIG_IN_NAV;
+    check("events without a row are ignored",
+            !dispatch_menu_event(MENU_EVENT_LONG_CLICK) && operation_state == OPERATION_STATE_CONFIG_IN_NAV);
+}
+
+// Render and wire buffer bytes of every strip (the NeoPatterns object
+// itself comes on top, and is smaller on AVR than on the host)
+static void print_strip_ram()
+{
+    uint16_t total = 0;
+
+    printf("\nRAM per strip (bytes)\n");
+    printf("  %-10s %8s %8s\n", "strip", "render", "wire");
+    for (int i = 0; i < BENCH_STRIP_COUNT; i++)
+    {
+        printf("  %-10s %8u %8u\n", strip_names[i], strips[i]->RenderBufferBytes(), strips[i]->WireBufferBytes());
+        total += strips[i]->RenderBufferBytes() + strips[i]->WireBufferBytes();
+    }
+    printf("  %-10s %17u\n", "total", total);
+
+    // Only the stand-in's own heap strips allocate, the firmware's use the pool
+    memory_watermark.Scan();
+    printf("  heap after setup() %u B (Adafruit_NeoPixel stand-in, peak %u B)\n",
+            memory_watermark.Status.heap_bytes, memory_watermark.Status.heap_peak_bytes);
+    check("the firmware's strips take no heap", memory_watermark.Status.heap_peak_bytes == 0);
+}
+
+static void run_scenario(const char *scenario, uint64_t duration_us)
+{
+    run_for_micros(BENCH_SETTLE_MICROS);
+    reset_stats();
+    run_for_micros(duration_us);
+    print_stats(scenario);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 5.0;
+    uint64_t duration_us = (uint64_t)(seconds * 1e6);
+
+    if (duration_us == 0)
+    {
+        fprintf(stderr, "usage: %s [seconds per scenario]\n", argv[0]);
+        return 1;
+    }
+
+    printf("NeoPixelRCNavLights native benchmark\n");
+    printf("  %.1f simulated s per scenario, %d us modelled loop overhead\n",
+            seconds, BENCH_LOOP_OVERHEAD_MICROS);
+
+    auto host_start = std::chrono::steady_clock::now();
+
+    setup();
+    print_strip_ram();
+
+    // Receiver on: nav mode, landing lights on
+    sim_set_pwm_input(BENCH_NAV_DISPLAY_MODE_PIN, 1000, BENCH_RC_FRAME_MICROS);
+    sim_set_pwm_input(BENCH_LANDING_LED_TOGGLE_PIN, 2000, BENCH_RC_FRAME_MICROS, 2500);
+    run_scenario("NAV, landing lights on", duration_us);
+
+    sim_set_pwm_input(BENCH_LANDING_LED_TOGGLE_PIN, 1000, BENCH_RC_FRAME_MICROS, 2500);
+    run_scenario("NAV, landing lights off", duration_us);
+
+    sim_set_pwm_input(BENCH_NAV_DISPLAY_MODE_PIN, 1500, BENCH_RC_FRAME_MICROS);
+    run_scenario("RAINBOW", duration_us);
+
+    // Same again with flushes started whenever the frame is due
+    bool (*can_flush)(unsigned long, uint16_t) = compositor.CanFlush;
+    compositor.CanFlush = NULL;
+    run_scenario("RAINBOW, flushes not scheduled around RC pulses", duration_us);
+    compositor.CanFlush = can_flush;
+
+    sim_set_pwm_input(BENCH_NAV_DISPLAY_MODE_PIN, 2000, BENCH_RC_FRAME_MICROS);
+    run_scenario("THEATER CHASE", duration_us);
+
+    // Signal loss, ending with the receiver off
+    run_failsafe_check();
+
+    // Receiver off, configure over the serial port
+    run_for_micros(BENCH_SETTLE_MICROS);
+    run_serial_loopback();
+    run_config_store_check();
+
+    // Every channel through one pin
+    run_rc_decoder_check();
+    run_rc_bus_check();
+    run_pin_change_check();
+
+    // Receiver off, long press into the config menu and let it cycle
+    sim_set_pwm_input(BENCH_NAV_DISPLAY_MODE_PIN, 0);
+    sim_set_pwm_input(BENCH_LANDING_LED_TOGGLE_PIN, 0);
+    reset_stats();
+    sim_set_pin(BENCH_BUTTON_PIN, LOW);
+    run_for_micros(1000000);
+    sim_set_pin(BENCH_BUTTON_PIN, HIGH);
+    run_for_micros(duration_us * 3);
+    print_stats("CONFIG menu (button long press, receiver off)");
+
+    double host_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - host_start).count();
+
+    printf("\nsimulated %.1f s in %.3f host s, %u late interrupts\n",
+            sim_now_micros() / 1e6, host_seconds, sim_late_interrupts());
+
+    print_render_costs();
+    run_output_stage_check();
+    print_strip_scaling();
+    run_timebase_check();
+    run_menu_transition_check();
+
+    return (check_failures > 0) ? 1 : 0;
+}
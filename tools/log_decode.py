@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Decode the nav lights' binary log from the serial port.
+
+The firmware sends its log as LOG frames (see SerialProtocol.h and
+eSerialMessage in src/main.cpp) holding 8 byte sLogRecords.  Record ids and
+their format strings are read from the eLogEvent enum in src/main.cpp, and
+state names from include/OperationState.h, so this tool never needs to be
+edited when events are added.
+
+Usage:
+    log_decode.py /dev/ttyUSB0        read a serial port (needs pyserial)
+    log_decode.py capture.bin         decode a capture
+    log_decode.py -                   decode stdin, e.g.
+        NATIVE_SERIAL_ECHO=1 .pio/build/native/program | tools/log_decode.py -
+"""
+
+import os
+import re
+import string
+import struct
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+
+FRAME_SYNC = 0xA5
+FRAME_MAX_PAYLOAD = 32
+MESSAGE_LOG = 0x86
+BAUD_RATE = 115200
+
+RECORD = struct.Struct('<HBBHH')
+LEVELS = {1: 'ERROR', 2: 'WARN', 3: 'INFO', 4: 'DEBUG'}
+
+
+def read_enum(path, typedef):
+    """Returns [(name, comment)] for the members of a typedef'd enum."""
+    with open(path) as f:
+        source = f.read()
+
+    end = source.index('} ' + typedef + ';')
+    start = source.index('{', source.rindex('typedef enum', 0, end))
+    members = []
+
+    for line in source[start + 1:end].splitlines():
+        match = re.match(r'\s*(\w+)[^/]*(?://\s*(.*))?$', line)
+        if match:
+            members.append((match.group(1), match.group(2) or ''))
+
+    return members
+
+
+def load_events():
+    events = {}
+
+    for event_id, (name, comment) in enumerate(read_enum(os.path.join(ROOT, 'src', 'main.cpp'), 'eLogEvent')):
+        match = re.match(r'"(.*)"', comment)
+        events[event_id] = (name, match.group(1) if match else name)
+
+    return events
+
+
+def load_states():
+    members = read_enum(os.path.join(ROOT, 'include', 'OperationState.h'), 'eOperationState')
+
+    return [name.replace('OPERATION_STATE_', '') for name, _ in members]
+
+
+class RecordFormatter(string.Formatter):
+    """str.format with {n:state} and {n:on_off} conversions."""
+
+    def __init__(self, states):
+        super().__init__()
+        self.states = states
+
+    def format_field(self, value, spec):
+        if spec == 'state':
+            return self.states[value] if value < len(self.states) else 'state %d' % value
+        if spec == 'on_off':
+            return 'on' if value else 'off'
+        return super().format_field(value, spec)
+
+
+def crc16_update(crc, data):
+    """avr-libc _crc_ccitt_update()"""
+    data ^= crc & 0xFF
+    data = (data ^ (data << 4)) & 0xFF
+    return (((data << 8) | (crc >> 8)) ^ (data >> 4) ^ (data << 3)) & 0xFFFF
+
+
+def frames(chunks):
+    """Yields (type, payload) for every valid frame in a byte stream."""
+    buffer = bytearray()
+
+    for chunk in chunks:
+        buffer += chunk
+
+        while True:
+            start = buffer.find(FRAME_SYNC)
+            if start < 0:
+                buffer.clear()
+                break
+            del buffer[:start]
+
+            if len(buffer) < 2:
+                break
+            length = buffer[1]
+            if length > FRAME_MAX_PAYLOAD:
+                del buffer[:1]
+                continue
+            if len(buffer) < length + 5:
+                break
+
+            crc = 0xFFFF
+            for byte in buffer[1:length + 3]:
+                crc = crc16_update(crc, byte)
+
+            if crc == buffer[length + 3] | (buffer[length + 4] << 8):
+                yield buffer[2], bytes(buffer[3:length + 3])
+                del buffer[:length + 5]
+            else:
+                del buffer[:1]
+
+
+def open_input(path):
+    if path == '-':
+        stream = sys.stdin.buffer
+    elif path.startswith('/dev/') or path.upper().startswith('COM'):
+        import serial
+        stream = serial.Serial(path, BAUD_RATE, timeout=0.1)
+    else:
+        stream = open(path, 'rb')
+
+    def chunks():
+        while True:
+            data = stream.read(256) if hasattr(stream, 'in_waiting') else stream.read1(256)
+            if data:
+                yield data
+            elif not hasattr(stream, 'in_waiting'):
+                return
+
+    return chunks()
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write(__doc__)
+        return 1
+
+    events = load_events()
+    formatter = RecordFormatter(load_states())
+    time_base = 0
+    last_time = None
+
+    for message, payload in frames(open_input(argv[1])):
+        if message != MESSAGE_LOG:
+            continue
+
+        for offset in range(0, len(payload) - RECORD.size + 1, RECORD.size):
+            time, event_id, level, arg0, arg1 = RECORD.unpack_from(payload, offset)
+
+            # Records carry the low 16 bits of millis(), in order
+            if last_time is not None and time < last_time:
+                time_base += 0x10000
+            last_time = time
+
+            name, text = events.get(event_id, ('id %d' % event_id, 'args {0} {1}'))
+            try:
+                text = formatter.format(text, arg0, arg1)
+            except (IndexError, KeyError, ValueError):
+                text = '%s %d %d' % (name, arg0, arg1)
+
+            print('%10.3f %-5s %s' % ((time_base + time) / 1000.0, LEVELS.get(level, level), text))
+            sys.stdout.flush()
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
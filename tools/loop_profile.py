@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Dump the loop profiler of a LOOP_PROFILER build over the serial port.
+
+Asks for every stage of eLoopStage (src/main.cpp) with GET_PROFILE and
+prints count, min/avg/max and the histogram in microseconds.
+
+Usage:
+    loop_profile.py /dev/ttyUSB0 [--reset]
+"""
+
+import os
+import struct
+import sys
+import time
+
+from log_decode import BAUD_RATE, FRAME_SYNC, ROOT, crc16_update, frames, read_enum
+
+MESSAGE_ACK = 0xF0
+MESSAGE_NAK = 0xF1
+MESSAGE_GET_PROFILE = 0x07
+MESSAGE_RESET_PROFILE = 0x08
+MESSAGE_PROFILE = 0x87
+
+BUCKET_LIMITS = ['<8', '<16', '<32', '<64', '<128', '<256', '<512', 'more']
+STATS = struct.Struct('<IIHH%dH' % len(BUCKET_LIMITS))
+
+TIMEOUT_SECONDS = 0.5
+
+
+def encode(message, payload=b''):
+    body = bytes([len(payload), message]) + payload
+    crc = 0xFFFF
+    for byte in body:
+        crc = crc16_update(crc, byte)
+    return bytes([FRAME_SYNC]) + body + bytes([crc & 0xFF, crc >> 8])
+
+
+def request(port, message, payload, reply_types):
+    """Send a command and return the first reply of one of reply_types."""
+    port.reset_input_buffer()
+    port.write(encode(message, payload))
+    deadline = time.monotonic() + TIMEOUT_SECONDS
+
+    def chunks():
+        while time.monotonic() < deadline:
+            yield port.read(64)
+
+    for reply, data in frames(chunks()):
+        if reply in reply_types:
+            return reply, data
+
+    return None, None
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write(__doc__)
+        return 1
+
+    import serial
+    port = serial.Serial(argv[1], BAUD_RATE, timeout=0.05)
+    stages = [name.replace('LOOP_STAGE_', '').lower()
+              for name, _ in read_enum(os.path.join(ROOT, 'src', 'main.cpp'), 'eLoopStage')
+              if name != 'LOOP_STAGE_COUNT']
+
+    if '--reset' in argv[2:]:
+        reply, _ = request(port, MESSAGE_RESET_PROFILE, b'', (MESSAGE_ACK, MESSAGE_NAK))
+        print('reset' if reply == MESSAGE_ACK else 'reset failed (not a LOOP_PROFILER build?)')
+        return 0 if reply == MESSAGE_ACK else 1
+
+    print('%-18s %9s %6s %8s %6s  %s' % ('stage', 'count', 'min', 'avg', 'max', ' '.join(BUCKET_LIMITS)))
+
+    for index, name in enumerate(stages):
+        reply, data = request(port, MESSAGE_GET_PROFILE, bytes([index]), (MESSAGE_PROFILE, MESSAGE_NAK))
+        if reply != MESSAGE_PROFILE:
+            print('%-18s no reply (not a LOOP_PROFILER build?)' % name)
+            return 1
+
+        count, total, low, high, *histogram = STATS.unpack(data[1:1 + STATS.size])
+        if count == 0:
+            print('%-18s %9d' % (name, 0))
+            continue
+
+        print('%-18s %9d %6d %8.2f %6d  %s' % (name, count, low, total / count, high,
+                                              ' '.join(str(n) for n in histogram)))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))